@@ -0,0 +1,151 @@
+#include "AsyncStatusQueue.h"
+
+#include "Metrics.h"
+#include "PrinterSession.h"
+#include "PrinterStatus.h"
+
+using namespace std;
+
+AsyncStatusQueue::AsyncStatusQueue(size_t workers)
+    : nextId_(0), pool_(workers)
+{
+}
+
+AsyncStatusQueue& AsyncStatusQueue::instance()
+{
+    static AsyncStatusQueue* queue = new AsyncStatusQueue(8);
+    return *queue;
+}
+
+unsigned int AsyncStatusQueue::submit(const char* ipAddress, const char* printerModel, StatusKind kind, StatusCallback callback, void* userData)
+{
+    if (ipAddress == NULL || printerModel == NULL || callback == NULL || kind < 0 || kind >= STATUS_KIND_COUNT)
+    {
+        return 0;
+    }
+    string key(ipAddress);
+    key += '|';
+    key += printerModel;
+    key += '|';
+    key += to_string((int)kind);
+
+    Waiter waiter;
+    waiter.callback = callback;
+    waiter.userData = userData;
+    bool start = false;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (++nextId_ == 0)
+        {
+            ++nextId_;
+        }
+        waiter.id = nextId_;
+        shared_ptr<Flight>& flight = flights_[key];
+        if (!flight)
+        {
+            flight = make_shared<Flight>();
+            flight->ipAddress = ipAddress;
+            flight->printerModel = printerModel;
+            flight->kind = kind;
+            flight->submitted = chrono::steady_clock::now();
+            start = true;
+        }
+        else
+        {
+            Metrics::instance().increment(METRIC_ASYNC_COALESCED);
+        }
+        flight->waiters.push_back(waiter);
+        requests_[waiter.id] = key;
+    }
+    if (start)
+    {
+        pool_.post([this, key]() { run(key); });
+    }
+    return waiter.id;
+}
+
+bool AsyncStatusQueue::cancel(unsigned int requestId)
+{
+    lock_guard<mutex> lock(mutex_);
+    map<unsigned int, string>::iterator request = requests_.find(requestId);
+    if (request == requests_.end())
+    {
+        return false;
+    }
+    map<string, shared_ptr<Flight> >::iterator flight = flights_.find(request->second);
+    if (flight != flights_.end())
+    {
+        vector<Waiter>& waiters = flight->second->waiters;
+        for (size_t i = 0; i < waiters.size(); i++)
+        {
+            if (waiters[i].id == requestId)
+            {
+                waiters.erase(waiters.begin() + i);
+                break;
+            }
+        }
+    }
+    requests_.erase(request);
+    Metrics::instance().increment(METRIC_ASYNC_CANCELLED);
+    return true;
+}
+
+void AsyncStatusQueue::run(const string& key)
+{
+    shared_ptr<Flight> flight;
+    {
+        lock_guard<mutex> lock(mutex_);
+        flight = flights_[key];
+        if (flight->waiters.empty())
+        {
+            // Tutte le richieste annullate prima della partenza: nessuna chiamata all'SDK
+            flights_.erase(key);
+            return;
+        }
+    }
+
+    shared_ptr<const string> xml;
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_ERROR;
+    try
+    {
+        PrinterSession& session = PrinterSession::instance();
+        result = session.init();
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            result = HPLFPSDK::Types::RESULT_ERROR_LIBRARY_NOT_INITIALIZED;
+        }
+        else
+        {
+            result = readPrinterStatus(flight->ipAddress.c_str(), flight->printerModel.c_str(), flight->kind, session.readyTimeout(), xml);
+        }
+    }
+    catch (exception)
+    {
+        result = HPLFPSDK::Types::RESULT_ERROR;
+    }
+
+    // Da qui le richieste non sono piu' annullabili; le nuove avviano un'altra lettura
+    vector<Waiter> waiters;
+    {
+        lock_guard<mutex> lock(mutex_);
+        flights_.erase(key);
+        waiters.swap(flight->waiters);
+        for (size_t i = 0; i < waiters.size(); i++)
+        {
+            requests_.erase(waiters[i].id);
+        }
+    }
+    Metrics::instance().observe(METRIC_PHASE_ASYNC_REQUEST, chrono::steady_clock::now() - flight->submitted, result);
+
+    const unsigned char* text = NULL;
+    size_t length = 0;
+    if (result == HPLFPSDK::Types::RESULT_OK && xml)
+    {
+        text = (const unsigned char*)xml->c_str();
+        length = xml->size();
+    }
+    for (size_t i = 0; i < waiters.size(); i++)
+    {
+        waiters[i].callback(waiters[i].id, (int)result, text, length, waiters[i].userData);
+    }
+}
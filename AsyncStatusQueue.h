@@ -0,0 +1,67 @@
+#ifndef ASYNC_STATUS_QUEUE_H
+#define ASYNC_STATUS_QUEUE_H
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "IHplfpsdk.h"
+#include "StatusQueries.h"
+#include "ThreadPool.h"
+
+// Callback delle richieste asincrone, chiamata da un thread interno.
+// result e' un HPLFPSDK::Types::Result; con RESULT_OK xml punta al documento
+// (length byte, terminato da '\0'), valido solo durante la chiamata.
+typedef void (*StatusCallback)(unsigned int requestId, int result, const unsigned char* xml, size_t length, void* userData);
+
+// Letture di stato eseguite su un pool di thread al posto del chiamante.
+// Le richieste per la stessa vista della stessa stampante che arrivano mentre
+// una lettura e' in coda o in corso si uniscono a quella: una sola chiamata
+// all'SDK, la stessa risposta a tutte le callback.
+class AsyncStatusQueue
+{
+public:
+    explicit AsyncStatusQueue(size_t workers);
+
+    // Istanza degli export; come FleetPoller non viene mai distrutta.
+    static AsyncStatusQueue& instance();
+
+    // Identificativo della richiesta (mai 0), 0 se i parametri non sono validi.
+    unsigned int submit(const char* ipAddress, const char* printerModel, StatusKind kind, StatusCallback callback, void* userData);
+
+    // true se la callback non e' ancora partita e ora non verra' piu' chiamata.
+    // Con false la callback e' gia' stata chiamata o e' in esecuzione.
+    bool cancel(unsigned int requestId);
+
+private:
+    struct Waiter
+    {
+        unsigned int id;
+        StatusCallback callback;
+        void* userData;
+    };
+
+    struct Flight
+    {
+        std::string ipAddress;
+        std::string printerModel;
+        StatusKind kind;
+        std::chrono::steady_clock::time_point submitted;
+        std::vector<Waiter> waiters;
+    };
+
+    AsyncStatusQueue(const AsyncStatusQueue&);
+    AsyncStatusQueue& operator=(const AsyncStatusQueue&);
+
+    void run(const std::string& key);
+
+    std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Flight> > flights_;   // per ip|modello|vista
+    std::map<unsigned int, std::string> requests_;              // richiesta -> chiave della lettura
+    unsigned int nextId_;
+    ThreadPool pool_;
+};
+
+#endif // ASYNC_STATUS_QUEUE_H
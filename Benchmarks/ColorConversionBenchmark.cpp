@@ -0,0 +1,199 @@
+// Velocita' delle conversioni di ColorConversion (le stesse che RasterJob usa
+// per preparare le bande) con ciascun livello SIMD supportato dalla CPU.
+//
+// Uso: ColorConversionBenchmark [opzioni]
+//   --width N             pixel per riga (predefinito 76800: 64 pollici a 1200 dpi)
+//   --rows N              righe per banda (predefinito: quelle che stanno in 4 MiB)
+//   --seconds S           durata di ogni misura (predefinito 0.5)
+//
+// Per ogni kernel e livello riporta i GB/s scritti nella banda e il rapporto
+// con lo scalare, e verifica che il risultato sia identico a quello scalare
+// anche sulle code delle righe (larghezze da 1 a 130 pixel).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "../ColorConversion.h"
+
+using namespace std;
+
+namespace
+{
+    const size_t BAND_BYTES = 4 * 1024 * 1024;
+    const size_t MAX_TAIL_PIXELS = 130;
+
+    struct Kernel
+    {
+        const char* name;
+        SourceFormat source;
+        RasterLayout layout;
+        bool split;                 // splitPlanes invece di convertRow
+    };
+
+    const Kernel KERNELS[] =
+    {
+        { "rgb-xrgb",         SOURCE_RGB8,  RASTER_LAYOUT_XRGB,        false },
+        { "rgb-bgrx",         SOURCE_RGB8,  RASTER_LAYOUT_BGRX,        false },
+        { "rgba-xbgr",        SOURCE_RGBA8, RASTER_LAYOUT_XBGR,        false },
+        { "rgba-rgbx",        SOURCE_RGBA8, RASTER_LAYOUT_RGBX,        false },
+        { "rgb-cmyk",         SOURCE_RGB8,  RASTER_LAYOUT_CMYK,        false },
+        { "rgb-kcmy",         SOURCE_RGB8,  RASTER_LAYOUT_KCMY,        false },
+        { "rgba-kcmy",        SOURCE_RGBA8, RASTER_LAYOUT_KCMY,        false },
+        { "rgb-planar-cmyk",  SOURCE_RGB8,  RASTER_LAYOUT_PLANAR_CMYK, false },
+        { "rgb-planar-kcmy",  SOURCE_RGB8,  RASTER_LAYOUT_PLANAR_KCMY, false },
+        { "split-planes",     SOURCE_RGBA8, RASTER_LAYOUT_PLANAR_CMYK, true },
+    };
+
+    // Righe di una banda nel formato di uscita del kernel
+    struct Band
+    {
+        Band(const Kernel& kernel, size_t width, size_t rows)
+            : kernel(kernel), width(width), rows(rows),
+              inStride(width * sourceBytesPerPixel(kernel.source)),
+              planeStride(width * rasterBytesPerPixel(kernel.layout)),
+              in(inStride * rows),
+              out(planeStride * rows * rasterPlanes(kernel.layout))
+        {
+            unsigned int seed = 12345;
+            for (size_t i = 0; i < in.size(); i++)
+            {
+                seed = seed * 1103515245u + 12345u;
+                in[i] = (uint8_t)(seed >> 16);
+            }
+        }
+
+        void convert(size_t pixels)
+        {
+            const size_t planes = rasterPlanes(kernel.layout);
+            uint8_t* targets[4];
+            for (size_t row = 0; row < rows; row++)
+            {
+                for (size_t p = 0; p < planes; p++)
+                {
+                    targets[p] = out.data() + (p * rows + row) * planeStride;
+                }
+                if (kernel.split)
+                {
+                    splitPlanes(in.data() + row * inStride, targets, pixels);
+                }
+                else
+                {
+                    convertRow(kernel.source, kernel.layout, in.data() + row * inStride, targets, pixels);
+                }
+            }
+        }
+
+        size_t outputBytes() const
+        {
+            return out.size();
+        }
+
+        const Kernel& kernel;
+        size_t width;
+        size_t rows;
+        size_t inStride;
+        size_t planeStride;
+        vector<uint8_t> in;
+        vector<uint8_t> out;
+    };
+
+    // Uscita di ogni larghezza da 1 a MAX_TAIL_PIXELS, una dopo l'altra
+    vector<uint8_t> tails(const Kernel& kernel)
+    {
+        Band band(kernel, MAX_TAIL_PIXELS, 1);
+        vector<uint8_t> all;
+        for (size_t pixels = 1; pixels <= MAX_TAIL_PIXELS; pixels++)
+        {
+            fill(band.out.begin(), band.out.end(), (uint8_t)0xA5);
+            band.convert(pixels);
+            all.insert(all.end(), band.out.begin(), band.out.end());
+        }
+        return all;
+    }
+
+    double gbPerSecond(Band& band, double seconds)
+    {
+        band.convert(band.width);
+        unsigned long long bytes = 0;
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        double elapsed = 0;
+        do
+        {
+            band.convert(band.width);
+            bytes += band.outputBytes();
+            elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        while (elapsed < seconds);
+        return (double)bytes / elapsed / 1e9;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t width = 76800;
+    size_t rows = 0;
+    double seconds = 0.5;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string option = argv[i];
+        if (option == "--width") width = (size_t)atoi(argv[i + 1]);
+        else if (option == "--rows") rows = (size_t)atoi(argv[i + 1]);
+        else if (option == "--seconds") seconds = atof(argv[i + 1]);
+        else
+        {
+            fprintf(stderr, "opzione sconosciuta: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (width == 0)
+    {
+        fprintf(stderr, "larghezza non valida\n");
+        return 1;
+    }
+    if (rows == 0)
+    {
+        rows = max((size_t)1, BAND_BYTES / (width * 4));
+    }
+
+    const SimdLevel detected = detectedSimdLevel();
+    const size_t kernelCount = sizeof(KERNELS) / sizeof(KERNELS[0]);
+    bool allMatch = true;
+    printf("{\n");
+    printf("  \"detected\": \"%s\",\n", simdLevelName(detected));
+    printf("  \"width\": %zu,\n", width);
+    printf("  \"rows\": %zu,\n", rows);
+    printf("  \"kernels\": [\n");
+    for (size_t k = 0; k < kernelCount; k++)
+    {
+        const Kernel& kernel = KERNELS[k];
+        Band band(kernel, width, rows);
+        setSimdLevel(SIMD_SCALAR);
+        const vector<uint8_t> expectedTails = tails(kernel);
+        band.convert(width);
+        const vector<uint8_t> expected = band.out;
+        double scalar = 0;
+        for (int level = SIMD_SCALAR; level <= detected; level++)
+        {
+            setSimdLevel((SimdLevel)level);
+            fill(band.out.begin(), band.out.end(), (uint8_t)0);
+            band.convert(width);
+            const bool matches = band.out == expected && tails(kernel) == expectedTails;
+            allMatch = allMatch && matches;
+            const double rate = gbPerSecond(band, seconds);
+            if (level == SIMD_SCALAR)
+            {
+                scalar = rate;
+            }
+            printf("    { \"kernel\": \"%s\", \"level\": \"%s\", \"gbPerSecond\": %.2f, \"speedup\": %.2f, \"matchesScalar\": %s }%s\n",
+                   kernel.name, simdLevelName((SimdLevel)level), rate, scalar > 0 ? rate / scalar : 0.0,
+                   matches ? "true" : "false", k + 1 == kernelCount && level == detected ? "" : ",");
+        }
+    }
+    printf("  ],\n");
+    printf("  \"matchesScalar\": %s\n", allMatch ? "true" : "false");
+    printf("}\n");
+    return allMatch ? 0 : 1;
+}
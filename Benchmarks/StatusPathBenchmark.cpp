@@ -0,0 +1,405 @@
+// Tempi del percorso di GetCartridges fase per fase, contro l'SDK simulato:
+// inizializzazione, creazione del device, attesa di "Not initialized",
+// interrogazione di IInfoManager, chiusura, e gli export a freddo e a caldo.
+//
+// Uso: StatusPathBenchmark [opzioni]
+//   --iterations N        campioni per fase (predefinito 2000)
+//   --ready-iterations N  campioni per le fasi con attesa di prontezza (200)
+//   --latency-us N        latenza simulata di ogni chiamata SDK (0)
+//   --jitter-us N         variazione casuale della latenza (0)
+//   --ready-delay-ms N    durata di "Not initialized" dopo la creazione (0)
+//   --payloads DIR        documenti XML della stampante simulata
+//   --output FILE         risultati JSON (predefinito StatusPathBenchmark.json)
+//
+// Per ogni fase: p50/p99/p999 in microsecondi, chiamate al secondo e
+// allocazioni per chiamata (tutti i thread del processo, SDK simulato compreso).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include "../IHplfpsdk.h"
+#include "../PrinterReadiness.h"
+#include "../Simulator/Simulator.h"
+
+using namespace std;
+
+extern "C"
+{
+    unsigned char* GetCartridges(unsigned char* ip, unsigned char* pn);
+    int GetCartridgesEx(unsigned char* ip, unsigned char* pn, unsigned char* buffer, size_t capacity, size_t* written);
+    int GetCartridgesRecords(unsigned char* ip, unsigned char* pn, unsigned char* buffer, size_t capacity, size_t* written);
+    void SetReadyTimeout(unsigned int milliseconds);
+    int CloseSession();
+}
+
+namespace
+{
+    atomic<unsigned long long> allocations(0);
+}
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL)
+    {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace
+{
+    const char MODEL[] = "HP Latex 800";
+
+    struct Options
+    {
+        Options() : iterations(2000), readyIterations(200), latencyUs(0), jitterUs(0), readyDelayMs(0),
+                    output("StatusPathBenchmark.json") {}
+
+        int iterations;
+        int readyIterations;
+        long long latencyUs;
+        long long jitterUs;
+        long long readyDelayMs;
+        string payloads;
+        string output;
+    };
+
+    // Campioni di una fase; reserve prima della misura, cosi' il vettore
+    // non alloca durante le chiamate misurate.
+    struct Phase
+    {
+        Phase(const string& name, int capacity) : name(name), allocations(0), errors(0)
+        {
+            samples.reserve(capacity);
+        }
+
+        string name;
+        vector<long long> samples;      // nanosecondi
+        unsigned long long allocations;
+        unsigned long long errors;
+    };
+
+    // Misura body una volta e aggiunge il campione alla fase.
+    // body restituisce false se la chiamata e' fallita.
+    template <typename Body>
+    void sample(Phase& phase, Body body)
+    {
+        unsigned long long before = allocations.load(memory_order_relaxed);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        bool ok = body();
+        long long ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        phase.allocations += allocations.load(memory_order_relaxed) - before;
+        phase.samples.push_back(ns);
+        if (!ok)
+        {
+            phase.errors++;
+        }
+    }
+
+    double percentile(const vector<long long>& sorted, double p)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        size_t rank = (size_t)(p * sorted.size());
+        return (double)sorted[min(rank, sorted.size() - 1)];
+    }
+
+    // Indirizzo diverso per ogni fase: l'SDK rifiuta due device sullo stesso IP
+    string address(int phase, int i)
+    {
+        return "10.0." + to_string(phase) + "." + to_string(i % 250 + 1);
+    }
+
+    void sdkPhases(const Options& options, vector<Phase>& phases)
+    {
+        Phase init("hplfpsdk_init", options.iterations);
+        Phase terminate("hplfpsdk_terminate", options.iterations);
+        for (int i = 0; i < options.iterations; i++)
+        {
+            sample(init, [] { return hplfpsdk_init() == HPLFPSDK::Types::RESULT_OK; });
+            sample(terminate, [] { hplfpsdk_terminate(); return true; });
+        }
+
+        hplfpsdk_init();
+        Phase create("hplfpsdk_getNewPrinter", options.iterations);
+        Phase discard("hplfpsdk_discardPrinter", options.iterations);
+        for (int i = 0; i < options.iterations; i++)
+        {
+            HPLFPSDK::IDevice* device = NULL;
+            string ip = address(1, i);
+            sample(create, [&] { return hplfpsdk_getNewPrinter(ip.c_str(), MODEL, device) == HPLFPSDK::Types::RESULT_OK; });
+            if (device != NULL)
+            {
+                sample(discard, [&] { return hplfpsdk_discardPrinter(device) == HPLFPSDK::Types::RESULT_OK; });
+            }
+        }
+
+        Phase ready("waitPrinterReady", options.readyIterations);
+        for (int i = 0; i < options.readyIterations; i++)
+        {
+            HPLFPSDK::IDevice* device = NULL;
+            string ip = address(2, i);
+            if (hplfpsdk_getNewPrinter(ip.c_str(), MODEL, device) != HPLFPSDK::Types::RESULT_OK)
+            {
+                continue;
+            }
+            HPLFPSDK::IInfoManager* infoManager = device->getInfoManager();
+            sample(ready, [&]
+            {
+                return waitPrinterReady(infoManager, chrono::milliseconds(options.readyDelayMs * 4 + 1000), NULL) == HPLFPSDK::Types::RESULT_OK;
+            });
+            hplfpsdk_discardPrinter(device);
+        }
+
+        Phase query("IInfoManager::getInkSystemStatus", options.iterations);
+        HPLFPSDK::IDevice* device = NULL;
+        if (hplfpsdk_getNewPrinter(address(3, 0).c_str(), MODEL, device) == HPLFPSDK::Types::RESULT_OK)
+        {
+            HPLFPSDK::IInfoManager* infoManager = device->getInfoManager();
+            waitPrinterReady(infoManager, chrono::milliseconds(options.readyDelayMs * 4 + 1000), NULL);
+            for (int i = 0; i < options.iterations; i++)
+            {
+                sample(query, [&]
+                {
+                    char* info = NULL;
+                    size_t length = 0;
+                    HPLFPSDK::Types::Result result = infoManager->getInkSystemStatus(&info, length);
+                    if (info != NULL)
+                    {
+                        hplfpsdk_deleteBuffer(&info);
+                    }
+                    return result == HPLFPSDK::Types::RESULT_OK;
+                });
+            }
+            hplfpsdk_discardPrinter(device);
+        }
+        hplfpsdk_terminate();
+
+        phases.push_back(init);
+        phases.push_back(terminate);
+        phases.push_back(create);
+        phases.push_back(discard);
+        phases.push_back(ready);
+        phases.push_back(query);
+    }
+
+    bool isError(const unsigned char* text)
+    {
+        // Gli export testuali restituiscono un messaggio al posto dell'XML
+        return text == NULL || text[0] != '<';
+    }
+
+    void exportPhases(const Options& options, vector<Phase>& phases)
+    {
+        unsigned char* ip = (unsigned char*)"10.0.4.1";
+        unsigned char* pn = (unsigned char*)MODEL;
+        SetReadyTimeout((unsigned int)(options.readyDelayMs * 4 + 1000));
+
+        // A freddo: init, device, attesa e lettura; poi chiusura della sessione
+        Phase cold("GetCartridges.cold", options.readyIterations);
+        Phase close("CloseSession", options.readyIterations);
+        for (int i = 0; i < options.readyIterations; i++)
+        {
+            sample(cold, [&] { return !isError(GetCartridges(ip, pn)); });
+            sample(close, [] { return CloseSession() == HPLFPSDK::Types::RESULT_OK; });
+        }
+
+        // A caldo: sessione aperta, documento in cache
+        GetCartridges(ip, pn);
+        Phase warm("GetCartridges.warm", options.iterations);
+        Phase warmEx("GetCartridgesEx.warm", options.iterations);
+        Phase warmRecords("GetCartridgesRecords.warm", options.iterations);
+        vector<unsigned char> buffer(1 << 20);
+        for (int i = 0; i < options.iterations; i++)
+        {
+            sample(warm, [&] { return !isError(GetCartridges(ip, pn)); });
+            sample(warmEx, [&]
+            {
+                size_t written = 0;
+                return GetCartridgesEx(ip, pn, &buffer[0], buffer.size(), &written) == HPLFPSDK::Types::RESULT_OK;
+            });
+            sample(warmRecords, [&]
+            {
+                size_t written = 0;
+                return GetCartridgesRecords(ip, pn, &buffer[0], buffer.size(), &written) == HPLFPSDK::Types::RESULT_OK;
+            });
+        }
+        CloseSession();
+
+        phases.push_back(cold);
+        phases.push_back(close);
+        phases.push_back(warm);
+        phases.push_back(warmEx);
+        phases.push_back(warmRecords);
+    }
+
+    string jsonString(const string& text)
+    {
+        string json = "\"";
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            if (text[i] == '"' || text[i] == '\\')
+            {
+                json += '\\';
+            }
+            json += text[i];
+        }
+        return json + "\"";
+    }
+
+    bool writeJson(const Options& options, const vector<Phase>& phases)
+    {
+        FILE* file = fopen(options.output.c_str(), "w");
+        if (file == NULL)
+        {
+            return false;
+        }
+        fprintf(file, "{\n  \"benchmark\": \"StatusPath\",\n");
+        fprintf(file, "  \"config\": { \"iterations\": %d, \"readyIterations\": %d, \"latencyUs\": %lld, \"jitterUs\": %lld, \"readyDelayMs\": %lld },\n",
+                options.iterations, options.readyIterations, options.latencyUs, options.jitterUs, options.readyDelayMs);
+        fprintf(file, "  \"phases\": [\n");
+        for (size_t i = 0; i < phases.size(); i++)
+        {
+            const Phase& phase = phases[i];
+            vector<long long> sorted(phase.samples);
+            sort(sorted.begin(), sorted.end());
+            long long total = 0;
+            for (size_t j = 0; j < sorted.size(); j++)
+            {
+                total += sorted[j];
+            }
+            double calls = (double)sorted.size();
+            fprintf(file, "    { \"name\": %s, \"calls\": %zu, \"errors\": %llu, \"p50Us\": %.3f, \"p99Us\": %.3f, \"p999Us\": %.3f, "
+                          "\"meanUs\": %.3f, \"callsPerSec\": %.1f, \"allocationsPerCall\": %.2f }%s\n",
+                    jsonString(phase.name).c_str(), sorted.size(), phase.errors,
+                    percentile(sorted, 0.50) / 1e3, percentile(sorted, 0.99) / 1e3, percentile(sorted, 0.999) / 1e3,
+                    calls > 0 ? total / calls / 1e3 : 0.0,
+                    total > 0 ? calls / (total / 1e9) : 0.0,
+                    calls > 0 ? phase.allocations / calls : 0.0,
+                    i + 1 < phases.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+        fclose(file);
+        return true;
+    }
+
+    void printTable(const vector<Phase>& phases)
+    {
+        fprintf(stderr, "%-34s %8s %10s %10s %10s %12s %10s\n", "fase", "chiamate", "p50 us", "p99 us", "p999 us", "chiamate/s", "alloc");
+        for (size_t i = 0; i < phases.size(); i++)
+        {
+            vector<long long> sorted(phases[i].samples);
+            sort(sorted.begin(), sorted.end());
+            long long total = 0;
+            for (size_t j = 0; j < sorted.size(); j++)
+            {
+                total += sorted[j];
+            }
+            fprintf(stderr, "%-34s %8zu %10.1f %10.1f %10.1f %12.0f %10.1f\n", phases[i].name.c_str(), sorted.size(),
+                    percentile(sorted, 0.50) / 1e3, percentile(sorted, 0.99) / 1e3, percentile(sorted, 0.999) / 1e3,
+                    total > 0 ? sorted.size() / (total / 1e9) : 0.0,
+                    sorted.empty() ? 0.0 : (double)phases[i].allocations / sorted.size());
+        }
+    }
+
+    bool parse(int argc, char* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            string name = argv[i];
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+            const char* value = argv[++i];
+            if (name == "--iterations")
+            {
+                options.iterations = max(1, atoi(value));
+            }
+            else if (name == "--ready-iterations")
+            {
+                options.readyIterations = max(1, atoi(value));
+            }
+            else if (name == "--latency-us")
+            {
+                options.latencyUs = atoll(value);
+            }
+            else if (name == "--jitter-us")
+            {
+                options.jitterUs = atoll(value);
+            }
+            else if (name == "--ready-delay-ms")
+            {
+                options.readyDelayMs = atoll(value);
+            }
+            else if (name == "--payloads")
+            {
+                options.payloads = value;
+            }
+            else if (name == "--output")
+            {
+                options.output = value;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parse(argc, argv, options))
+    {
+        fprintf(stderr, "uso: %s [--iterations N] [--ready-iterations N] [--latency-us N] [--jitter-us N] "
+                        "[--ready-delay-ms N] [--payloads DIR] [--output FILE]\n", argv[0]);
+        return 2;
+    }
+
+    SimulatorConfig config = Simulator::instance().config();
+    config.latency = chrono::microseconds(options.latencyUs);
+    config.jitter = chrono::microseconds(options.jitterUs);
+    config.readinessDelay = chrono::milliseconds(options.readyDelayMs);
+    config.eventInterval = chrono::milliseconds(0);
+    if (!options.payloads.empty())
+    {
+        config.payloadDirectory = options.payloads;
+    }
+    Simulator::instance().configure(config);
+
+    vector<Phase> phases;
+    sdkPhases(options, phases);
+    exportPhases(options, phases);
+
+    printTable(phases);
+    if (!writeJson(options, phases))
+    {
+        fprintf(stderr, "impossibile scrivere %s\n", options.output.c_str());
+        return 1;
+    }
+    fprintf(stderr, "risultati in %s\n", options.output.c_str());
+    return 0;
+}
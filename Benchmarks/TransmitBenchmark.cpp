@@ -0,0 +1,234 @@
+// Invio di un job raster con StreamRasterJob (vedi JobTransmitter) verso un
+// sink TCP locale che fa da stampante, contro l'SDK simulato.
+//
+// Uso: TransmitBenchmark [opzioni]
+//   --width N             larghezza dell'immagine generata (predefinito 4000)
+//   --height N            altezza (predefinito 4000)
+//   --in-flight N         limite di byte in volo (0 = predefinito di JobTransmitter)
+//   --sink-mbps N         velocita' massima del sink in MB/s (0 = senza limite)
+//   --image FILE          immagine PPM temporanea (TransmitBenchmark.ppm)
+//
+// Riporta byte e throughput visti dal sink e dalla callback, e verifica che il
+// sink abbia ricevuto gli stessi byte che SubmitRasterJob scrive nello spool.
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../IHplfpsdk.h"
+
+using namespace std;
+
+extern "C"
+{
+    int SubmitRasterJob(unsigned char* ip, unsigned char* pn, unsigned char* imagePath, unsigned char* rasterConfig,
+                        unsigned char* jobName, unsigned char* spoolPath,
+                        HPLFPSDK::IJobPacker::transmissionStatusCallback callback, void* userData);
+    int StreamRasterJob(unsigned char* ip, unsigned char* pn, unsigned char* imagePath, unsigned char* rasterConfig,
+                        unsigned char* jobName, unsigned int port, unsigned int maxInFlightBytes,
+                        HPLFPSDK::IJobPacker::transmissionStatusCallback callback, void* userData);
+    void SetReadyTimeout(unsigned int milliseconds);
+    unsigned char* GetMetrics();
+    int CloseSession();
+}
+
+namespace
+{
+    const char MODEL[] = "HP Latex 700";
+    const char RASTER_CONFIG[] = "CHUNKY-XRGB-32-600-RasterStream_BANDS";
+
+    unsigned long long fnv(unsigned long long hash, const unsigned char* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Riceve una connessione fino alla chiusura, al massimo a mbps MB/s
+    struct Sink
+    {
+        Sink() : listener(-1), port(0), received(0), hash(14695981039346656037ull), mbps(0) {}
+
+        bool listen()
+        {
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            if (listener < 0 || bind(listener, (sockaddr*)&address, length) != 0 || ::listen(listener, 1) != 0 ||
+                getsockname(listener, (sockaddr*)&address, &length) != 0)
+            {
+                return false;
+            }
+            port = ntohs(address.sin_port);
+            return true;
+        }
+
+        void run()
+        {
+            int connection = accept(listener, NULL, NULL);
+            vector<unsigned char> buffer(256 * 1024);
+            const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (;;)
+            {
+                ssize_t n = recv(connection, buffer.data(), buffer.size(), 0);
+                if (n <= 0)
+                {
+                    break;
+                }
+                hash = fnv(hash, buffer.data(), (size_t)n);
+                received += (unsigned long long)n;
+                if (mbps > 0)
+                {
+                    this_thread::sleep_until(start + chrono::microseconds(received / mbps));
+                }
+            }
+            close(connection);
+            close(listener);
+        }
+
+        int listener;
+        unsigned short port;
+        atomic<unsigned long long> received;
+        unsigned long long hash;
+        unsigned long long mbps;
+    };
+
+    struct Progress
+    {
+        Progress() : callbacks(0), bytes(0) {}
+
+        atomic<unsigned long long> callbacks;
+        atomic<size_t> bytes;
+    };
+
+    void onTransmitted(void* userData, size_t bytesSent)
+    {
+        Progress* progress = (Progress*)userData;
+        progress->callbacks++;
+        progress->bytes = bytesSent;
+    }
+
+    bool writeImage(const string& path, unsigned int width, unsigned int height)
+    {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == NULL)
+        {
+            return false;
+        }
+        fprintf(file, "P6\n%u %u\n255\n", width, height);
+        vector<unsigned char> row((size_t)width * 3);
+        for (unsigned int y = 0; y < height; y++)
+        {
+            for (size_t x = 0; x < row.size(); x++)
+            {
+                row[x] = (unsigned char)(x * 7 + y * 3);
+            }
+            fwrite(row.data(), 1, row.size(), file);
+        }
+        return fclose(file) == 0;
+    }
+
+    unsigned long long hashFile(const string& path)
+    {
+        unsigned long long hash = 14695981039346656037ull;
+        FILE* file = fopen(path.c_str(), "rb");
+        vector<unsigned char> buffer(256 * 1024);
+        size_t n;
+        while (file != NULL && (n = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+        {
+            hash = fnv(hash, buffer.data(), n);
+        }
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        return hash;
+    }
+
+    unsigned long long counter(const string& metrics, const char* name)
+    {
+        size_t position = metrics.find(string("\n") + name + " ");
+        return position == string::npos ? 0 : strtoull(metrics.c_str() + position + strlen(name) + 2, NULL, 10);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int width = 4000;
+    unsigned int height = 4000;
+    unsigned int inFlight = 0;
+    unsigned long long sinkMbps = 0;
+    string image = "TransmitBenchmark.ppm";
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        string option = argv[i];
+        if (option == "--width") width = (unsigned int)atoi(argv[i + 1]);
+        else if (option == "--height") height = (unsigned int)atoi(argv[i + 1]);
+        else if (option == "--in-flight") inFlight = (unsigned int)atoi(argv[i + 1]);
+        else if (option == "--sink-mbps") sinkMbps = strtoull(argv[i + 1], NULL, 10);
+        else if (option == "--image") image = argv[i + 1];
+        else
+        {
+            fprintf(stderr, "opzione sconosciuta: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    setenv("HPSDK_SIM_READY_DELAY_MS", "0", 0);
+    if (!writeImage(image, width, height))
+    {
+        fprintf(stderr, "impossibile scrivere %s\n", image.c_str());
+        return 1;
+    }
+
+    Sink sink;
+    sink.mbps = sinkMbps;
+    if (!sink.listen())
+    {
+        fprintf(stderr, "impossibile aprire il sink\n");
+        return 1;
+    }
+    thread sinkThread(&Sink::run, &sink);
+
+    Progress progress;
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int result = StreamRasterJob((unsigned char*)"127.0.0.1", (unsigned char*)MODEL, (unsigned char*)image.c_str(),
+                                 (unsigned char*)RASTER_CONFIG, (unsigned char*)"TransmitBenchmark", sink.port, inFlight,
+                                 &onTransmitted, &progress);
+    sinkThread.join();
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Lo stesso job nello spool, per confrontare i byte ricevuti
+    string spool = image + ".spool";
+    int spoolResult = SubmitRasterJob((unsigned char*)"127.0.0.1", (unsigned char*)MODEL, (unsigned char*)image.c_str(),
+                                      (unsigned char*)RASTER_CONFIG, (unsigned char*)"TransmitBenchmark",
+                                      (unsigned char*)spool.c_str(), NULL, NULL);
+    const bool same = spoolResult == 0 && hashFile(spool) == sink.hash;
+    string metrics = (char*)GetMetrics();
+    CloseSession();
+    remove(spool.c_str());
+    remove(image.c_str());
+
+    printf("{\n");
+    printf("  \"result\": %d,\n", result);
+    printf("  \"bytes\": %llu,\n", sink.received.load());
+    printf("  \"seconds\": %.3f,\n", seconds);
+    printf("  \"mbPerSecond\": %.1f,\n", seconds > 0 ? sink.received.load() / seconds / 1e6 : 0.0);
+    printf("  \"callbacks\": %llu,\n", progress.callbacks.load());
+    printf("  \"callbackBytes\": %zu,\n", progress.bytes.load());
+    printf("  \"backpressure\": %llu,\n", counter(metrics, "hpsdk_transmit_backpressure_total"));
+    printf("  \"matchesSpool\": %s\n", same ? "true" : "false");
+    printf("}\n");
+    return result == 0 && same ? 0 : 1;
+}
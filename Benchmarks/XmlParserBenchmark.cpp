@@ -0,0 +1,205 @@
+// Confronto tra la lettura dei documenti di stato con copia in std::string e
+// find (come facevano i vecchi export) e con XmlPullParser/xmlSelect.
+//
+// Uso: XmlParserBenchmark [cartella payload] [iterazioni]
+// La cartella predefinita e' Benchmarks/Payloads, con i documenti registrati
+// da una HP Latex 800.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../StatusRecords.h"
+#include "../XmlPullParser.h"
+
+using namespace std;
+
+namespace
+{
+    size_t allocations = 0;
+}
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL)
+    {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace
+{
+    struct Payload
+    {
+        const char* file;
+        StatusKind kind;
+        const char* slot;   // elemento ripetuto nel documento
+        string xml;
+    };
+
+    // Campi letti da ogni slot: quelli che finiscono nei record binari.
+    struct LegacySlot
+    {
+        string id;
+        string color;
+        string status;
+        string present;
+        string level;
+    };
+
+    string between(const string& s, const string& open, const string& close)
+    {
+        size_t begin = s.find(open);
+        if (begin == string::npos)
+        {
+            return string();
+        }
+        begin += open.size();
+        size_t end = s.find(close, begin);
+        return end == string::npos ? string() : s.substr(begin, end - begin);
+    }
+
+    // Approccio precedente: copia del buffer SDK e ricerche di sottostringhe.
+    size_t legacyParse(const char* info, const char* slotName, vector<LegacySlot>& slots)
+    {
+        slots.clear();
+        string s = (string)info;
+        if (s.find("Not initialized") != std::string::npos)
+        {
+            return 0;
+        }
+        string open = string("<") + slotName + " ";
+        string close = string("</") + slotName + ">";
+        size_t position = 0;
+        while ((position = s.find(open, position)) != string::npos)
+        {
+            size_t end = s.find(close, position);
+            if (end == string::npos)
+            {
+                break;
+            }
+            string slot = s.substr(position, end - position);
+            LegacySlot parsed;
+            parsed.id = between(slot, "id=\"", "\"");
+            parsed.color = between(slot, "<Color>", "</Color>");
+            parsed.status = between(slot, "<MostRelevantStatus>", "</MostRelevantStatus>");
+            parsed.present = between(slot, "<IsPresent>", "</IsPresent>");
+            parsed.level = between(slot, "<LevelPercentage>", "</LevelPercentage>");
+            slots.push_back(parsed);
+            position = end + close.size();
+        }
+        return slots.size();
+    }
+
+    // Stessi campi con il parser pull: viste sul buffer, nessuna copia.
+    size_t pullParse(const char* info, size_t length, const char* slotName, size_t& checksum)
+    {
+        return xmlSelect(info, length, slotName, [&checksum](const XmlElement& element)
+        {
+            static const string_view paths[] = { "Color", "MostRelevantStatus", "IsPresent", "LevelPercentage" };
+            string_view values[4];
+            string_view id;
+            element.attribute("id", id);
+            element.texts(paths, values, 4);
+            checksum += id.size() + values[0].size() + values[1].size() + values[2].size() + values[3].size();
+            return true;
+        });
+    }
+
+    bool load(const string& directory, Payload& payload)
+    {
+        ifstream file((directory + "/" + payload.file).c_str(), ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        payload.xml.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        return true;
+    }
+
+    template <typename Body>
+    void measure(const char* name, const Payload& payload, int iterations, Body body)
+    {
+        for (int i = 0; i < iterations / 10; i++)
+        {
+            body();
+        }
+        size_t before = allocations;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            body();
+        }
+        double ns = (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        printf("%-24s %-12s %10.0f ns/op %8.1f alloc/op %8.1f MB/s\n",
+               payload.file, name, ns / iterations, (double)(allocations - before) / iterations,
+               payload.xml.size() * (double)iterations / (ns / 1e9) / 1e6);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    string directory = argc > 1 ? argv[1] : "Benchmarks/Payloads";
+    int iterations = argc > 2 ? atoi(argv[2]) : 20000;
+    if (iterations <= 0)
+    {
+        iterations = 20000;
+    }
+
+    Payload payloads[] =
+    {
+        { "InkSystem.xml",             STATUS_INK_SYSTEM,             "InkSlot",              string() },
+        { "PrintheadSlots.xml",        STATUS_PRINTHEAD_SLOTS,        "PrintheadSlot",        string() },
+        { "MaintenanceCartridges.xml", STATUS_MAINTENANCE_CARTRIDGES, "MaintenanceCartridge", string() }
+    };
+
+    size_t checksum = 0;
+    for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++)
+    {
+        Payload& payload = payloads[i];
+        if (!load(directory, payload))
+        {
+            fprintf(stderr, "payload non trovato: %s/%s\n", directory.c_str(), payload.file);
+            return 1;
+        }
+        // L'SDK restituisce buffer terminati da '\0'
+        const char* info = payload.xml.c_str();
+        const size_t length = payload.xml.size() + 1;
+
+        vector<LegacySlot> slots;
+        measure("string+find", payload, iterations, [&]()
+        {
+            checksum += legacyParse(info, payload.slot, slots);
+        });
+        measure("pull", payload, iterations, [&]()
+        {
+            checksum += pullParse(info, length, payload.slot, checksum);
+        });
+        string block;
+        measure("records", payload, iterations, [&]()
+        {
+            buildStatusRecords(payload.kind, info, length, block);
+            checksum += block.size();
+        });
+    }
+    printf("checksum %zu\n", checksum);
+    return 0;
+}
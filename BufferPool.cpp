@@ -0,0 +1,316 @@
+#include "BufferPool.h"
+
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    void updateMax(atomic<size_t>& highWater, size_t value)
+    {
+        size_t current = highWater.load(memory_order_relaxed);
+        while (value > current && !highWater.compare_exchange_weak(current, value, memory_order_relaxed))
+        {
+        }
+    }
+
+    uint64_t nextHead(uint64_t head, uint32_t first)
+    {
+        return (((head >> 32) + 1) << 32) | first;
+    }
+}
+
+BufferPool::SizeClass::SizeClass()
+    : size(0), perSlab(0), head(0), slabCount(0), acquired(0), inUse(0), highWater(0)
+{
+    for (size_t i = 0; i < MAX_SLABS; i++)
+    {
+        slabs[i].store(NULL, memory_order_relaxed);
+    }
+}
+
+BufferPool::BufferPool()
+    : allocations_(0), oversize_(0), reservedBytes_(0), inUseBytes_(0), highWaterBytes_(0)
+{
+    for (size_t i = 0; i < CLASS_COUNT; i++)
+    {
+        classes_[i].size = (size_t)PAGE_SIZE << i;
+        classes_[i].perSlab = (uint32_t)(classes_[i].size < SLAB_BYTES ? SLAB_BYTES / classes_[i].size : 1);
+    }
+}
+
+BufferPool& BufferPool::instance()
+{
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+size_t BufferPool::classOf(size_t size)
+{
+    size_t index = 0;
+    while (index < CLASS_COUNT && ((size_t)PAGE_SIZE << index) < size)
+    {
+        index++;
+    }
+    return index;
+}
+
+uint8_t* BufferPool::allocate(size_t size)
+{
+#ifdef _WIN32
+    return (uint8_t*)_aligned_malloc(size, PAGE_SIZE);
+#else
+    void* data = NULL;
+    return posix_memalign(&data, PAGE_SIZE, size) == 0 ? (uint8_t*)data : NULL;
+#endif
+}
+
+void BufferPool::deallocate(uint8_t* data)
+{
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
+
+void* BufferPool::acquire(size_t size)
+{
+    size_t index = classOf(size);
+    if (index >= CLASS_COUNT)
+    {
+        return acquireOversize(size);
+    }
+    SizeClass& sizeClass = classes_[index];
+    uint8_t* buffer = pop(sizeClass);
+    while (buffer == NULL)
+    {
+        if (!grow(sizeClass))
+        {
+            return acquireOversize(size);
+        }
+        buffer = pop(sizeClass);
+    }
+    sizeClass.acquired.fetch_add(1, memory_order_relaxed);
+    updateMax(sizeClass.highWater, sizeClass.inUse.fetch_add(1, memory_order_relaxed) + 1);
+    addInUse(sizeClass.size);
+    return buffer;
+}
+
+void BufferPool::release(const void* buffer)
+{
+    if (buffer == NULL)
+    {
+        return;
+    }
+    SizeClass* sizeClass = NULL;
+    uint32_t index = 0;
+    if (find(buffer, sizeClass, index))
+    {
+        sizeClass->inUse.fetch_sub(1, memory_order_relaxed);
+        inUseBytes_.fetch_sub(sizeClass->size, memory_order_relaxed);
+        push(*sizeClass, index);
+        return;
+    }
+    // Fuori classe: la dimensione e' nella pagina che precede il buffer
+    uint8_t* data = (uint8_t*)buffer - PAGE_SIZE;
+    inUseBytes_.fetch_sub(*(size_t*)data, memory_order_relaxed);
+    deallocate(data);
+}
+
+bool BufferPool::reserve(size_t size, size_t count)
+{
+    size_t index = classOf(size);
+    if (index >= CLASS_COUNT)
+    {
+        return false;
+    }
+    SizeClass& sizeClass = classes_[index];
+    lock_guard<mutex> lock(growMutex_);
+    while ((size_t)sizeClass.slabCount.load(memory_order_relaxed) * sizeClass.perSlab - sizeClass.inUse.load(memory_order_relaxed) < count)
+    {
+        if (!addSlabLocked(sizeClass))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint8_t* BufferPool::pop(SizeClass& sizeClass)
+{
+    uint64_t head = sizeClass.head.load(memory_order_acquire);
+    while ((uint32_t)head != 0)
+    {
+        uint32_t index = (uint32_t)head - 1;
+        Slab* slab = sizeClass.slabs[index / sizeClass.perSlab].load(memory_order_acquire);
+        // Se un altro thread ha preso il buffer nel frattempo next e' vecchio,
+        // ma il contatore nella testa fa fallire il compare-exchange
+        uint32_t next = slab->next[index % sizeClass.perSlab].load(memory_order_relaxed);
+        if (sizeClass.head.compare_exchange_weak(head, nextHead(head, next), memory_order_acq_rel, memory_order_acquire))
+        {
+            return slab->data + (size_t)(index % sizeClass.perSlab) * sizeClass.size;
+        }
+    }
+    return NULL;
+}
+
+void BufferPool::push(SizeClass& sizeClass, uint32_t index)
+{
+    Slab* slab = sizeClass.slabs[index / sizeClass.perSlab].load(memory_order_acquire);
+    atomic<uint32_t>& next = slab->next[index % sizeClass.perSlab];
+    uint64_t head = sizeClass.head.load(memory_order_relaxed);
+    do
+    {
+        next.store((uint32_t)head, memory_order_relaxed);
+    }
+    while (!sizeClass.head.compare_exchange_weak(head, nextHead(head, index + 1), memory_order_release, memory_order_relaxed));
+}
+
+bool BufferPool::grow(SizeClass& sizeClass)
+{
+    lock_guard<mutex> lock(growMutex_);
+    // Un altro thread puo' aver aggiunto uno slab mentre si attendeva il mutex
+    if ((uint32_t)sizeClass.head.load(memory_order_acquire) != 0)
+    {
+        return true;
+    }
+    return addSlabLocked(sizeClass);
+}
+
+bool BufferPool::addSlabLocked(SizeClass& sizeClass)
+{
+    uint32_t count = sizeClass.slabCount.load(memory_order_relaxed);
+    if (count >= MAX_SLABS)
+    {
+        return false;
+    }
+    uint8_t* data = allocate(sizeClass.size * sizeClass.perSlab);
+    if (data == NULL)
+    {
+        return false;
+    }
+    Slab* slab = new Slab();
+    slab->data = data;
+    slab->next = new atomic<uint32_t>[sizeClass.perSlab];
+    allocations_.fetch_add(1, memory_order_relaxed);
+    reservedBytes_.fetch_add(sizeClass.size * sizeClass.perSlab, memory_order_relaxed);
+
+    // I buffer del nuovo slab formano una catena che viene messa in cima alla pila
+    const uint32_t first = count * sizeClass.perSlab;
+    for (uint32_t i = 0; i + 1 < sizeClass.perSlab; i++)
+    {
+        slab->next[i].store(first + i + 2, memory_order_relaxed);
+    }
+    sizeClass.slabs[count].store(slab, memory_order_release);
+    sizeClass.slabCount.store(count + 1, memory_order_release);
+    atomic<uint32_t>& last = slab->next[sizeClass.perSlab - 1];
+    uint64_t head = sizeClass.head.load(memory_order_relaxed);
+    do
+    {
+        last.store((uint32_t)head, memory_order_relaxed);
+    }
+    while (!sizeClass.head.compare_exchange_weak(head, nextHead(head, first + 1), memory_order_release, memory_order_relaxed));
+    return true;
+}
+
+bool BufferPool::find(const void* buffer, SizeClass*& sizeClass, uint32_t& index)
+{
+    const uint8_t* address = (const uint8_t*)buffer;
+    for (size_t i = 0; i < CLASS_COUNT; i++)
+    {
+        SizeClass& candidate = classes_[i];
+        uint32_t count = candidate.slabCount.load(memory_order_acquire);
+        for (uint32_t s = 0; s < count; s++)
+        {
+            const Slab* slab = candidate.slabs[s].load(memory_order_acquire);
+            if (address >= slab->data && address < slab->data + candidate.size * candidate.perSlab)
+            {
+                sizeClass = &candidate;
+                index = s * candidate.perSlab + (uint32_t)((size_t)(address - slab->data) / candidate.size);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void* BufferPool::acquireOversize(size_t size)
+{
+    uint8_t* data = allocate(size + PAGE_SIZE);
+    if (data == NULL)
+    {
+        return NULL;
+    }
+    *(size_t*)data = size;
+    allocations_.fetch_add(1, memory_order_relaxed);
+    oversize_.fetch_add(1, memory_order_relaxed);
+    addInUse(size);
+    return data + PAGE_SIZE;
+}
+
+void BufferPool::addInUse(size_t bytes)
+{
+    updateMax(highWaterBytes_, inUseBytes_.fetch_add(bytes, memory_order_relaxed) + bytes);
+}
+
+BufferPoolStats BufferPool::stats() const
+{
+    BufferPoolStats stats;
+    for (size_t i = 0; i < CLASS_COUNT; i++)
+    {
+        const SizeClass& sizeClass = classes_[i];
+        BufferClassStats item;
+        item.size = sizeClass.size;
+        item.acquired = sizeClass.acquired.load(memory_order_relaxed);
+        item.buffers = (size_t)sizeClass.slabCount.load(memory_order_relaxed) * sizeClass.perSlab;
+        item.inUse = sizeClass.inUse.load(memory_order_relaxed);
+        item.highWater = sizeClass.highWater.load(memory_order_relaxed);
+        stats.classes.push_back(item);
+    }
+    stats.allocations = allocations_.load(memory_order_relaxed);
+    stats.oversize = oversize_.load(memory_order_relaxed);
+    stats.reservedBytes = reservedBytes_.load(memory_order_relaxed);
+    stats.inUseBytes = inUseBytes_.load(memory_order_relaxed);
+    stats.highWaterBytes = highWaterBytes_.load(memory_order_relaxed);
+    return stats;
+}
+
+string BufferPool::toXml(const BufferPoolStats& stats)
+{
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<BufferPool allocations=\"";
+    xml += to_string(stats.allocations);
+    xml += "\" oversize=\"";
+    xml += to_string(stats.oversize);
+    xml += "\" reservedBytes=\"";
+    xml += to_string(stats.reservedBytes);
+    xml += "\" inUseBytes=\"";
+    xml += to_string(stats.inUseBytes);
+    xml += "\" highWaterBytes=\"";
+    xml += to_string(stats.highWaterBytes);
+    xml += "\">\n";
+    for (size_t i = 0; i < stats.classes.size(); i++)
+    {
+        const BufferClassStats& item = stats.classes[i];
+        if (item.buffers == 0 && item.acquired == 0)
+        {
+            continue;
+        }
+        xml += "<Class size=\"";
+        xml += to_string(item.size);
+        xml += "\" buffers=\"";
+        xml += to_string(item.buffers);
+        xml += "\" inUse=\"";
+        xml += to_string(item.inUse);
+        xml += "\" highWater=\"";
+        xml += to_string(item.highWater);
+        xml += "\" acquired=\"";
+        xml += to_string(item.acquired);
+        xml += "\"/>\n";
+    }
+    xml += "</BufferPool>\n";
+    return xml;
+}
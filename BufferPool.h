@@ -0,0 +1,114 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct BufferClassStats
+{
+    size_t size;                    // byte di ogni buffer della classe
+    unsigned long long acquired;    // acquire serviti dalla classe
+    size_t buffers;                 // buffer allocati
+    size_t inUse;
+    size_t highWater;               // massimo di inUse
+};
+
+struct BufferPoolStats
+{
+    std::vector<BufferClassStats> classes;
+    unsigned long long allocations;     // chiamate all'allocatore (slab e buffer fuori classe)
+    unsigned long long oversize;        // acquire oltre MAX_CLASS_SIZE o con la classe esaurita
+    size_t reservedBytes;               // memoria dei slab, mai restituita
+    size_t inUseBytes;                  // dimensione dei buffer in uso (per classe, non richiesta)
+    size_t highWaterBytes;
+};
+
+// Buffer allineati alla pagina per gli IMemoryHandler dei job (vedi
+// PooledMemoryHandler). Le richieste vengono arrotondate alla potenza di due
+// successiva tra PAGE_SIZE e MAX_CLASS_SIZE; ogni classe ha i suoi slab da
+// SLAB_BYTES (o da un buffer, se piu' grande), allocati quando la classe e'
+// vuota e mai restituiti. A regime acquire e release non chiamano l'allocatore.
+//
+// I buffer liberi di una classe formano una pila lock-free: la testa e' una
+// parola a 64 bit con l'indice del primo buffer e un contatore che cambia a
+// ogni operazione, cosi' un compare-exchange non scambia una pila modificata
+// nel frattempo per quella letta (ABA). Il mutex serve solo ad aggiungere slab.
+// Le richieste oltre MAX_CLASS_SIZE, o con MAX_SLABS slab gia' allocati,
+// passano direttamente dall'allocatore.
+class BufferPool
+{
+public:
+    enum
+    {
+        PAGE_SIZE = 4096,
+        MAX_CLASS_SIZE = 16 * 1024 * 1024,
+        CLASS_COUNT = 13,               // 4 KiB, 8 KiB, ..., 16 MiB
+        SLAB_BYTES = 1024 * 1024,
+        MAX_SLABS = 64
+    };
+
+    // Pool dei job del processo; come FleetPoller non viene mai distrutto.
+    static BufferPool& instance();
+
+    // NULL solo se l'allocatore fallisce.
+    void* acquire(size_t size);
+    // buffer deve venire da acquire; NULL e' ignorato.
+    void release(const void* buffer);
+
+    // Alloca subito i slab per avere almeno count buffer liberi da size byte.
+    bool reserve(size_t size, size_t count);
+
+    BufferPoolStats stats() const;
+    static std::string toXml(const BufferPoolStats& stats);
+
+private:
+    struct Slab
+    {
+        uint8_t* data;
+        std::atomic<uint32_t>* next;    // indice + 1 del buffer successivo nella pila, 0 alla fine
+    };
+
+    struct SizeClass
+    {
+        SizeClass();
+
+        size_t size;
+        uint32_t perSlab;
+        std::atomic<uint64_t> head;     // contatore << 32 | (indice + 1), 0 = pila vuota
+        std::atomic<Slab*> slabs[MAX_SLABS];
+        std::atomic<uint32_t> slabCount;
+        std::atomic<unsigned long long> acquired;
+        std::atomic<size_t> inUse;
+        std::atomic<size_t> highWater;
+    };
+
+    BufferPool();
+    BufferPool(const BufferPool&);
+    BufferPool& operator=(const BufferPool&);
+
+    static size_t classOf(size_t size);
+    static uint8_t* allocate(size_t size);
+    static void deallocate(uint8_t* data);
+
+    uint8_t* pop(SizeClass& sizeClass);
+    void push(SizeClass& sizeClass, uint32_t index);
+    bool grow(SizeClass& sizeClass);
+    bool addSlabLocked(SizeClass& sizeClass);
+    bool find(const void* buffer, SizeClass*& sizeClass, uint32_t& index);
+    void* acquireOversize(size_t size);
+    void addInUse(size_t bytes);
+
+    SizeClass classes_[CLASS_COUNT];
+    std::mutex growMutex_;
+    std::atomic<unsigned long long> allocations_;
+    std::atomic<unsigned long long> oversize_;
+    std::atomic<size_t> reservedBytes_;
+    std::atomic<size_t> inUseBytes_;
+    std::atomic<size_t> highWaterBytes_;
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,67 @@
+#include "CallbackRegistry.h"
+
+using namespace std;
+
+CallbackRegistry::Call::Call(void* token)
+    : token_((uintptr_t)token), target_(NULL)
+{
+    CallbackRegistry& registry = CallbackRegistry::instance();
+    lock_guard<mutex> lock(registry.mutex_);
+    map<uintptr_t, Registered>::iterator it = registry.targets_.find(token_);
+    if (it != registry.targets_.end())
+    {
+        it->second.calls++;
+        target_ = it->second.target;
+    }
+}
+
+CallbackRegistry::Call::~Call()
+{
+    if (target_ == NULL)
+    {
+        return;
+    }
+    CallbackRegistry& registry = CallbackRegistry::instance();
+    {
+        lock_guard<mutex> lock(registry.mutex_);
+        map<uintptr_t, Registered>::iterator it = registry.targets_.find(token_);
+        if (it != registry.targets_.end())
+        {
+            it->second.calls--;
+        }
+    }
+    registry.finished_.notify_all();
+}
+
+CallbackRegistry& CallbackRegistry::instance()
+{
+    static CallbackRegistry* registry = new CallbackRegistry();
+    return *registry;
+}
+
+CallbackRegistry::CallbackRegistry()
+    : next_(1)
+{
+}
+
+void* CallbackRegistry::add(void* target)
+{
+    lock_guard<mutex> lock(mutex_);
+    uintptr_t token = next_++;
+    Registered& registered = targets_[token];
+    registered.target = target;
+    registered.calls = 0;
+    return (void*)token;
+}
+
+void CallbackRegistry::remove(void* token)
+{
+    unique_lock<mutex> lock(mutex_);
+    map<uintptr_t, Registered>::iterator it = targets_.find((uintptr_t)token);
+    if (it == targets_.end())
+    {
+        return;
+    }
+    finished_.wait(lock, [&it] { return it->second.calls == 0; });
+    targets_.erase(it);
+}
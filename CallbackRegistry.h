@@ -0,0 +1,62 @@
+#ifndef CALLBACK_REGISTRY_H
+#define CALLBACK_REGISTRY_H
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+
+// Destinatari delle callback di sottoscrizione dell'SDK. Come userData l'SDK
+// riceve un token numerico, non il puntatore: la callback lo risolve con un
+// Call, che tiene il destinatario registrato finche' e' in corso. remove
+// toglie il token e attende le callback gia' partite, quindi dopo unsubscribe
+// e remove il destinatario puo' essere distrutto anche se l'SDK consegna
+// ancora un evento in ritardo (che non trova piu' il token e viene ignorato).
+class CallbackRegistry
+{
+public:
+    // Risolve un token per la durata della callback; target() e' NULL se il
+    // token e' gia' stato tolto.
+    class Call
+    {
+    public:
+        explicit Call(void* token);
+        ~Call();
+
+        void* target() const { return target_; }
+
+    private:
+        Call(const Call&);
+        Call& operator=(const Call&);
+
+        uintptr_t token_;
+        void* target_;
+    };
+
+    // Come FleetPoller non viene mai distrutta: le callback possono arrivare fino all'uscita.
+    static CallbackRegistry& instance();
+
+    // userData da passare alla sottoscrizione.
+    void* add(void* target);
+    // Da chiamare dopo unsubscribe (o se la sottoscrizione non e' riuscita),
+    // mai da una callback dello stesso token.
+    void remove(void* token);
+
+private:
+    struct Registered
+    {
+        void* target;
+        int calls;              // callback in corso
+    };
+
+    CallbackRegistry();
+    CallbackRegistry(const CallbackRegistry&);
+    CallbackRegistry& operator=(const CallbackRegistry&);
+
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    std::map<uintptr_t, Registered> targets_;
+    uintptr_t next_;
+};
+
+#endif // CALLBACK_REGISTRY_H
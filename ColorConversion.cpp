@@ -0,0 +1,174 @@
+#include "ColorConversion.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include "ColorKernels.h"
+
+using namespace std;
+
+namespace
+{
+    struct LayoutName
+    {
+        const char* prefix;         // tipo, inchiostri e bit per pixel della rasterConfig
+        RasterLayout layout;
+    };
+
+    const LayoutName LAYOUTS[] =
+    {
+        { "CHUNKY-XRGB-32-", RASTER_LAYOUT_XRGB },
+        { "CHUNKY-XBGR-32-", RASTER_LAYOUT_XBGR },
+        { "CHUNKY-RGBX-32-", RASTER_LAYOUT_RGBX },
+        { "CHUNKY-BGRX-32-", RASTER_LAYOUT_BGRX },
+        { "CHUNKY-CMYK-32-", RASTER_LAYOUT_CMYK },
+        { "CHUNKY-KCMY-32-", RASTER_LAYOUT_KCMY },
+        { "PLANAR-CMYK-8-",  RASTER_LAYOUT_PLANAR_CMYK },
+        { "PLANAR-KCMY-8-",  RASTER_LAYOUT_PLANAR_KCMY },
+    };
+
+    // Pixel convertiti in CMYK a 4 byte prima di separarli nei piani: il
+    // blocco resta nella cache L1
+    const size_t PLANAR_CHUNK_PIXELS = 512;
+
+    struct Kernels
+    {
+        ConvertKernel convert;
+        SplitKernel split;
+    };
+
+    // Indicizzata per SimdLevel
+#ifdef COLOR_KERNELS_X86
+    const Kernels KERNELS[] =
+    {
+        { convertPixelsScalar, splitPlanesScalar },
+        { convertPixelsSsse3,  splitPlanesSsse3 },
+        { convertPixelsAvx2,   splitPlanesAvx2 },
+        { convertPixelsAvx512, splitPlanesAvx512 },
+    };
+#else
+    const Kernels KERNELS[] =
+    {
+        { convertPixelsScalar, splitPlanesScalar },
+        { convertPixelsScalar, splitPlanesScalar },
+        { convertPixelsScalar, splitPlanesScalar },
+        { convertPixelsScalar, splitPlanesScalar },
+    };
+#endif
+
+    const char* const LEVEL_NAMES[] = { "scalar", "ssse3", "avx2", "avx512" };
+
+    atomic<int>& selectedLevel()
+    {
+        static atomic<int> level((int)detectedSimdLevel());
+        return level;
+    }
+
+    const Kernels& kernels()
+    {
+        return KERNELS[selectedLevel().load(memory_order_relaxed)];
+    }
+}
+
+size_t sourceBytesPerPixel(SourceFormat format)
+{
+    return format == SOURCE_RGBA8 ? 4 : 3;
+}
+
+RasterLayout parseRasterLayout(const char* rasterConfig)
+{
+    if (rasterConfig == NULL)
+    {
+        return RASTER_LAYOUT_UNSUPPORTED;
+    }
+    for (size_t i = 0; i < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); i++)
+    {
+        if (strncmp(rasterConfig, LAYOUTS[i].prefix, strlen(LAYOUTS[i].prefix)) == 0)
+        {
+            return LAYOUTS[i].layout;
+        }
+    }
+    return RASTER_LAYOUT_UNSUPPORTED;
+}
+
+size_t rasterPlanes(RasterLayout layout)
+{
+    return layout == RASTER_LAYOUT_PLANAR_CMYK || layout == RASTER_LAYOUT_PLANAR_KCMY ? 4 : 1;
+}
+
+size_t rasterBytesPerPixel(RasterLayout layout)
+{
+    return rasterPlanes(layout) == 1 ? 4 : 1;
+}
+
+void convertPixels(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels)
+{
+    if (layout == RASTER_LAYOUT_UNSUPPORTED || rasterPlanes(layout) != 1)
+    {
+        return;
+    }
+    kernels().convert(source, layout, in, out, pixels);
+}
+
+void convertRow(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* const* planes, size_t pixels)
+{
+    if (layout == RASTER_LAYOUT_UNSUPPORTED)
+    {
+        return;
+    }
+    const Kernels& selected = kernels();
+    if (rasterPlanes(layout) == 1)
+    {
+        selected.convert(source, layout, in, planes[0], pixels);
+        return;
+    }
+    const uint8_t* order = channelOrder(layout);
+    const size_t step = sourceBytesPerPixel(source);
+    uint8_t chunk[PLANAR_CHUNK_PIXELS * 4];
+    for (size_t done = 0; done < pixels; done += PLANAR_CHUNK_PIXELS)
+    {
+        const size_t count = min(PLANAR_CHUNK_PIXELS, pixels - done);
+        selected.convert(source, RASTER_LAYOUT_CMYK, in + done * step, chunk, count);
+        uint8_t* targets[4];
+        for (size_t c = 0; c < 4; c++)
+        {
+            targets[c] = planes[order[c]] + done;
+        }
+        selected.split(chunk, targets, count);
+    }
+}
+
+void splitPlanes(const uint8_t* in, uint8_t* const* planes, size_t pixels)
+{
+    kernels().split(in, planes, pixels);
+}
+
+SimdLevel detectedSimdLevel()
+{
+#ifdef COLOR_KERNELS_X86
+    static const SimdLevel detected = detectCpuSimdLevel();
+    return detected;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+SimdLevel simdLevel()
+{
+    return (SimdLevel)selectedLevel().load(memory_order_relaxed);
+}
+
+bool setSimdLevel(SimdLevel level)
+{
+    if (level < SIMD_SCALAR || level > detectedSimdLevel())
+    {
+        return false;
+    }
+    selectedLevel().store((int)level, memory_order_relaxed);
+    return true;
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    return level >= SIMD_SCALAR && level <= SIMD_AVX512 ? LEVEL_NAMES[level] : "unknown";
+}
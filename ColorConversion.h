@@ -0,0 +1,72 @@
+#ifndef COLOR_CONVERSION_H
+#define COLOR_CONVERSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pixel delle immagini lette (vedi RasterSource).
+enum SourceFormat
+{
+    SOURCE_RGB8,        // R, G, B
+    SOURCE_RGBA8        // R, G, B, A
+};
+
+// Disposizione dei pixel chiesta dalla rasterConfig. Le CHUNKY a 32 bit
+// ("CHUNKY-XRGB-32-600-PCL3_TAOS") hanno 4 byte per pixel: X e' il byte
+// inutilizzato, riceve l'alfa delle immagini RGBA e 0xFF altrimenti. Le
+// PLANAR a 8 bit ("PLANAR-KCMY-8-...") hanno un piano da 1 byte per pixel per
+// ciascun inchiostro, nell'ordine del nome.
+enum RasterLayout
+{
+    RASTER_LAYOUT_XRGB,
+    RASTER_LAYOUT_XBGR,
+    RASTER_LAYOUT_RGBX,
+    RASTER_LAYOUT_BGRX,
+    RASTER_LAYOUT_CMYK,
+    RASTER_LAYOUT_KCMY,
+    RASTER_LAYOUT_PLANAR_CMYK,
+    RASTER_LAYOUT_PLANAR_KCMY,
+    RASTER_LAYOUT_UNSUPPORTED
+};
+
+// Istruzioni vettoriali usate dalle conversioni, in ordine crescente.
+enum SimdLevel
+{
+    SIMD_SCALAR,
+    SIMD_SSSE3,
+    SIMD_AVX2,
+    SIMD_AVX512         // AVX-512 F e BW
+};
+
+size_t sourceBytesPerPixel(SourceFormat format);
+
+// RASTER_LAYOUT_UNSUPPORTED per le rasterConfig che il wrapper non sa
+// produrre (halftone, CHUNKY non a 32 bit, piani diversi da CMYK, ...).
+RasterLayout parseRasterLayout(const char* rasterConfig);
+
+// 1 per le disposizioni CHUNKY, 4 per quelle PLANAR.
+size_t rasterPlanes(RasterLayout layout);
+// Byte per pixel di ciascun piano.
+size_t rasterBytesPerPixel(RasterLayout layout);
+
+// Converte pixels pixel da in (formato source) a out (4 byte per pixel, solo
+// disposizioni CHUNKY). Il CMYK e' la conversione ingenua con rimozione del
+// sottocolore: K = min(255-R, 255-G, 255-B), C = 255-R-K, M = 255-G-K, Y = 255-B-K.
+void convertPixels(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels);
+
+// Converte una riga in qualsiasi disposizione: planes ha rasterPlanes(layout)
+// puntatori, ciascuno a pixels * rasterBytesPerPixel(layout) byte.
+void convertRow(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* const* planes, size_t pixels);
+
+// Separa pixel da 4 byte in 4 piani: planes[i] riceve il byte i di ogni pixel.
+void splitPlanes(const uint8_t* in, uint8_t* const* planes, size_t pixels);
+
+// Le conversioni usano il livello piu' alto supportato da CPU e sistema
+// operativo, rilevato alla prima chiamata. setSimdLevel lo abbassa (per
+// confronti e benchmark); false se la CPU non supporta level.
+SimdLevel detectedSimdLevel();
+SimdLevel simdLevel();
+bool setSimdLevel(SimdLevel level);
+const char* simdLevelName(SimdLevel level);
+
+#endif // COLOR_CONVERSION_H
@@ -0,0 +1,424 @@
+#include "ColorKernels.h"
+
+#include <algorithm>
+
+#ifdef COLOR_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC compila gli intrinseci di qualsiasi livello; GCC e Clang li accettano
+// solo nelle funzioni marcate con il livello
+#ifdef _MSC_VER
+#define KERNEL_TARGET(isa)
+#else
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+using namespace std;
+
+namespace
+{
+    const uint8_t ORDER[RASTER_LAYOUT_UNSUPPORTED][4] =
+    {
+        { 1, 2, 3, 0 },     // XRGB
+        { 3, 2, 1, 0 },     // XBGR
+        { 0, 1, 2, 3 },     // RGBX
+        { 2, 1, 0, 3 },     // BGRX
+        { 0, 1, 2, 3 },     // CMYK
+        { 1, 2, 3, 0 },     // KCMY
+        { 0, 1, 2, 3 },     // PLANAR CMYK
+        { 1, 2, 3, 0 },     // PLANAR KCMY
+    };
+
+    bool isCmyk(RasterLayout layout)
+    {
+        return layout == RASTER_LAYOUT_CMYK || layout == RASTER_LAYOUT_KCMY;
+    }
+
+#ifdef COLOR_KERNELS_X86
+    // Byte in piu' letti oltre l'ultimo pixel convertito: i registri si
+    // caricano 16 byte alla volta ma 4 pixel RGB ne occupano 12
+    const size_t RGB_OVERREAD = 4;
+
+    // Pixel che le versioni vettoriali possono convertire senza leggere oltre in
+    size_t vectorPixels(SourceFormat source, size_t pixels)
+    {
+        if (source == SOURCE_RGBA8)
+        {
+            return pixels;
+        }
+        // 3 * (pixel convertiti) + RGB_OVERREAD <= 3 * pixels
+        return pixels > 1 ? pixels - 2 : 0;
+    }
+
+    // Maschera per pshufb che porta 4 pixel della sorgente nei 16 byte di
+    // uscita, e byte da aggiungere con or (lo 0xFF di X senza alfa). Per il
+    // CMYK i registri ricevono R, G, B, 0 e l'ordine lo decide ucr.
+    void shuffleMasks(SourceFormat source, RasterLayout layout, uint8_t mask[16], uint8_t fill[16])
+    {
+        const bool cmyk = isCmyk(layout);
+        const bool alpha = source == SOURCE_RGBA8 && !cmyk;
+        const uint8_t step = (uint8_t)sourceBytesPerPixel(source);
+        const uint8_t* order = ORDER[cmyk ? RASTER_LAYOUT_RGBX : layout];
+        for (uint8_t p = 0; p < 4; p++)
+        {
+            for (uint8_t c = 0; c < 3; c++)
+            {
+                mask[4 * p + order[c]] = (uint8_t)(step * p + c);
+                fill[4 * p + order[c]] = 0;
+            }
+            mask[4 * p + order[3]] = alpha ? (uint8_t)(step * p + 3) : 0x80;
+            fill[4 * p + order[3]] = alpha || cmyk ? 0 : 0xFF;
+        }
+    }
+
+    void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+    {
+#ifdef _MSC_VER
+        int values[4];
+        __cpuidex(values, (int)leaf, (int)subleaf);
+        for (int i = 0; i < 4; i++)
+        {
+            regs[i] = (unsigned int)values[i];
+        }
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    // Registri salvati dal sistema operativo al cambio di contesto (XCR0)
+    unsigned long long xgetbv()
+    {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        unsigned int low, high;
+        __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        return ((unsigned long long)high << 32) | low;
+#endif
+    }
+
+    // C, M, Y, K da pixel R, G, B, 0 in ogni parola da 32 bit, come lo scalare
+    KERNEL_TARGET("ssse3") inline __m128i ucrSsse3(__m128i rgb, bool kFirst)
+    {
+        __m128i inv = _mm_xor_si128(rgb, _mm_set1_epi32(0x00FFFFFF));
+        __m128i k = _mm_min_epu8(inv, _mm_srli_epi32(inv, 8));
+        k = _mm_and_si128(_mm_min_epu8(k, _mm_srli_epi32(inv, 16)), _mm_set1_epi32(0xFF));
+        __m128i cmy = _mm_sub_epi8(inv, _mm_or_si128(k, _mm_or_si128(_mm_slli_epi32(k, 8), _mm_slli_epi32(k, 16))));
+        return kFirst ? _mm_or_si128(_mm_slli_epi32(cmy, 8), k) : _mm_or_si128(cmy, _mm_slli_epi32(k, 24));
+    }
+
+    KERNEL_TARGET("avx2") inline __m256i ucrAvx2(__m256i rgb, bool kFirst)
+    {
+        __m256i inv = _mm256_xor_si256(rgb, _mm256_set1_epi32(0x00FFFFFF));
+        __m256i k = _mm256_min_epu8(inv, _mm256_srli_epi32(inv, 8));
+        k = _mm256_and_si256(_mm256_min_epu8(k, _mm256_srli_epi32(inv, 16)), _mm256_set1_epi32(0xFF));
+        __m256i cmy = _mm256_sub_epi8(inv, _mm256_or_si256(k, _mm256_or_si256(_mm256_slli_epi32(k, 8), _mm256_slli_epi32(k, 16))));
+        return kFirst ? _mm256_or_si256(_mm256_slli_epi32(cmy, 8), k) : _mm256_or_si256(cmy, _mm256_slli_epi32(k, 24));
+    }
+
+    KERNEL_TARGET("avx512f,avx512bw") inline __m512i ucrAvx512(__m512i rgb, bool kFirst)
+    {
+        __m512i inv = _mm512_xor_si512(rgb, _mm512_set1_epi32(0x00FFFFFF));
+        __m512i k = _mm512_min_epu8(inv, _mm512_srli_epi32(inv, 8));
+        k = _mm512_and_si512(_mm512_min_epu8(k, _mm512_srli_epi32(inv, 16)), _mm512_set1_epi32(0xFF));
+        __m512i cmy = _mm512_sub_epi8(inv, _mm512_or_si512(k, _mm512_or_si512(_mm512_slli_epi32(k, 8), _mm512_slli_epi32(k, 16))));
+        return kFirst ? _mm512_or_si512(_mm512_slli_epi32(cmy, 8), k) : _mm512_or_si512(cmy, _mm512_slli_epi32(k, 24));
+    }
+
+    // 4 pixel RGB o RGBA da in, uno per parola da 32 bit
+    KERNEL_TARGET("ssse3") inline __m128i loadSsse3(const uint8_t* in)
+    {
+        return _mm_loadu_si128((const __m128i*)in);
+    }
+
+    // 8 pixel, 4 per corsia da 128 bit
+    KERNEL_TARGET("avx2") inline __m256i loadAvx2(const uint8_t* in, size_t step)
+    {
+        if (step == 4)
+        {
+            return _mm256_loadu_si256((const __m256i*)in);
+        }
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)in)),
+                                       _mm_loadu_si128((const __m128i*)(in + 12)), 1);
+    }
+
+    // 16 pixel, 4 per corsia da 128 bit
+    KERNEL_TARGET("avx512f,avx512bw") inline __m512i loadAvx512(const uint8_t* in, size_t step)
+    {
+        if (step == 4)
+        {
+            return _mm512_loadu_si512((const void*)in);
+        }
+        __m512i v = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)in));
+        v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(in + 12)), 1);
+        v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(in + 24)), 2);
+        return _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(in + 36)), 3);
+    }
+
+    // Trasposizione di 4 registri da 4 parole: la parola i del registro j va
+    // nella parola j del registro i
+    KERNEL_TARGET("ssse3") inline void transposeSsse3(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+    {
+        __m128i ab0 = _mm_unpacklo_epi32(a, b);
+        __m128i cd0 = _mm_unpacklo_epi32(c, d);
+        __m128i ab1 = _mm_unpackhi_epi32(a, b);
+        __m128i cd1 = _mm_unpackhi_epi32(c, d);
+        a = _mm_unpacklo_epi64(ab0, cd0);
+        b = _mm_unpackhi_epi64(ab0, cd0);
+        c = _mm_unpacklo_epi64(ab1, cd1);
+        d = _mm_unpackhi_epi64(ab1, cd1);
+    }
+
+    KERNEL_TARGET("avx2") inline void transposeAvx2(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+    {
+        __m256i ab0 = _mm256_unpacklo_epi32(a, b);
+        __m256i cd0 = _mm256_unpacklo_epi32(c, d);
+        __m256i ab1 = _mm256_unpackhi_epi32(a, b);
+        __m256i cd1 = _mm256_unpackhi_epi32(c, d);
+        a = _mm256_unpacklo_epi64(ab0, cd0);
+        b = _mm256_unpackhi_epi64(ab0, cd0);
+        c = _mm256_unpacklo_epi64(ab1, cd1);
+        d = _mm256_unpackhi_epi64(ab1, cd1);
+    }
+
+    KERNEL_TARGET("avx512f,avx512bw") inline void transposeAvx512(__m512i& a, __m512i& b, __m512i& c, __m512i& d)
+    {
+        __m512i ab0 = _mm512_unpacklo_epi32(a, b);
+        __m512i cd0 = _mm512_unpacklo_epi32(c, d);
+        __m512i ab1 = _mm512_unpackhi_epi32(a, b);
+        __m512i cd1 = _mm512_unpackhi_epi32(c, d);
+        a = _mm512_unpacklo_epi64(ab0, cd0);
+        b = _mm512_unpackhi_epi64(ab0, cd0);
+        c = _mm512_unpacklo_epi64(ab1, cd1);
+        d = _mm512_unpackhi_epi64(ab1, cd1);
+    }
+
+    // Raggruppa i byte di ogni pixel per canale: nella parola c i canali c di 4 pixel
+    const uint8_t GATHER[16] = { 0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15 };
+#endif
+}
+
+const uint8_t* channelOrder(RasterLayout layout)
+{
+    return ORDER[layout];
+}
+
+void convertPixelsScalar(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels)
+{
+    const uint8_t* order = ORDER[layout];
+    const size_t step = sourceBytesPerPixel(source);
+    const bool alpha = source == SOURCE_RGBA8;
+    const bool cmyk = isCmyk(layout);
+    for (size_t i = 0; i < pixels; i++, in += step, out += 4)
+    {
+        uint8_t r = in[0];
+        uint8_t g = in[1];
+        uint8_t b = in[2];
+        if (cmyk)
+        {
+            uint8_t c = (uint8_t)(255 - r);
+            uint8_t m = (uint8_t)(255 - g);
+            uint8_t y = (uint8_t)(255 - b);
+            uint8_t k = min(c, min(m, y));
+            out[order[0]] = (uint8_t)(c - k);
+            out[order[1]] = (uint8_t)(m - k);
+            out[order[2]] = (uint8_t)(y - k);
+            out[order[3]] = k;
+        }
+        else
+        {
+            out[order[0]] = r;
+            out[order[1]] = g;
+            out[order[2]] = b;
+            out[order[3]] = alpha ? in[3] : 0xFF;
+        }
+    }
+}
+
+void splitPlanesScalar(const uint8_t* in, uint8_t* const* planes, size_t pixels)
+{
+    uint8_t* p0 = planes[0];
+    uint8_t* p1 = planes[1];
+    uint8_t* p2 = planes[2];
+    uint8_t* p3 = planes[3];
+    for (size_t i = 0; i < pixels; i++, in += 4)
+    {
+        p0[i] = in[0];
+        p1[i] = in[1];
+        p2[i] = in[2];
+        p3[i] = in[3];
+    }
+}
+
+#ifdef COLOR_KERNELS_X86
+SimdLevel detectCpuSimdLevel()
+{
+    unsigned int regs[4];
+    cpuid(0, 0, regs);
+    const unsigned int maxLeaf = regs[0];
+    if (maxLeaf < 1)
+    {
+        return SIMD_SCALAR;
+    }
+    cpuid(1, 0, regs);
+    const unsigned int features = regs[2];
+    if ((features & (1u << 9)) == 0)
+    {
+        return SIMD_SCALAR;
+    }
+    // AVX richiede anche che il sistema salvi i registri YMM (OSXSAVE, XCR0)
+    const bool osxsave = (features & (1u << 27)) != 0 && (features & (1u << 28)) != 0;
+    const unsigned long long xcr0 = osxsave ? xgetbv() : 0;
+    if (maxLeaf < 7 || (xcr0 & 0x6) != 0x6)
+    {
+        return SIMD_SSSE3;
+    }
+    cpuid(7, 0, regs);
+    const unsigned int extended = regs[1];
+    if ((extended & (1u << 5)) == 0)
+    {
+        return SIMD_SSSE3;
+    }
+    // AVX-512 F (bit 16) e BW (bit 30), con opmask e ZMM salvati
+    if ((extended & (1u << 16)) == 0 || (extended & (1u << 30)) == 0 || (xcr0 & 0xE6) != 0xE6)
+    {
+        return SIMD_AVX2;
+    }
+    return SIMD_AVX512;
+}
+
+KERNEL_TARGET("ssse3") void convertPixelsSsse3(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels)
+{
+    uint8_t maskBytes[16];
+    uint8_t fillBytes[16];
+    shuffleMasks(source, layout, maskBytes, fillBytes);
+    const __m128i mask = _mm_loadu_si128((const __m128i*)maskBytes);
+    const __m128i fill = _mm_loadu_si128((const __m128i*)fillBytes);
+    const size_t step = sourceBytesPerPixel(source);
+    const size_t limit = vectorPixels(source, pixels);
+    const bool cmyk = isCmyk(layout);
+    const bool kFirst = layout == RASTER_LAYOUT_KCMY;
+    size_t done = 0;
+    for (; done + 4 <= limit; done += 4)
+    {
+        __m128i v = _mm_shuffle_epi8(loadSsse3(in + done * step), mask);
+        v = cmyk ? ucrSsse3(v, kFirst) : _mm_or_si128(v, fill);
+        _mm_storeu_si128((__m128i*)(out + done * 4), v);
+    }
+    convertPixelsScalar(source, layout, in + done * step, out + done * 4, pixels - done);
+}
+
+KERNEL_TARGET("avx2") void convertPixelsAvx2(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels)
+{
+    uint8_t maskBytes[16];
+    uint8_t fillBytes[16];
+    shuffleMasks(source, layout, maskBytes, fillBytes);
+    const __m256i mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)maskBytes));
+    const __m256i fill = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)fillBytes));
+    const size_t step = sourceBytesPerPixel(source);
+    const size_t limit = vectorPixels(source, pixels);
+    const bool cmyk = isCmyk(layout);
+    const bool kFirst = layout == RASTER_LAYOUT_KCMY;
+    size_t done = 0;
+    for (; done + 8 <= limit; done += 8)
+    {
+        __m256i v = _mm256_shuffle_epi8(loadAvx2(in + done * step, step), mask);
+        v = cmyk ? ucrAvx2(v, kFirst) : _mm256_or_si256(v, fill);
+        _mm256_storeu_si256((__m256i*)(out + done * 4), v);
+    }
+    convertPixelsScalar(source, layout, in + done * step, out + done * 4, pixels - done);
+}
+
+KERNEL_TARGET("avx512f,avx512bw") void convertPixelsAvx512(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels)
+{
+    uint8_t maskBytes[16];
+    uint8_t fillBytes[16];
+    shuffleMasks(source, layout, maskBytes, fillBytes);
+    const __m512i mask = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)maskBytes));
+    const __m512i fill = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)fillBytes));
+    const size_t step = sourceBytesPerPixel(source);
+    const size_t limit = vectorPixels(source, pixels);
+    const bool cmyk = isCmyk(layout);
+    const bool kFirst = layout == RASTER_LAYOUT_KCMY;
+    size_t done = 0;
+    for (; done + 16 <= limit; done += 16)
+    {
+        __m512i v = _mm512_shuffle_epi8(loadAvx512(in + done * step, step), mask);
+        v = cmyk ? ucrAvx512(v, kFirst) : _mm512_or_si512(v, fill);
+        _mm512_storeu_si512((void*)(out + done * 4), v);
+    }
+    convertPixelsScalar(source, layout, in + done * step, out + done * 4, pixels - done);
+}
+
+KERNEL_TARGET("ssse3") void splitPlanesSsse3(const uint8_t* in, uint8_t* const* planes, size_t pixels)
+{
+    const __m128i gather = _mm_loadu_si128((const __m128i*)GATHER);
+    size_t done = 0;
+    for (; done + 16 <= pixels; done += 16)
+    {
+        const uint8_t* block = in + done * 4;
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)block), gather);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + 16)), gather);
+        __m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + 32)), gather);
+        __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + 48)), gather);
+        transposeSsse3(a, b, c, d);
+        _mm_storeu_si128((__m128i*)(planes[0] + done), a);
+        _mm_storeu_si128((__m128i*)(planes[1] + done), b);
+        _mm_storeu_si128((__m128i*)(planes[2] + done), c);
+        _mm_storeu_si128((__m128i*)(planes[3] + done), d);
+    }
+    uint8_t* rest[4] = { planes[0] + done, planes[1] + done, planes[2] + done, planes[3] + done };
+    splitPlanesScalar(in + done * 4, rest, pixels - done);
+}
+
+KERNEL_TARGET("avx2") void splitPlanesAvx2(const uint8_t* in, uint8_t* const* planes, size_t pixels)
+{
+    const __m256i gather = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)GATHER));
+    // Dopo la trasposizione per corsia le parole sono in ordine 0, 2, 4, 6, 1, 3, 5, 7
+    const __m256i reorder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t done = 0;
+    for (; done + 32 <= pixels; done += 32)
+    {
+        const uint8_t* block = in + done * 4;
+        __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)block), gather);
+        __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(block + 32)), gather);
+        __m256i c = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(block + 64)), gather);
+        __m256i d = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(block + 96)), gather);
+        transposeAvx2(a, b, c, d);
+        _mm256_storeu_si256((__m256i*)(planes[0] + done), _mm256_permutevar8x32_epi32(a, reorder));
+        _mm256_storeu_si256((__m256i*)(planes[1] + done), _mm256_permutevar8x32_epi32(b, reorder));
+        _mm256_storeu_si256((__m256i*)(planes[2] + done), _mm256_permutevar8x32_epi32(c, reorder));
+        _mm256_storeu_si256((__m256i*)(planes[3] + done), _mm256_permutevar8x32_epi32(d, reorder));
+    }
+    uint8_t* rest[4] = { planes[0] + done, planes[1] + done, planes[2] + done, planes[3] + done };
+    splitPlanesScalar(in + done * 4, rest, pixels - done);
+}
+
+KERNEL_TARGET("avx512f,avx512bw") void splitPlanesAvx512(const uint8_t* in, uint8_t* const* planes, size_t pixels)
+{
+    const __m512i gather = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)GATHER));
+    const __m512i reorder = _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    size_t done = 0;
+    for (; done + 64 <= pixels; done += 64)
+    {
+        const uint8_t* block = in + done * 4;
+        __m512i a = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)block), gather);
+        __m512i b = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)(block + 64)), gather);
+        __m512i c = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)(block + 128)), gather);
+        __m512i d = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)(block + 192)), gather);
+        transposeAvx512(a, b, c, d);
+        _mm512_storeu_si512((void*)(planes[0] + done), _mm512_permutexvar_epi32(reorder, a));
+        _mm512_storeu_si512((void*)(planes[1] + done), _mm512_permutexvar_epi32(reorder, b));
+        _mm512_storeu_si512((void*)(planes[2] + done), _mm512_permutexvar_epi32(reorder, c));
+        _mm512_storeu_si512((void*)(planes[3] + done), _mm512_permutexvar_epi32(reorder, d));
+    }
+    uint8_t* rest[4] = { planes[0] + done, planes[1] + done, planes[2] + done, planes[3] + done };
+    splitPlanesScalar(in + done * 4, rest, pixels - done);
+}
+#endif
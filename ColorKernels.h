@@ -0,0 +1,37 @@
+#ifndef COLOR_KERNELS_H
+#define COLOR_KERNELS_H
+
+#include "ColorConversion.h"
+
+// Implementazioni di convertPixels e splitPlanes per ciascun SimdLevel, scelte
+// da ColorConversion. Le versioni vettoriali lavorano sulla parte della riga
+// che riempie i registri e lasciano il resto a quelle scalari, quindi danno
+// gli stessi byte. Sono compilate solo per x86: altrove resta lo scalare.
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define COLOR_KERNELS_X86
+#endif
+
+typedef void (*ConvertKernel)(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels);
+typedef void (*SplitKernel)(const uint8_t* in, uint8_t* const* planes, size_t pixels);
+
+// Posizione di ciascun canale: R, G, B, X oppure C, M, Y, K. Per le
+// disposizioni PLANAR e' il piano di ciascun inchiostro.
+const uint8_t* channelOrder(RasterLayout layout);
+
+void convertPixelsScalar(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels);
+void splitPlanesScalar(const uint8_t* in, uint8_t* const* planes, size_t pixels);
+
+#ifdef COLOR_KERNELS_X86
+// Livello supportato da CPU (cpuid) e sistema operativo (xgetbv).
+SimdLevel detectCpuSimdLevel();
+
+void convertPixelsSsse3(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels);
+void convertPixelsAvx2(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels);
+void convertPixelsAvx512(SourceFormat source, RasterLayout layout, const uint8_t* in, uint8_t* out, size_t pixels);
+void splitPlanesSsse3(const uint8_t* in, uint8_t* const* planes, size_t pixels);
+void splitPlanesAvx2(const uint8_t* in, uint8_t* const* planes, size_t pixels);
+void splitPlanesAvx512(const uint8_t* in, uint8_t* const* planes, size_t pixels);
+#endif
+
+#endif // COLOR_KERNELS_H
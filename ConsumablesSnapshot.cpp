@@ -0,0 +1,105 @@
+#include "ConsumablesSnapshot.h"
+
+#include <condition_variable>
+#include <mutex>
+#include "StatusQueries.h"
+#include "ThreadPool.h"
+#include "XmlUtil.h"
+
+using namespace std;
+
+namespace
+{
+    // Riletture delle viste scadute, condivise da tutte le stampanti.
+    // Come FleetPoller non viene mai distrutto.
+    ThreadPool& refreshPool()
+    {
+        static ThreadPool* pool = new ThreadPool(STATUS_KIND_COUNT);
+        return *pool;
+    }
+
+    HPLFPSDK::Types::Result readKind(StatusCache& cache, StatusKind kind, shared_ptr<const string>& xml)
+    {
+        try
+        {
+            return cache.get(kind, xml);
+        }
+        catch (exception)
+        {
+            return HPLFPSDK::Types::RESULT_ERROR;
+        }
+    }
+}
+
+HPLFPSDK::Types::Result getConsumablesSnapshot(StatusCache& cache, string& snapshot)
+{
+    HPLFPSDK::Types::Result results[STATUS_KIND_COUNT];
+    shared_ptr<const string> values[STATUS_KIND_COUNT];
+
+    // Le viste gia' in cache (sottoscritte) non interrogano la stampante; quelle
+    // da rileggere partono insieme sul pool invece di una dopo l'altra, e la
+    // prima viene letta da questo thread
+    int stale[STATUS_KIND_COUNT];
+    int staleCount = 0;
+    for (int kind = 0; kind < STATUS_KIND_COUNT; kind++)
+    {
+        if (cache.fresh((StatusKind)kind))
+        {
+            results[kind] = readKind(cache, (StatusKind)kind, values[kind]);
+        }
+        else
+        {
+            stale[staleCount++] = kind;
+        }
+    }
+    mutex doneMutex;
+    condition_variable done;
+    int pending = staleCount > 1 ? staleCount - 1 : 0;
+    for (int i = 1; i < staleCount; i++)
+    {
+        int kind = stale[i];
+        refreshPool().post([&cache, &results, &values, &doneMutex, &done, &pending, kind]()
+        {
+            results[kind] = readKind(cache, (StatusKind)kind, values[kind]);
+            lock_guard<mutex> lock(doneMutex);
+            if (--pending == 0)
+            {
+                done.notify_all();
+            }
+        });
+    }
+    if (staleCount > 0)
+    {
+        results[stale[0]] = readKind(cache, (StatusKind)stale[0], values[stale[0]]);
+    }
+    {
+        // I task usano variabili di questo frame: si esce solo quando sono finiti
+        unique_lock<mutex> lock(doneMutex);
+        done.wait(lock, [&pending] { return pending == 0; });
+    }
+
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_OK;
+    bool read = false;
+    snapshot = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<ConsumablesSnapshot>\n";
+    for (int kind = 0; kind < STATUS_KIND_COUNT; kind++)
+    {
+        HPLFPSDK::Types::Result kindResult = results[kind];
+        snapshot += "<Status name=\"";
+        snapshot += statusQueryInfo((StatusKind)kind).name;
+        snapshot += "\" result=\"";
+        snapshot += to_string((unsigned int)kindResult);
+        snapshot += "\">";
+        if (kindResult == HPLFPSDK::Types::RESULT_OK && values[kind])
+        {
+            appendXmlBody(snapshot, values[kind]->data(), values[kind]->size());
+            read = true;
+        }
+        else if (result == HPLFPSDK::Types::RESULT_OK)
+        {
+            result = kindResult == HPLFPSDK::Types::RESULT_OK ? HPLFPSDK::Types::RESULT_ERROR_EMPTY_RESPONSE : kindResult;
+        }
+        snapshot += "</Status>\n";
+    }
+    snapshot += "</ConsumablesSnapshot>\n";
+    return read ? HPLFPSDK::Types::RESULT_OK : result;
+}
@@ -0,0 +1,23 @@
+#ifndef CONSUMABLES_SNAPSHOT_H
+#define CONSUMABLES_SNAPSHOT_H
+
+#include <string>
+#include "IHplfpsdk.h"
+#include "StatusCache.h"
+
+// Legge dalla cache di stato del device tutte le viste dei consumabili
+// (inchiostri, testine, cartucce di manutenzione, serbatoi, raccoglitori, kit
+// airflow) e le unisce in un unico documento. Le viste scadute o mai lette
+// vengono rilette in parallelo:
+//
+// <ConsumablesSnapshot>
+//   <Status name="InkSystem" result="0"> ...XML dell'SDK... </Status>
+//   ...
+// </ConsumablesSnapshot>
+//
+// Le viste che falliscono compaiono vuote con il loro codice di errore.
+// Restituisce RESULT_OK se almeno una vista e' stata letta, altrimenti
+// l'errore della prima (RESULT_ERROR_NOT_YET_INITIALIZED compreso).
+HPLFPSDK::Types::Result getConsumablesSnapshot(StatusCache& cache, std::string& snapshot);
+
+#endif // CONSUMABLES_SNAPSHOT_H
@@ -0,0 +1,284 @@
+#include "DeltaEngine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include "XmlPullParser.h"
+#include "XmlUtil.h"
+
+using namespace std;
+
+namespace
+{
+    bool byPath(const StatusField& a, const StatusField& b)
+    {
+        return a.path < b.path;
+    }
+
+    // Figli gia' incontrati di un elemento aperto, per numerare gli omonimi.
+    struct Level
+    {
+        explicit Level(size_t pathLength) : pathLength(pathLength) {}
+
+        size_t pathLength;
+        vector<pair<string_view, int> > children;
+    };
+
+    int childIndex(Level& parent, string_view name)
+    {
+        for (size_t i = 0; i < parent.children.size(); i++)
+        {
+            if (parent.children[i].first == name)
+            {
+                return ++parent.children[i].second;
+            }
+        }
+        parent.children.push_back(make_pair(name, 1));
+        return 1;
+    }
+
+    void appendField(vector<StatusField>& fields, const string& path, string_view value)
+    {
+        fields.push_back(StatusField());
+        fields.back().path = path;
+        appendXmlDecoded(fields.back().value, value);
+    }
+
+    // Campi di before e after confrontati per percorso (entrambi ordinati).
+    void diff(const vector<StatusField>& before, const vector<StatusField>& after,
+              vector<StatusField>& changed, vector<string>& removed)
+    {
+        size_t i = 0;
+        size_t j = 0;
+        while (i < before.size() || j < after.size())
+        {
+            if (j == after.size() || (i < before.size() && before[i].path < after[j].path))
+            {
+                removed.push_back(before[i++].path);
+            }
+            else if (i == before.size() || after[j].path < before[i].path)
+            {
+                changed.push_back(after[j++]);
+            }
+            else
+            {
+                if (before[i].value != after[j].value)
+                {
+                    changed.push_back(after[j]);
+                }
+                i++;
+                j++;
+            }
+        }
+    }
+}
+
+void flattenStatus(const char* xml, size_t length, vector<StatusField>& fields)
+{
+    fields.clear();
+    XmlPullParser parser(xml, length);
+    string path;
+    vector<Level> levels;
+    levels.push_back(Level(0));
+    for (;;)
+    {
+        XmlPullParser::Event event = parser.next();
+        if (event == XmlPullParser::EVENT_START_ELEMENT)
+        {
+            size_t pathLength = path.size();
+            string_view name = parser.name();
+            int index = childIndex(levels.back(), name);
+            if (!path.empty())
+            {
+                path += '/';
+            }
+            path.append(name.data(), name.size());
+            string_view id;
+            if (parser.attribute("id", id))
+            {
+                path += '[';
+                appendXmlDecoded(path, id);
+                path += ']';
+            }
+            else if (index > 1)
+            {
+                path += '[';
+                path += to_string(index);
+                path += ']';
+            }
+
+            string_view attributes = parser.attributes();
+            string_view attributeName;
+            string_view attributeValue;
+            while (xmlNextAttribute(attributes, attributeName, attributeValue))
+            {
+                if (attributeName != "id")
+                {
+                    appendField(fields, path + "/@" + string(attributeName), attributeValue);
+                }
+            }
+            levels.push_back(Level(pathLength));
+        }
+        else if (event == XmlPullParser::EVENT_TEXT)
+        {
+            if (!fields.empty() && fields.back().path == path)
+            {
+                appendXmlDecoded(fields.back().value, parser.text());
+            }
+            else
+            {
+                appendField(fields, path, parser.text());
+            }
+        }
+        else if (event == XmlPullParser::EVENT_END_ELEMENT)
+        {
+            path.resize(levels.back().pathLength);
+            levels.pop_back();
+        }
+        else
+        {
+            break;
+        }
+    }
+    stable_sort(fields.begin(), fields.end(), byPath);
+}
+
+DeltaEngine::DeltaEngine()
+{
+}
+
+unsigned long long DeltaEngine::nextSequence()
+{
+    static atomic<unsigned long long> sequence((unsigned long long)chrono::duration_cast<chrono::microseconds>(
+        chrono::system_clock::now().time_since_epoch()).count());
+    return ++sequence;
+}
+
+void DeltaEngine::update(StatusKind kind, const shared_ptr<const string>& xml, unsigned long long since, StatusDelta& delta)
+{
+    lock_guard<mutex> lock(mutex_);
+    View& view = views_[kind];
+    refreshLocked(view, xml);
+    delta.kind = kind;
+    deltaLocked(view, since, delta);
+}
+
+void DeltaEngine::refreshLocked(View& view, const shared_ptr<const string>& xml)
+{
+    // La cache restituisce lo stesso documento finche' la stampante non cambia
+    if (!xml || xml == view.source)
+    {
+        return;
+    }
+    vector<StatusField> fields;
+    flattenStatus(xml->data(), xml->size(), fields);
+    view.source = xml;
+    if (view.sequence == 0)
+    {
+        view.fields.swap(fields);
+        view.sequence = nextSequence();
+        return;
+    }
+
+    Change change;
+    diff(view.fields, fields, change.changed, change.removed);
+    view.fields.swap(fields);
+    if (change.changed.empty() && change.removed.empty())
+    {
+        return;
+    }
+    change.previous = view.sequence;
+    change.sequence = nextSequence();
+    view.sequence = change.sequence;
+    view.history.push_back(std::move(change));
+    if (view.history.size() > HISTORY)
+    {
+        view.history.pop_front();
+    }
+}
+
+void DeltaEngine::deltaLocked(const View& view, unsigned long long since, StatusDelta& delta) const
+{
+    delta.from = since;
+    delta.to = view.sequence;
+    delta.resync = false;
+    delta.changed.clear();
+    delta.removed.clear();
+    if (since == view.sequence)
+    {
+        return;
+    }
+
+    size_t first = view.history.size();
+    for (size_t i = 0; i < view.history.size(); i++)
+    {
+        if (view.history[i].previous == since)
+        {
+            first = i;
+            break;
+        }
+    }
+    if (since == 0 || first == view.history.size())
+    {
+        delta.resync = true;
+        delta.changed = view.fields;
+        return;
+    }
+
+    // Modifiche successive a since fuse per percorso: vale l'ultima (NULL = rimosso)
+    map<string, const string*> merged;
+    for (size_t i = first; i < view.history.size(); i++)
+    {
+        const Change& change = view.history[i];
+        for (size_t j = 0; j < change.changed.size(); j++)
+        {
+            merged[change.changed[j].path] = &change.changed[j].value;
+        }
+        for (size_t j = 0; j < change.removed.size(); j++)
+        {
+            merged[change.removed[j]] = NULL;
+        }
+    }
+    for (map<string, const string*>::const_iterator it = merged.begin(); it != merged.end(); ++it)
+    {
+        if (it->second != NULL)
+        {
+            StatusField field;
+            field.path = it->first;
+            field.value = *it->second;
+            delta.changed.push_back(field);
+        }
+        else
+        {
+            delta.removed.push_back(it->first);
+        }
+    }
+}
+
+string DeltaEngine::toXml(const StatusDelta& delta)
+{
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<StatusDelta view=\"";
+    xml += statusQueryInfo(delta.kind).name;
+    xml += "\" from=\"";
+    xml += to_string(delta.from);
+    xml += "\" to=\"";
+    xml += to_string(delta.to);
+    xml += delta.resync ? "\" resync=\"true\">\n" : "\" resync=\"false\">\n";
+    for (size_t i = 0; i < delta.changed.size(); i++)
+    {
+        xml += "<Set path=\"";
+        appendXmlEscaped(xml, delta.changed[i].path);
+        xml += "\">";
+        appendXmlEscaped(xml, delta.changed[i].value);
+        xml += "</Set>\n";
+    }
+    for (size_t i = 0; i < delta.removed.size(); i++)
+    {
+        xml += "<Remove path=\"";
+        appendXmlEscaped(xml, delta.removed[i]);
+        xml += "\"/>\n";
+    }
+    xml += "</StatusDelta>\n";
+    return xml;
+}
@@ -0,0 +1,93 @@
+#ifndef DELTA_ENGINE_H
+#define DELTA_ENGINE_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "IHplfpsdk.h"
+#include "StatusQueries.h"
+
+// Campo di una vista di stato: percorso dalla radice e testo del documento,
+// con le entita' XML gia' decodificate.
+// Gli elementi ripetuti sono distinti dall'attributo id ("InkSlot[InkSlot0]")
+// o, in mancanza, dalla posizione tra i fratelli omonimi ("Status[2]").
+// Gli attributi diversi da id sono campi con percorso ".../@nome".
+struct StatusField
+{
+    std::string path;
+    std::string value;
+};
+
+// Scompone un documento di stato nei suoi campi, ordinati per percorso.
+void flattenStatus(const char* xml, size_t length, std::vector<StatusField>& fields);
+
+struct StatusDelta
+{
+    StatusDelta() : kind(STATUS_INK_SYSTEM), from(0), to(0), resync(false) {}
+
+    StatusKind kind;
+    unsigned long long from;    // sequenza a cui si riferisce il chiamante
+    unsigned long long to;      // sequenza della vista dopo le modifiche
+    bool resync;                // true: changed contiene l'intera vista
+    std::vector<StatusField> changed;
+    std::vector<std::string> removed;
+};
+
+// Differenze tra letture successive delle viste di stato di una stampante.
+// Per ogni vista tiene l'ultima istantanea scomposta in campi; ogni volta che
+// un documento nuovo cambia almeno un campo la vista riceve un numero di
+// sequenza crescente. Il chiamante passa l'ultima sequenza che conosce e
+// riceve solo i campi cambiati da allora; con since 0, o se la sequenza e'
+// troppo vecchia o sconosciuta, riceve l'intera vista (resync).
+//
+// Le sequenze sono uniche nel processo e partono dall'ora di avvio, cosi' una
+// sequenza ottenuta prima di un riavvio della DLL, o prima che la sessione
+// scartasse il device (e il suo motore), porta sempre a un resync.
+class DeltaEngine
+{
+public:
+    DeltaEngine();
+
+    // Registra xml come documento attuale della vista e riporta in delta le
+    // modifiche rispetto alla sequenza since.
+    void update(StatusKind kind, const std::shared_ptr<const std::string>& xml, unsigned long long since, StatusDelta& delta);
+
+    static std::string toXml(const StatusDelta& delta);
+
+    // Modifiche conservate per vista: chi resta indietro di piu' riceve un resync.
+    enum { HISTORY = 64 };
+
+private:
+    struct Change
+    {
+        unsigned long long previous;
+        unsigned long long sequence;
+        std::vector<StatusField> changed;
+        std::vector<std::string> removed;
+    };
+
+    struct View
+    {
+        View() : sequence(0) {}
+
+        std::shared_ptr<const std::string> source;   // documento da cui derivano fields
+        std::vector<StatusField> fields;
+        unsigned long long sequence;
+        std::deque<Change> history;
+    };
+
+    DeltaEngine(const DeltaEngine&);
+    DeltaEngine& operator=(const DeltaEngine&);
+
+    void refreshLocked(View& view, const std::shared_ptr<const std::string>& xml);
+    void deltaLocked(const View& view, unsigned long long since, StatusDelta& delta) const;
+
+    static unsigned long long nextSequence();
+
+    std::mutex mutex_;
+    View views_[STATUS_KIND_COUNT];
+};
+
+#endif // DELTA_ENGINE_H
@@ -0,0 +1,189 @@
+#include "DepletionForecaster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "TimeSeriesStore.h"
+#include "XmlUtil.h"
+
+using namespace std;
+
+namespace
+{
+    const double MS_PER_HOUR = 3600000.0;
+
+    // Punti percentuali oltre i quali un aumento (o una diminuzione per i raccoglitori) e' una sostituzione
+    const double REFILL_JUMP = 5.0;
+
+    // I raccoglitori si riempiono: il limite e' 100%, per gli altri consumabili 0%
+    bool fills(StatusKind kind)
+    {
+        return kind == STATUS_WASTE_COLLECTORS;
+    }
+
+    void appendDouble(string& xml, double value)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%g", value);
+        xml += text;
+    }
+}
+
+DepletionForecaster::Slot::Slot()
+    : kind(STATUS_INK_SYSTEM), time(0), weight(0), sumT(0), sumY(0), sumTT(0), sumTY(0), lastLevel(0), samples(0)
+{
+}
+
+DepletionForecaster::DepletionForecaster()
+    : halfLife_(72.0)
+{
+}
+
+DepletionForecaster& DepletionForecaster::instance()
+{
+    static DepletionForecaster* forecaster = new DepletionForecaster();
+    return *forecaster;
+}
+
+void DepletionForecaster::setHalfLife(double hours)
+{
+    lock_guard<mutex> lock(mutex_);
+    halfLife_ = hours > 0 ? hours : 72.0;
+}
+
+void DepletionForecaster::update(const string& ipAddress, StatusKind kind, long long time, const vector<SlotLevel>& levels)
+{
+    lock_guard<mutex> lock(mutex_);
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        if (levels[i].levelPercent < 0 || levels[i].id.empty())
+        {
+            continue;
+        }
+        string key = ipAddress + "/" + string(levels[i].id);
+        map<string, Slot, less<> >::iterator it = slots_.find(key);
+        if (it == slots_.end())
+        {
+            it = slots_.insert(make_pair(key, Slot())).first;
+            it->second.kind = kind;
+            vector<HistoryPoint> history;
+            TimeSeriesStore::instance().query(key + "/level", time - (long long)(MAX_HALF_LIVES * halfLife_ * MS_PER_HOUR), time - 1, history);
+            for (size_t j = 0; j < history.size(); j++)
+            {
+                addLocked(it->second, history[j].time, history[j].value);
+            }
+        }
+        addLocked(it->second, time, levels[i].levelPercent);
+    }
+}
+
+void DepletionForecaster::addLocked(Slot& slot, long long time, double level) const
+{
+    if (slot.samples > 0)
+    {
+        double jump = fills(slot.kind) ? slot.lastLevel - level : level - slot.lastLevel;
+        if (jump > REFILL_JUMP)
+        {
+            StatusKind kind = slot.kind;
+            slot = Slot();
+            slot.kind = kind;
+        }
+    }
+    if (slot.samples > 0)
+    {
+        // Origine sul nuovo campione: t' = t - shift, poi decadimento dei pesi
+        double shift = time > slot.time ? (double)(time - slot.time) / MS_PER_HOUR : 0.0;
+        slot.sumTT += shift * shift * slot.weight - 2.0 * shift * slot.sumT;
+        slot.sumTY -= shift * slot.sumY;
+        slot.sumT -= shift * slot.weight;
+        double decay = exp2(-shift / halfLife_);
+        slot.weight *= decay;
+        slot.sumT *= decay;
+        slot.sumY *= decay;
+        slot.sumTT *= decay;
+        slot.sumTY *= decay;
+    }
+    // Il nuovo campione ha t = 0: contribuisce solo a weight e sumY
+    slot.weight += 1.0;
+    slot.sumY += level;
+    slot.time = max(time, slot.time);
+    slot.lastLevel = level;
+    slot.samples++;
+}
+
+void DepletionForecaster::forecast(const Slot& slot, DepletionForecast& forecast)
+{
+    forecast.kind = slot.kind;
+    forecast.level = slot.lastLevel;
+    forecast.ratePerHour = 0;
+    forecast.predicted = false;
+    forecast.emptyAt = 0;
+    forecast.samples = slot.samples;
+    double denominator = slot.weight * slot.sumTT - slot.sumT * slot.sumT;
+    if (slot.samples < 3 || denominator <= 1e-12)
+    {
+        return;
+    }
+    double slope = (slot.weight * slot.sumTY - slot.sumT * slot.sumY) / denominator;
+    double level = (slot.sumY - slope * slot.sumT) / slot.weight;
+    double limit = fills(slot.kind) ? 100.0 : 0.0;
+    forecast.level = level;
+    forecast.ratePerHour = slope;
+    if ((fills(slot.kind) && slope > 1e-9) || (!fills(slot.kind) && slope < -1e-9))
+    {
+        double hours = max((limit - level) / slope, 0.0);
+        forecast.predicted = true;
+        forecast.emptyAt = slot.time + (long long)(hours * MS_PER_HOUR);
+    }
+}
+
+vector<DepletionForecast> DepletionForecaster::forecasts(const string& ipAddress) const
+{
+    lock_guard<mutex> lock(mutex_);
+    vector<DepletionForecast> list;
+    for (map<string, Slot, less<> >::const_iterator it = slots_.begin(); it != slots_.end(); ++it)
+    {
+        size_t separator = it->first.find('/');
+        if (!ipAddress.empty() && it->first.compare(0, separator, ipAddress) != 0)
+        {
+            continue;
+        }
+        DepletionForecast item;
+        item.ipAddress = it->first.substr(0, separator);
+        item.slot = it->first.substr(separator + 1);
+        forecast(it->second, item);
+        list.push_back(item);
+    }
+    return list;
+}
+
+string DepletionForecaster::toXml(const vector<DepletionForecast>& forecasts, long long now)
+{
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<DepletionForecast>\n";
+    for (size_t i = 0; i < forecasts.size(); i++)
+    {
+        const DepletionForecast& forecast = forecasts[i];
+        xml += "<Slot ip=\"";
+        appendXmlEscaped(xml, forecast.ipAddress);
+        xml += "\" id=\"";
+        appendXmlEscaped(xml, forecast.slot);
+        xml += "\" kind=\"";
+        xml += statusQueryInfo(forecast.kind).name;
+        xml += "\" level=\"";
+        appendDouble(xml, forecast.level);
+        xml += "\" ratePerDay=\"";
+        appendDouble(xml, forecast.ratePerHour * 24.0);
+        xml += "\" samples=\"";
+        xml += to_string(forecast.samples);
+        if (forecast.predicted)
+        {
+            xml += "\" emptyAt=\"";
+            xml += to_string(forecast.emptyAt);
+            xml += "\" hoursLeft=\"";
+            appendDouble(xml, max((double)(forecast.emptyAt - now) / MS_PER_HOUR, 0.0));
+        }
+        xml += "\"/>\n";
+    }
+    xml += "</DepletionForecast>\n";
+    return xml;
+}
@@ -0,0 +1,80 @@
+#ifndef DEPLETION_FORECASTER_H
+#define DEPLETION_FORECASTER_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "StatusModel.h"
+
+struct DepletionForecast
+{
+    std::string ipAddress;
+    std::string slot;
+    StatusKind kind;
+    double level;               // livello stimato all'ultimo campione
+    double ratePerHour;         // punti percentuali all'ora (negativo se si consuma)
+    bool predicted;             // false se i campioni non bastano o il livello non va verso il limite
+    long long emptyAt;          // millisecondi dal 1970: 0% (inchiostri, manutenzione) o 100% (raccoglitori)
+    unsigned long long samples;
+};
+
+// Previsione di esaurimento dei consumabili: per ogni slot una regressione
+// lineare del livello sul tempo con pesi che decadono esponenzialmente
+// (dimezzati ogni halfLife), aggiornata a ogni campione in O(1) con cinque
+// somme. L'origine dei tempi viene spostata sull'ultimo campione, cosi' le
+// somme restano piccole anche dopo mesi. Un salto del livello nel verso
+// opposto al consumo (cartuccia sostituita, raccoglitore svuotato) azzera lo slot.
+//
+// Alla prima lettura di uno slot lo stato viene ricostruito dallo storico
+// (TimeSeriesStore), una sola volta, con i campioni delle ultime MAX_HALF_LIVES
+// halfLife.
+class DepletionForecaster
+{
+public:
+    enum { MAX_HALF_LIVES = 8 };
+
+    // Istanza alimentata da StatusCache; come FleetPoller non viene mai distrutta.
+    static DepletionForecaster& instance();
+
+    // Campioni di una lettura della vista kind al tempo indicato (ms dal 1970).
+    void update(const std::string& ipAddress, StatusKind kind, long long time, const std::vector<SlotLevel>& levels);
+
+    // Previsioni della stampante, o di tutte con ipAddress vuoto.
+    std::vector<DepletionForecast> forecasts(const std::string& ipAddress) const;
+
+    void setHalfLife(double hours);
+
+    static std::string toXml(const std::vector<DepletionForecast>& forecasts, long long now);
+
+private:
+    // Somme pesate con t in ore dall'ultimo campione e y livello percentuale
+    struct Slot
+    {
+        Slot();
+
+        StatusKind kind;
+        long long time;
+        double weight;
+        double sumT;
+        double sumY;
+        double sumTT;
+        double sumTY;
+        double lastLevel;
+        unsigned long long samples;
+    };
+
+    DepletionForecaster();
+    DepletionForecaster(const DepletionForecaster&);
+    DepletionForecaster& operator=(const DepletionForecaster&);
+
+    void addLocked(Slot& slot, long long time, double level) const;
+    static void forecast(const Slot& slot, DepletionForecast& forecast);
+
+    mutable std::mutex mutex_;
+    double halfLife_;
+    // Chiave "ip/slot", come le serie dello storico
+    std::map<std::string, Slot, std::less<> > slots_;
+};
+
+#endif // DEPLETION_FORECASTER_H
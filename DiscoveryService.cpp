@@ -0,0 +1,303 @@
+#include "DiscoveryService.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include "Metrics.h"
+#include "PrinterSession.h"
+#include "XmlPullParser.h"
+#include "XmlUtil.h"
+
+using namespace std;
+
+namespace
+{
+    // Nomi usati dalle diverse versioni dell'SDK per indirizzo e modello
+    const string_view PRINTER_FIELDS[] = { "IpAddress", "IPAddress", "ModelName", "Model" };
+
+    long long secondsNow()
+    {
+        return (long long)chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    string defaultCacheFile()
+    {
+        const char* path = getenv("HPSDK_DISCOVERY_CACHE");
+        if (path != NULL)
+        {
+            return path;
+        }
+        error_code error;
+        filesystem::path directory = filesystem::temp_directory_path(error);
+        return error ? string() : (directory / "HPSDKTest.discovery").string();
+    }
+}
+
+DiscoveryService::DiscoveryService()
+    : table_(make_shared<const Table>()), scanning_(false), running_(false), generation_(0), lastResult_(HPLFPSDK::Types::RESULT_OK), worker_(1)
+{
+    cacheFile_ = defaultCacheFile();
+    if (!cacheFile_.empty())
+    {
+        table_ = load(cacheFile_);
+    }
+}
+
+DiscoveryService& DiscoveryService::instance()
+{
+    static DiscoveryService* service = new DiscoveryService();
+    return *service;
+}
+
+bool DiscoveryService::rescan(unsigned int queryTimeout, unsigned int discoveryTimeout, bool supportedOnly)
+{
+    unsigned long long generation;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (scanning_)
+        {
+            return false;
+        }
+        scanning_ = true;
+        generation = generation_;
+    }
+    worker_.post([this, generation, queryTimeout, discoveryTimeout, supportedOnly]() { scan(generation, queryTimeout, discoveryTimeout, supportedOnly); });
+    return true;
+}
+
+void DiscoveryService::stop()
+{
+    lock_guard<mutex> lock(mutex_);
+    generation_++;
+    if (!running_)
+    {
+        scanning_ = false;
+    }
+}
+
+bool DiscoveryService::scanning() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return scanning_;
+}
+
+HPLFPSDK::Types::Result DiscoveryService::lastResult() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return lastResult_;
+}
+
+vector<DiscoveredPrinter> DiscoveryService::printers() const
+{
+    shared_ptr<const Table> current = table();
+    vector<DiscoveredPrinter> printers;
+    printers.reserve(current->size());
+    for (Table::const_iterator it = current->begin(); it != current->end(); ++it)
+    {
+        printers.push_back(it->second);
+    }
+    return printers;
+}
+
+bool DiscoveryService::lookup(const string& ipAddress, string& printerModel) const
+{
+    shared_ptr<const Table> current = table();
+    Table::const_iterator it = current->find(ipAddress);
+    if (it == current->end())
+    {
+        return false;
+    }
+    printerModel = it->second.printerModel;
+    return true;
+}
+
+void DiscoveryService::setCacheFile(const string& path)
+{
+    shared_ptr<const Table> loaded = path.empty() ? shared_ptr<const Table>() : load(path);
+    lock_guard<mutex> lock(mutex_);
+    cacheFile_ = path;
+    if (loaded && !loaded->empty())
+    {
+        table_ = loaded;
+    }
+}
+
+shared_ptr<const DiscoveryService::Table> DiscoveryService::table() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return table_;
+}
+
+void DiscoveryService::scan(unsigned long long generation, unsigned int queryTimeout, unsigned int discoveryTimeout, bool supportedOnly)
+{
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_ERROR;
+    {
+        // beginUse sotto mutex_: stop seguito da terminate o annulla la ricerca
+        // o la trova gia' registrata, e allora terminate restituisce BUSY
+        lock_guard<mutex> lock(mutex_);
+        if (generation != generation_)
+        {
+            return;
+        }
+        running_ = true;
+        try
+        {
+            result = PrinterSession::instance().beginUse();
+        }
+        catch (exception)
+        {
+            result = HPLFPSDK::Types::RESULT_ERROR;
+        }
+    }
+
+    MetricTimer timer(METRIC_PHASE_DISCOVERY);
+    vector<DiscoveredPrinter> found;
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        try
+        {
+            char* xml = NULL;
+            size_t length = 0;
+            result = hplfpsdk_getNetworkPrintersExtended(queryTimeout, discoveryTimeout, supportedOnly, &xml, length);
+            if (result == HPLFPSDK::Types::RESULT_OK && xml != NULL)
+            {
+                parseNetworkPrinters(xml, length, found);
+            }
+            if (xml != NULL)
+            {
+                hplfpsdk_deleteBuffer(&xml);
+            }
+        }
+        catch (exception)
+        {
+            result = HPLFPSDK::Types::RESULT_ERROR;
+        }
+        PrinterSession::instance().endUse();
+    }
+    timer.stop(result);
+
+    // La nuova tabella viene preparata fuori dal lock e sostituita in un colpo solo
+    string cacheFile;
+    shared_ptr<Table> merged;
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        long long now = secondsNow();
+        merged = make_shared<Table>(*table());
+        for (size_t i = 0; i < found.size(); i++)
+        {
+            DiscoveredPrinter& printer = (*merged)[found[i].ipAddress];
+            printer.ipAddress = found[i].ipAddress;
+            printer.printerModel = found[i].printerModel;
+            printer.lastSeen = now;
+        }
+    }
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (merged)
+        {
+            table_ = merged;
+        }
+        cacheFile = cacheFile_;
+        lastResult_ = result;
+        running_ = false;
+        scanning_ = false;
+    }
+    if (merged && !cacheFile.empty())
+    {
+        save(cacheFile, *merged);
+    }
+}
+
+void DiscoveryService::parseNetworkPrinters(const char* xml, size_t length, vector<DiscoveredPrinter>& printers)
+{
+    xmlSelect(xml, length, "Printer", [&printers](const XmlElement& element)
+    {
+        string_view values[4];
+        element.texts(PRINTER_FIELDS, values, 4);
+        string_view ip = !values[0].empty() ? values[0] : values[1];
+        string_view model = !values[2].empty() ? values[2] : values[3];
+        // Alcune versioni riportano i dati come attributi di <Printer>
+        if (ip.empty())
+        {
+            element.attribute("ip", ip);
+        }
+        if (model.empty())
+        {
+            element.attribute("model", model);
+        }
+        if (!ip.empty())
+        {
+            DiscoveredPrinter printer;
+            printer.ipAddress.assign(ip.data(), ip.size());
+            printer.printerModel.assign(model.data(), model.size());
+            printer.lastSeen = 0;
+            printers.push_back(printer);
+        }
+        return true;
+    });
+}
+
+string DiscoveryService::toXml(const vector<DiscoveredPrinter>& printers, bool scanning)
+{
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<DiscoveredPrinters scanning=\"";
+    xml += scanning ? "true" : "false";
+    xml += "\">\n";
+    for (size_t i = 0; i < printers.size(); i++)
+    {
+        xml += "<Printer ip=\"";
+        appendXmlEscaped(xml, printers[i].ipAddress);
+        xml += "\" model=\"";
+        appendXmlEscaped(xml, printers[i].printerModel);
+        xml += "\" lastSeen=\"";
+        xml += to_string(printers[i].lastSeen);
+        xml += "\"/>\n";
+    }
+    xml += "</DiscoveredPrinters>\n";
+    return xml;
+}
+
+shared_ptr<const DiscoveryService::Table> DiscoveryService::load(const string& path)
+{
+    shared_ptr<Table> table = make_shared<Table>();
+    ifstream file(path.c_str());
+    string line;
+    while (getline(file, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+        {
+            line.erase(line.size() - 1);
+        }
+        size_t model = line.find(';');
+        if (model == string::npos || model == 0)
+        {
+            continue;
+        }
+        size_t seen = line.find(';', model + 1);
+        DiscoveredPrinter printer;
+        printer.ipAddress = line.substr(0, model);
+        printer.printerModel = line.substr(model + 1, seen == string::npos ? string::npos : seen - model - 1);
+        printer.lastSeen = seen == string::npos ? 0 : atoll(line.c_str() + seen + 1);
+        (*table)[printer.ipAddress] = printer;
+    }
+    return table;
+}
+
+void DiscoveryService::save(const string& path, const Table& table)
+{
+    // Scrittura su un file temporaneo e rinomina: chi legge non vede mai un file a meta'
+    string temporary = path + ".tmp";
+    {
+        ofstream file(temporary.c_str(), ios::trunc);
+        for (Table::const_iterator it = table.begin(); it != table.end(); ++it)
+        {
+            file << it->second.ipAddress << ';' << it->second.printerModel << ';' << it->second.lastSeen << '\n';
+        }
+        if (!file)
+        {
+            return;
+        }
+    }
+    error_code error;
+    filesystem::rename(temporary, path, error);
+}
@@ -0,0 +1,79 @@
+#ifndef DISCOVERY_SERVICE_H
+#define DISCOVERY_SERVICE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "IHplfpsdk.h"
+#include "ThreadPool.h"
+
+struct DiscoveredPrinter
+{
+    std::string ipAddress;
+    std::string printerModel;
+    long long lastSeen;         // secondi dal 1970 dell'ultima ricerca che l'ha trovata
+};
+
+// Stampanti trovate in rete da hplfpsdk_getNetworkPrintersExtended.
+// La ricerca dura tutto discoveryTimeOut, quindi viene eseguita su un thread
+// interno: le letture rispondono subito con la tabella corrente, che all'avvio
+// viene caricata dal file di cache e dopo ogni ricerca viene salvata.
+// Una nuova ricerca aggiunge le stampanti trovate e aggiorna quelle gia' note,
+// senza togliere quelle che in quel momento non hanno risposto.
+class DiscoveryService
+{
+public:
+    // Istanza degli export; come FleetPoller non viene mai distrutta.
+    static DiscoveryService& instance();
+
+    // Avvia una ricerca, se non ce n'e' gia' una in corso (tempi in secondi,
+    // vedi hplfpsdk_getNetworkPrintersExtended). false se era gia' in corso.
+    bool rescan(unsigned int queryTimeout, unsigned int discoveryTimeout, bool supportedOnly);
+    bool scanning() const;
+    // Annulla la ricerca non ancora partita; quella in corso tiene la libreria
+    // in uso (PrinterSession::beginUse) fino alla fine. Da chiamare prima di
+    // PrinterSession::terminate.
+    void stop();
+
+    // Risultato dell'ultima ricerca conclusa (RESULT_OK se nessuna).
+    HPLFPSDK::Types::Result lastResult() const;
+
+    std::vector<DiscoveredPrinter> printers() const;
+    // Modello della stampante con questo indirizzo; false se non e' nota.
+    bool lookup(const std::string& ipAddress, std::string& printerModel) const;
+
+    // File di cache: una riga "ip;modello;lastSeen" per stampante, lo stesso
+    // formato "ip;modello" di PollFleet. Stringa vuota per non usare il file.
+    // La tabella viene sostituita dal contenuto del nuovo file, se esiste.
+    void setCacheFile(const std::string& path);
+
+    // Documento <NetworkPrinters> dell'SDK -> stampanti (lastSeen non impostato).
+    static void parseNetworkPrinters(const char* xml, size_t length, std::vector<DiscoveredPrinter>& printers);
+    static std::string toXml(const std::vector<DiscoveredPrinter>& printers, bool scanning);
+
+private:
+    typedef std::map<std::string, DiscoveredPrinter> Table;    // per indirizzo
+
+    DiscoveryService();
+    DiscoveryService(const DiscoveryService&);
+    DiscoveryService& operator=(const DiscoveryService&);
+
+    void scan(unsigned long long generation, unsigned int queryTimeout, unsigned int discoveryTimeout, bool supportedOnly);
+    std::shared_ptr<const Table> table() const;
+    static std::shared_ptr<const Table> load(const std::string& path);
+    static void save(const std::string& path, const Table& table);
+
+    mutable std::mutex mutex_;
+    // Copia immutabile: le letture prendono il puntatore e non attendono le ricerche
+    std::shared_ptr<const Table> table_;
+    std::string cacheFile_;
+    bool scanning_;
+    bool running_;                      // scan partito e non ancora concluso
+    unsigned long long generation_;     // cambia a ogni stop: la ricerca in coda non parte
+    HPLFPSDK::Types::Result lastResult_;
+    ThreadPool worker_;
+};
+
+#endif // DISCOVERY_SERVICE_H
@@ -0,0 +1,231 @@
+#include "FleetPoller.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <sstream>
+#include "PrinterStatus.h"
+#include "XmlUtil.h"
+
+using namespace std;
+
+// Stato di un giro condiviso con i task: i task abbandonati per timeout
+// possono terminare dopo che poll() e' gia' uscito.
+struct FleetPoller::Batch
+{
+    explicit Batch(size_t count)
+        : results(count), running(count, false), finished(count, false), started(count), remaining(count)
+    {
+    }
+
+    void finish(size_t i, HPLFPSDK::Types::Result result, chrono::steady_clock::time_point now)
+    {
+        results[i].result = result;
+        results[i].elapsed = chrono::duration_cast<chrono::milliseconds>(now - started[i]);
+        finished[i] = true;
+        remaining--;
+    }
+
+    mutex lock;
+    condition_variable changed;
+    vector<FleetResult> results;
+    vector<bool> running;
+    vector<bool> finished;
+    vector<chrono::steady_clock::time_point> started;
+    size_t remaining;
+};
+
+FleetPoller::FleetPoller(size_t workers)
+    : pool_(workers)
+{
+}
+
+FleetPoller& FleetPoller::instance()
+{
+    static FleetPoller* poller = new FleetPoller(16);
+    return *poller;
+}
+
+vector<FleetResult> FleetPoller::poll(const vector<FleetPrinter>& printers, StatusKind kind, chrono::milliseconds timeout)
+{
+    // Le stampanti ripetute nella lista ricevono il risultato della prima
+    vector<FleetPrinter> distinct;
+    vector<size_t> positions(printers.size());
+    map<string, size_t> seen;
+    for (size_t i = 0; i < printers.size(); i++)
+    {
+        map<string, size_t>::iterator it = seen.insert(make_pair(printers[i].ipAddress + '|' + printers[i].printerModel, distinct.size())).first;
+        if (it->second == distinct.size())
+        {
+            distinct.push_back(printers[i]);
+        }
+        positions[i] = it->second;
+    }
+
+    shared_ptr<Batch> batch = make_shared<Batch>(distinct.size());
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t queued = 0;
+    for (size_t i = 0; i < distinct.size(); i++)
+    {
+        FleetResult& result = batch->results[i];
+        result.ipAddress = distinct[i].ipAddress;
+        result.printerModel = distinct[i].printerModel;
+        batch->started[i] = start;
+
+        const string key = distinct[i].ipAddress + '|' + distinct[i].printerModel + '|' + to_string((int)kind);
+        Waiter waiter;
+        waiter.batch = batch;
+        waiter.index = i;
+        bool joined = false;
+        {
+            lock_guard<mutex> lock(mutex_);
+            map<string, vector<Waiter> >::iterator it = reads_.find(key);
+            joined = it != reads_.end();
+            reads_[key].push_back(waiter);
+        }
+        if (joined)
+        {
+            // Lettura gia' in corso (di un giro precedente o di un altro
+            // chiamante): il timeout di questa stampante parte da ora
+            lock_guard<mutex> lock(batch->lock);
+            batch->running[i] = true;
+            continue;
+        }
+        queued++;
+        const FleetPrinter printer = distinct[i];
+        pool_.post([this, batch, i, key, printer, kind, timeout]()
+        {
+            {
+                lock_guard<mutex> lock(batch->lock);
+                batch->started[i] = chrono::steady_clock::now();
+                batch->running[i] = true;
+            }
+            read(key, printer, kind, timeout);
+        });
+    }
+
+    // Le stampanti in coda partono solo quando un thread si libera:
+    // il giro non puo' durare piu' di un timeout per ogni "ondata" del pool.
+    size_t waves = (queued + pool_.size() - 1) / pool_.size();
+    const chrono::steady_clock::time_point batchDeadline = start + timeout * (long long)max<size_t>(waves, 1);
+
+    unique_lock<mutex> lock(batch->lock);
+    while (batch->remaining > 0)
+    {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        chrono::steady_clock::time_point wakeUp = batchDeadline;
+        for (size_t i = 0; i < distinct.size(); i++)
+        {
+            if (batch->finished[i])
+            {
+                continue;
+            }
+            if (now >= batchDeadline || (batch->running[i] && now >= batch->started[i] + timeout))
+            {
+                batch->finish(i, HPLFPSDK::Types::RESULT_ERROR_TIMEOUT, now);
+            }
+            else if (batch->running[i])
+            {
+                wakeUp = min(wakeUp, batch->started[i] + timeout);
+            }
+        }
+        if (batch->remaining > 0)
+        {
+            batch->changed.wait_until(lock, wakeUp);
+        }
+    }
+    vector<FleetResult> results(printers.size());
+    for (size_t i = 0; i < printers.size(); i++)
+    {
+        results[i] = batch->results[positions[i]];
+    }
+    return results;
+}
+
+void FleetPoller::read(const string& key, const FleetPrinter& printer, StatusKind kind, chrono::milliseconds timeout)
+{
+    shared_ptr<const string> xml;
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_ERROR;
+    try
+    {
+        result = readPrinterStatus(printer.ipAddress.c_str(), printer.printerModel.c_str(), kind, timeout, xml);
+    }
+    catch (exception)
+    {
+    }
+    // Il risultato va a tutti i giri che si sono agganciati nel frattempo
+    vector<Waiter> waiters;
+    {
+        lock_guard<mutex> lock(mutex_);
+        map<string, vector<Waiter> >::iterator it = reads_.find(key);
+        waiters.swap(it->second);
+        reads_.erase(it);
+    }
+    const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    for (size_t w = 0; w < waiters.size(); w++)
+    {
+        Batch& batch = *waiters[w].batch;
+        const size_t i = waiters[w].index;
+        {
+            lock_guard<mutex> lock(batch.lock);
+            if (!batch.finished[i])
+            {
+                batch.results[i].xml = xml;
+                batch.finish(i, result, now);
+            }
+        }
+        batch.changed.notify_all();
+    }
+}
+
+vector<FleetPrinter> FleetPoller::parsePrinterList(const char* list)
+{
+    vector<FleetPrinter> printers;
+    if (list == NULL)
+    {
+        return printers;
+    }
+    istringstream lines(list);
+    string line;
+    while (getline(lines, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+        {
+            line.erase(line.size() - 1);
+        }
+        size_t separator = line.find(';');
+        if (separator == string::npos || separator == 0)
+        {
+            continue;
+        }
+        FleetPrinter printer;
+        printer.ipAddress = line.substr(0, separator);
+        printer.printerModel = line.substr(separator + 1);
+        printers.push_back(printer);
+    }
+    return printers;
+}
+
+string FleetPoller::toXml(const vector<FleetResult>& results)
+{
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Fleet>\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const FleetResult& result = results[i];
+        xml += "<Printer ip=\"";
+        appendXmlEscaped(xml, result.ipAddress);
+        xml += "\" model=\"";
+        appendXmlEscaped(xml, result.printerModel);
+        xml += "\" result=\"";
+        xml += to_string((unsigned int)result.result);
+        xml += "\" elapsedMs=\"";
+        xml += to_string((long long)result.elapsed.count());
+        xml += "\">";
+        if (result.xml)
+        {
+            appendXmlBody(xml, result.xml->data(), result.xml->size());
+        }
+        xml += "</Printer>\n";
+    }
+    xml += "</Fleet>\n";
+    return xml;
+}
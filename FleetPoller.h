@@ -0,0 +1,71 @@
+#ifndef FLEET_POLLER_H
+#define FLEET_POLLER_H
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "IHplfpsdk.h"
+#include "StatusQueries.h"
+#include "ThreadPool.h"
+
+struct FleetPrinter
+{
+    std::string ipAddress;
+    std::string printerModel;
+};
+
+struct FleetResult
+{
+    std::string ipAddress;
+    std::string printerModel;
+    HPLFPSDK::Types::Result result;
+    std::chrono::milliseconds elapsed;
+    std::shared_ptr<const std::string> xml;   // NULL se result != RESULT_OK
+};
+
+// Interroga molte stampanti in parallelo su un pool di thread di dimensione fissa.
+// Ogni stampante ha il suo timeout: quando scade la stampante viene riportata con
+// RESULT_ERROR_TIMEOUT e il giro termina senza aspettarla. Finche' la sua
+// interrogazione della stessa vista e' ancora in corso, i giri successivi
+// (anche di altri chiamanti) non la rimettono in coda ma ne attendono il
+// risultato, ciascuno con il proprio timeout: le stampanti spente non occupano
+// tutto il pool. Una stampante ripetuta nella lista viene letta una volta.
+class FleetPoller
+{
+public:
+    explicit FleetPoller(size_t workers);
+
+    // Istanza condivisa dagli export; non viene mai distrutta per non dover
+    // attendere eventuali thread bloccati nell'SDK alla chiusura del processo.
+    static FleetPoller& instance();
+
+    std::vector<FleetResult> poll(const std::vector<FleetPrinter>& printers, StatusKind kind, std::chrono::milliseconds timeout);
+
+    // Lista "ip;modello" separata da a capo, come passata all'export PollFleet.
+    static std::vector<FleetPrinter> parsePrinterList(const char* list);
+    static std::string toXml(const std::vector<FleetResult>& results);
+
+private:
+    struct Batch;
+
+    // Giro in attesa di una lettura in corso, e posizione della stampante nel giro
+    struct Waiter
+    {
+        std::shared_ptr<Batch> batch;
+        size_t index;
+    };
+
+    FleetPoller(const FleetPoller&);
+    FleetPoller& operator=(const FleetPoller&);
+
+    void read(const std::string& key, const FleetPrinter& printer, StatusKind kind, std::chrono::milliseconds timeout);
+
+    std::mutex mutex_;
+    std::map<std::string, std::vector<Waiter> > reads_;     // letture in corso per ip|modello|vista
+    ThreadPool pool_;
+};
+
+#endif // FLEET_POLLER_H
@@ -1,140 +1,730 @@
 // HPSDKTest.cpp : Questo file contiene la funzione 'main', in cui inizia e termina l'esecuzione del programma.
 //
 
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include "IHplfpsdk.h"
+#include "AsyncStatusQueue.h"
+#include "BufferPool.h"
+#include "ConsumablesSnapshot.h"
+#include "DeltaEngine.h"
+#include "DepletionForecaster.h"
+#include "DiscoveryService.h"
+#include "FleetPoller.h"
+#include "JobTransmitter.h"
+#include "MappedSpoolHandler.h"
+#include "PrinterHealth.h"
+#include "Metrics.h"
+#include "PrinterSession.h"
+#include "PrinterStatus.h"
+#include "RasterJob.h"
+#include "StatusQueries.h"
+#include "StatusRecords.h"
+#include "TimeSeriesStore.h"
+#include "WarmPool.h"
 
 using namespace std;
 
-extern "C" __declspec(dllexport) unsigned char* GetCartridges(unsigned char* ip, unsigned char* pn)
+// Funzioni esportate dalla DLL (Windows) o dalla libreria condivisa (Linux)
+#ifdef _WIN32
+#define HPSDKTEST_API __declspec(dllexport)
+#else
+#define HPSDKTEST_API __attribute__((visibility("default")))
+#endif
+
+static HPLFPSDK::Types::Result InitLibrary()
 {
-    try
+    if (PrinterSession::instance().init() != HPLFPSDK::Types::RESULT_OK)
+    {
+        cout << "Libreria non inizializzata!" << "\n";
+        return HPLFPSDK::Types::RESULT_ERROR_LIBRARY_NOT_INITIALIZED;
+    }
+    // Alla prima chiamata prepara in background le stampanti di HPSDK_WARM_PRINTERS
+    static const bool warmPoolStarted = (WarmPool::startFromEnvironment(), true);
+    (void)warmPoolStarted;
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+// Vista di stato dalla cache del device (vedi readPrinterStatus).
+// Il documento e' condiviso con la cache: nessuna copia.
+static HPLFPSDK::Types::Result ReadStatus(unsigned char* ip, unsigned char* pn, StatusKind kind, shared_ptr<const string>& status)
+{
+    HPLFPSDK::Types::Result result = InitLibrary();
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    return readPrinterStatus((char*)ip, (char*)pn, kind, PrinterSession::instance().readyTimeout(), status);
+}
+
+// Inchiostri, testine, manutenzione, serbatoi e raccoglitori in una sola lettura.
+static HPLFPSDK::Types::Result ReadConsumablesSnapshot(unsigned char* ip, unsigned char* pn, string& snapshot)
+{
+    HPLFPSDK::Types::Result result = InitLibrary();
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    PrinterHealth& health = PrinterHealth::instance();
+    if (!health.allow((char*)ip, result))
     {
-        //cout << "Hello World!\n";
-        char* ipAddress = (char*)ip;
-        char* printerName = (char*)pn;
-        hplfpsdk_setLogLevel(HPLFPSDK::Types::LOG_LEVEL_NONE);
-        HPLFPSDK::Types::Result result = hplfpsdk_init();
-        if (result == HPLFPSDK::Types::RESULT_OK)
+        return result;
+    }
+    PrinterSession& session = PrinterSession::instance();
+    PrinterSession::Lease printer;
+    result = session.acquire((char*)ip, (char*)pn, printer);
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        result = session.waitReady(printer);
+    }
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        MetricTimer timer(METRIC_PHASE_SNAPSHOT);
+        result = timer.stop(getConsumablesSnapshot(session.statusCache(printer), snapshot));
+        if (result == HPLFPSDK::Types::RESULT_ERROR_NOT_YET_INITIALIZED)
         {
-            cout << "Libreria inizializzata correttamente!" << "\n";
+            session.invalidateReady(printer);
         }
-        else
+    }
+    health.record((char*)ip, result);
+    return result;
+}
+
+// Campi della vista cambiati dopo la sequenza since (vedi DeltaEngine).
+static HPLFPSDK::Types::Result ReadStatusDelta(unsigned char* ip, unsigned char* pn, int kind, unsigned long long since, string& xml)
+{
+    if (kind < 0 || kind >= STATUS_KIND_COUNT)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    HPLFPSDK::Types::Result result = InitLibrary();
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    StatusDelta delta;
+    result = readPrinterStatusDelta((char*)ip, (char*)pn, (StatusKind)kind, PrinterSession::instance().readyTimeout(), since, delta);
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    xml = DeltaEngine::toXml(delta);
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+static HPLFPSDK::Types::Result ReadFleet(unsigned char* printers, int kind, unsigned int timeoutMs, string& fleet)
+{
+    if (kind < 0 || kind >= STATUS_KIND_COUNT)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    HPLFPSDK::Types::Result result = InitLibrary();
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    vector<FleetPrinter> list = FleetPoller::parsePrinterList((char*)printers);
+    fleet = FleetPoller::toXml(FleetPoller::instance().poll(list, (StatusKind)kind, chrono::milliseconds(timeoutMs)));
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+// Job sul device (ip, modello). Con ip vuoto il device e' offline: non si
+// attende la stampante e il circuit breaker non e' coinvolto.
+static HPLFPSDK::Types::Result SendRasterJob(const char* ip, unsigned char* pn, const RasterJob& job)
+{
+    const bool offline = *ip == '\0';
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_OK;
+    PrinterHealth& health = PrinterHealth::instance();
+    if (!offline && !health.allow(ip, result))
+    {
+        return result;
+    }
+    PrinterSession& session = PrinterSession::instance();
+    PrinterSession::Lease printer;
+    result = session.acquire(ip, (char*)pn, printer);
+    if (result == HPLFPSDK::Types::RESULT_OK && !offline)
+    {
+        result = session.waitReady(printer);
+    }
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        result = submitRasterJob(printer.device(), job);
+    }
+    if (!offline)
+    {
+        health.record(ip, result);
+    }
+    return result;
+}
+
+// Risultato per gli export che restituiscono una stringa: il documento, che resta
+// valido fino alla chiamata successiva sullo stesso thread, oppure un messaggio.
+static unsigned char* ToText(HPLFPSDK::Types::Result result, const string& text)
+{
+    switch (result)
+    {
+    case HPLFPSDK::Types::RESULT_OK:
+        return (unsigned char*)text.c_str();
+    case HPLFPSDK::Types::RESULT_ERROR_LIBRARY_NOT_INITIALIZED:
+        return (unsigned char*)"LIBRERIA NON INIZIALIZZATA";
+    case HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER:
+        return (unsigned char*)"PARAMETRO NON VALIDO";
+    default:
+        return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+    }
+}
+
+// Risultato per gli export "Ex": il documento viene copiato nel buffer del chiamante,
+// terminato da '\0'. written riceve sempre la dimensione necessaria (terminatore
+// compreso): con buffer NULL o troppo piccolo non viene copiato nulla e si
+// restituisce RESULT_ERROR_PARAM_SIZE_OUT_OF_RANGE, cosi' il chiamante puo'
+// allocare e riprovare. Il documento puo' cambiare tra le due chiamate.
+static int ToBuffer(HPLFPSDK::Types::Result result, const string& text, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    if (written != NULL)
+    {
+        *written = 0;
+    }
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return (int)result;
+    }
+    size_t needed = text.size() + 1;
+    if (written != NULL)
+    {
+        *written = needed;
+    }
+    if (buffer == NULL || capacity < needed)
+    {
+        return (int)HPLFPSDK::Types::RESULT_ERROR_PARAM_SIZE_OUT_OF_RANGE;
+    }
+    memcpy(buffer, text.c_str(), needed);
+    return (int)HPLFPSDK::Types::RESULT_OK;
+}
+
+// Documento di un export "Ex" che ha chiesto un buffer piu' grande: il tentativo
+// successivo dello stesso thread con gli stessi parametri lo riceve senza rifare
+// tutte le letture, purche' arrivi entro PENDING_DOCUMENT_TTL.
+struct PendingDocument
+{
+    PendingDocument() : pending(false) {}
+
+    string key;
+    string text;
+    bool pending;
+    chrono::steady_clock::time_point readAt;
+};
+
+static const chrono::seconds PENDING_DOCUMENT_TTL(5);
+
+static string PendingKey(const unsigned char* text)
+{
+    return text != NULL ? string((const char*)text) : string();
+}
+
+template<typename Read>
+static int ToBufferPending(PendingDocument& document, const string& key, Read read, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_OK;
+    if (!document.pending || document.key != key || now - document.readAt > PENDING_DOCUMENT_TTL)
+    {
+        document.pending = false;
+        document.key = key;
+        document.readAt = now;
+        result = read(document.text);
+    }
+    int returned = ToBuffer(result, document.text, buffer, capacity, written);
+    document.pending = returned == (int)HPLFPSDK::Types::RESULT_ERROR_PARAM_SIZE_OUT_OF_RANGE;
+    return returned;
+}
+
+static unsigned char* GetStatus(unsigned char* ip, unsigned char* pn, StatusKind kind, MetricSeries api)
+{
+    static thread_local shared_ptr<const string> status;
+    MetricTimer timer(api);
+    try
+    {
+        HPLFPSDK::Types::Result result = timer.stop(ReadStatus(ip, pn, kind, status));
+        if (result != HPLFPSDK::Types::RESULT_OK)
         {
-            cout << "Libreria non inizializzata!" << "\n";
-            return (unsigned char*)"LIBRERIA NON INIZIALIZZATA";
+            return ToText(result, string());
         }
-        HPLFPSDK::IDevice* printer = NULL;
-        HPLFPSDK::Types::Result resultPrinter;
-        resultPrinter = hplfpsdk_getNewPrinter(ipAddress, printerName, printer);
-        if (resultPrinter != HPLFPSDK::Types::RESULT_OK)
+        return ToText(result, *status);
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+    }
+}
+
+static int GetStatusEx(unsigned char* ip, unsigned char* pn, StatusKind kind, MetricSeries api, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    MetricTimer timer(api);
+    try
+    {
+        shared_ptr<const string> status;
+        HPLFPSDK::Types::Result result = ReadStatus(ip, pn, kind, status);
+        if (result != HPLFPSDK::Types::RESULT_OK)
         {
-            //cout << "Stampante inizializzata" << endl;
+            return timer.stop(ToBuffer(result, string(), buffer, capacity, written));
+        }
+        return timer.stop(ToBuffer(result, *status, buffer, capacity, written));
+    }
+    catch (exception)
+    {
+        return timer.stop(ToBuffer(HPLFPSDK::Types::RESULT_ERROR, string(), buffer, capacity, written));
+    }
+}
 
-            //cout << "Error: " << resultPrinter << endl;
-            hplfpsdk_discardPrinter(printer);
-            hplfpsdk_terminate();
-            return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+// Blocco di record binari (vedi StatusRecords.h) copiato nel buffer del chiamante,
+// con le stesse regole di ToBuffer ma senza terminatore. Finche' la cache restituisce
+// lo stesso documento il blocco gia' convertito viene riusato.
+static int GetStatusRecords(unsigned char* ip, unsigned char* pn, StatusKind kind, MetricSeries api, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    static thread_local shared_ptr<const string> parsed[STATUS_KIND_COUNT];
+    static thread_local string blocks[STATUS_KIND_COUNT];
+    MetricTimer timer(api);
+    if (written != NULL)
+    {
+        *written = 0;
+    }
+    try
+    {
+        shared_ptr<const string> status;
+        HPLFPSDK::Types::Result result = ReadStatus(ip, pn, kind, status);
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return timer.stop((int)result);
         }
-        //GETTING REMOTE MANAGER OBJECT
-        //HPLFPSDK::IAccountingManager* accountingManager = printer->getAccountingManager();
-        char* info = NULL;
-        rsize_t longLength = 0;
-        HPLFPSDK::IInfoManager* infoManager = printer->getInfoManager();
-        result = infoManager->getPrinterStatus(&info, longLength);
-        string s = (string)info;
-        while (s.find("Not initialized") != std::string::npos)
-        {
-            result = infoManager->getPrinterStatus(&info, longLength);
-            s = (string)info;
-            //cout << index << endl;
-        }
-        char* infoLog = NULL;
-        rsize_t longLengthLog = 0;
-        HPLFPSDK::Types::Result resultLog = HPLFPSDK::Types::RESULT_OK;
-        resultLog = infoManager->getInkSystemStatus(&infoLog, longLengthLog);
-        //resultLog = infoManager->getPrintheadSlotsStatus(&infoLog, longLengthLog);
-        //resultLog = infoManager->getMaintenanceCartridgesStatus(&infoLog, longLengthLog);
-        if (resultLog == HPLFPSDK::Types::RESULT_OK)
-        {
-            hplfpsdk_discardPrinter(printer);
-            hplfpsdk_terminate();
-            return (unsigned char*)infoLog;
-        }
-        else
-        {
-            hplfpsdk_discardPrinter(printer);
-            hplfpsdk_terminate();
-            return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+        if (status != parsed[kind])
+        {
+            result = buildStatusRecords(kind, status->data(), status->size(), blocks[kind]);
+            if (result != HPLFPSDK::Types::RESULT_OK)
+            {
+                parsed[kind].reset();
+                return timer.stop((int)result);
+            }
+            parsed[kind] = status;
         }
+        const string& block = blocks[kind];
+        if (written != NULL)
+        {
+            *written = block.size();
+        }
+        if (buffer == NULL || capacity < block.size())
+        {
+            return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR_PARAM_SIZE_OUT_OF_RANGE);
+        }
+        memcpy(buffer, block.data(), block.size());
+        return timer.stop((int)HPLFPSDK::Types::RESULT_OK);
+    }
+    catch (exception)
+    {
+        return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR);
+    }
+}
+
+extern "C" HPSDKTEST_API unsigned char* GetCartridges(unsigned char* ip, unsigned char* pn)
+{
+    return GetStatus(ip, pn, STATUS_INK_SYSTEM, METRIC_API_GET_CARTRIDGES);
+}
+
+extern "C" HPSDKTEST_API unsigned char* GetPrintheads(unsigned char* ip, unsigned char* pn)
+{
+    return GetStatus(ip, pn, STATUS_PRINTHEAD_SLOTS, METRIC_API_GET_PRINTHEADS);
+}
+
+extern "C" HPSDKTEST_API unsigned char* GetMaintanance(unsigned char* ip, unsigned char* pn)
+{
+    return GetStatus(ip, pn, STATUS_MAINTENANCE_CARTRIDGES, METRIC_API_GET_MAINTANANCE);
+}
+
+// Come GetCartridges/GetPrintheads/GetMaintanance, ma il documento viene scritto
+// nel buffer del chiamante (vedi ToBuffer). Restituiscono un HPLFPSDK::Types::Result.
+extern "C" HPSDKTEST_API int GetCartridgesEx(unsigned char* ip, unsigned char* pn, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    return GetStatusEx(ip, pn, STATUS_INK_SYSTEM, METRIC_API_GET_CARTRIDGES_EX, buffer, capacity, written);
+}
+
+extern "C" HPSDKTEST_API int GetPrintheadsEx(unsigned char* ip, unsigned char* pn, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    return GetStatusEx(ip, pn, STATUS_PRINTHEAD_SLOTS, METRIC_API_GET_PRINTHEADS_EX, buffer, capacity, written);
+}
+
+extern "C" HPSDKTEST_API int GetMaintananceEx(unsigned char* ip, unsigned char* pn, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    return GetStatusEx(ip, pn, STATUS_MAINTENANCE_CARTRIDGES, METRIC_API_GET_MAINTANANCE_EX, buffer, capacity, written);
+}
+
+// Come gli export "Ex", ma al posto dell'XML scrivono uno StatusRecordHeader
+// seguito dai record InkSlotRecord/PrintheadSlotRecord/MaintenanceCartridgeRecord.
+extern "C" HPSDKTEST_API int GetCartridgesRecords(unsigned char* ip, unsigned char* pn, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    return GetStatusRecords(ip, pn, STATUS_INK_SYSTEM, METRIC_API_GET_CARTRIDGES_RECORDS, buffer, capacity, written);
+}
+
+extern "C" HPSDKTEST_API int GetPrintheadsRecords(unsigned char* ip, unsigned char* pn, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    return GetStatusRecords(ip, pn, STATUS_PRINTHEAD_SLOTS, METRIC_API_GET_PRINTHEADS_RECORDS, buffer, capacity, written);
+}
+
+extern "C" HPSDKTEST_API int GetMaintananceRecords(unsigned char* ip, unsigned char* pn, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    return GetStatusRecords(ip, pn, STATUS_MAINTENANCE_CARTRIDGES, METRIC_API_GET_MAINTANANCE_RECORDS, buffer, capacity, written);
+}
+
+// Inchiostri, testine, manutenzione, serbatoi e raccoglitori in una sola chiamata.
+extern "C" HPSDKTEST_API unsigned char* GetConsumablesSnapshot(unsigned char* ip, unsigned char* pn)
+{
+    static thread_local string snapshot;
+    MetricTimer timer(METRIC_API_GET_CONSUMABLES_SNAPSHOT);
+    try
+    {
+        return ToText(timer.stop(ReadConsumablesSnapshot(ip, pn, snapshot)), snapshot);
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+    }
+}
+
+extern "C" HPSDKTEST_API int GetConsumablesSnapshotEx(unsigned char* ip, unsigned char* pn, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    static thread_local PendingDocument snapshot;
+    MetricTimer timer(METRIC_API_GET_CONSUMABLES_SNAPSHOT_EX);
+    try
+    {
+        string key = PendingKey(ip) + '\n' + PendingKey(pn);
+        return timer.stop(ToBufferPending(snapshot, key, [&](string& text) { return ReadConsumablesSnapshot(ip, pn, text); }, buffer, capacity, written));
+    }
+    catch (exception)
+    {
+        snapshot.pending = false;
+        return timer.stop(ToBuffer(HPLFPSDK::Types::RESULT_ERROR, string(), buffer, capacity, written));
+    }
+}
+
+// Interroga piu' stampanti in parallelo.
+// printers: una riga "ip;modello" per stampante. kind: valore di StatusKind
+// (0 inchiostri, 1 testine, 2 manutenzione, ...). timeoutMs: limite per stampante.
+// Restituisce <Fleet> con un elemento <Printer> per ogni riga.
+extern "C" HPSDKTEST_API unsigned char* PollFleet(unsigned char* printers, int kind, unsigned int timeoutMs)
+{
+    static thread_local string fleet;
+    MetricTimer timer(METRIC_API_POLL_FLEET);
+    try
+    {
+        return ToText(timer.stop(ReadFleet(printers, kind, timeoutMs, fleet)), fleet);
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+    }
+}
+
+extern "C" HPSDKTEST_API int PollFleetEx(unsigned char* printers, int kind, unsigned int timeoutMs, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    static thread_local PendingDocument fleet;
+    MetricTimer timer(METRIC_API_POLL_FLEET_EX);
+    try
+    {
+        string key = to_string(kind) + ';' + to_string(timeoutMs) + '\n' + PendingKey(printers);
+        return timer.stop(ToBufferPending(fleet, key, [&](string& text) { return ReadFleet(printers, kind, timeoutMs, text); }, buffer, capacity, written));
+    }
+    catch (exception)
+    {
+        fleet.pending = false;
+        return timer.stop(ToBuffer(HPLFPSDK::Types::RESULT_ERROR, string(), buffer, capacity, written));
+    }
+}
+
+// Solo i campi cambiati dall'ultima lettura del chiamante.
+// kind: valore di StatusKind. since: attributo "to" dell'ultimo <StatusDelta>
+// ricevuto, 0 per ricevere l'intera vista (resync="true"). La risposta elenca
+// i campi come <Set path="...">valore</Set> e <Remove path="..."/>.
+extern "C" HPSDKTEST_API unsigned char* GetStatusDelta(unsigned char* ip, unsigned char* pn, int kind, unsigned long long since)
+{
+    static thread_local string delta;
+    MetricTimer timer(METRIC_API_GET_STATUS_DELTA);
+    try
+    {
+        return ToText(timer.stop(ReadStatusDelta(ip, pn, kind, since, delta)), delta);
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+    }
+}
+
+extern "C" HPSDKTEST_API int GetStatusDeltaEx(unsigned char* ip, unsigned char* pn, int kind, unsigned long long since, unsigned char* buffer, size_t capacity, size_t* written)
+{
+    static thread_local string delta;
+    MetricTimer timer(METRIC_API_GET_STATUS_DELTA_EX);
+    try
+    {
+        return timer.stop(ToBuffer(ReadStatusDelta(ip, pn, kind, since, delta), delta, buffer, capacity, written));
+    }
+    catch (exception)
+    {
+        return timer.stop(ToBuffer(HPLFPSDK::Types::RESULT_ERROR, delta, buffer, capacity, written));
+    }
+}
+
+// Come GetCartridges/GetPrintheads/GetMaintanance senza bloccare il chiamante:
+// la lettura avviene su un thread interno, che poi chiama callback (vedi
+// StatusCallback in AsyncStatusQueue.h). Richieste uguali ancora in corso
+// condividono la stessa lettura. Restituiscono l'identificativo da passare a
+// CancelStatusRequest, 0 se i parametri non sono validi.
+extern "C" HPSDKTEST_API unsigned int GetCartridgesAsync(unsigned char* ip, unsigned char* pn, StatusCallback callback, void* userData)
+{
+    try
+    {
+        return AsyncStatusQueue::instance().submit((char*)ip, (char*)pn, STATUS_INK_SYSTEM, callback, userData);
+    }
+    catch (exception)
+    {
+        return 0;
+    }
+}
+
+extern "C" HPSDKTEST_API unsigned int GetPrintheadsAsync(unsigned char* ip, unsigned char* pn, StatusCallback callback, void* userData)
+{
+    try
+    {
+        return AsyncStatusQueue::instance().submit((char*)ip, (char*)pn, STATUS_PRINTHEAD_SLOTS, callback, userData);
+    }
+    catch (exception)
+    {
+        return 0;
+    }
+}
+
+extern "C" HPSDKTEST_API unsigned int GetMaintananceAsync(unsigned char* ip, unsigned char* pn, StatusCallback callback, void* userData)
+{
+    try
+    {
+        return AsyncStatusQueue::instance().submit((char*)ip, (char*)pn, STATUS_MAINTENANCE_CARTRIDGES, callback, userData);
+    }
+    catch (exception)
+    {
+        return 0;
+    }
+}
+
+// Annulla una richiesta asincrona. RESULT_OK: la callback non verra' chiamata.
+// RESULT_ERROR_ELEMENT_NOT_FOUND: la callback e' gia' stata chiamata o e' in corso.
+extern "C" HPSDKTEST_API int CancelStatusRequest(unsigned int requestId)
+{
+    if (AsyncStatusQueue::instance().cancel(requestId))
+    {
+        return (int)HPLFPSDK::Types::RESULT_OK;
+    }
+    return (int)HPLFPSDK::Types::RESULT_ERROR_ELEMENT_NOT_FOUND;
+}
+
+// Avvia in background la ricerca delle stampanti in rete (tempi in secondi, vedi
+// hplfpsdk_getNetworkPrintersExtended; supportedOnly != 0 solo modelli supportati).
+// Se una ricerca e' gia' in corso non ne parte un'altra. Restituisce RESULT_OK.
+extern "C" HPSDKTEST_API int StartDiscovery(unsigned int queryTimeout, unsigned int discoveryTimeout, int supportedOnly)
+{
+    try
+    {
+        DiscoveryService::instance().rescan(queryTimeout, discoveryTimeout, supportedOnly != 0);
+        return (int)HPLFPSDK::Types::RESULT_OK;
+    }
+    catch (exception)
+    {
+        return (int)HPLFPSDK::Types::RESULT_ERROR;
+    }
+}
+
+// Stampanti note, senza attendere la ricerca: quelle del file di cache e quelle
+// trovate dalle ricerche concluse. <DiscoveredPrinters scanning="true|false">
+// con un <Printer ip="..." model="..." lastSeen="..."/> per stampante.
+extern "C" HPSDKTEST_API unsigned char* GetDiscoveredPrinters()
+{
+    static thread_local string printers;
+    try
+    {
+        DiscoveryService& service = DiscoveryService::instance();
+        printers = DiscoveryService::toXml(service.printers(), service.scanning());
+        return (unsigned char*)printers.c_str();
     }
     catch (exception)
     {
         return (unsigned char*)"STAMPANTE NON DISPONIBILE";
     }
 }
-extern "C" __declspec(dllexport) unsigned char* GetPrintheads(unsigned char* ip, unsigned char* pn)
+
+// Modello della stampante con questo indirizzo, stringa vuota se non e' stata trovata.
+extern "C" HPSDKTEST_API unsigned char* LookupPrinterModel(unsigned char* ip)
 {
+    static thread_local string model;
     try
     {
-        //cout << "Hello World!\n";
-        char* ipAddress = (char*)ip;
-        char* printerName = (char*)pn;
-        hplfpsdk_setLogLevel(HPLFPSDK::Types::LOG_LEVEL_NONE);
-        HPLFPSDK::Types::Result result = hplfpsdk_init();
-        if (result == HPLFPSDK::Types::RESULT_OK)
+        if (ip == NULL || !DiscoveryService::instance().lookup((char*)ip, model))
         {
-            cout << "Libreria inizializzata correttamente!" << "\n";
+            model.clear();
         }
-        else
+        return (unsigned char*)model.c_str();
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"";
+    }
+}
+
+// File in cui la ricerca salva le stampanti trovate (predefinito: variabile
+// d'ambiente HPSDK_DISCOVERY_CACHE oppure HPSDKTest.discovery nella cartella
+// temporanea). NULL o stringa vuota per non usare il file.
+extern "C" HPSDKTEST_API void SetDiscoveryCacheFile(unsigned char* path)
+{
+    try
+    {
+        DiscoveryService::instance().setCacheFile(path != NULL ? (char*)path : "");
+    }
+    catch (exception)
+    {
+    }
+}
+
+// Prepara in parallelo le stampanti indicate (righe "ip;modello" come PollFleet):
+// creazione del device, attesa di "Not initialized" e prima lettura dello stato.
+// Le stampanti restano aperte come con OpenPrinter. Attende al massimo timeoutMs
+// (0 = non attende): RESULT_OK se il pool e' pronto, altrimenti RESULT_ERROR_TIMEOUT
+// e la preparazione prosegue in background (vedi GetWarmPoolStatus).
+extern "C" HPSDKTEST_API int WarmUpPrinters(unsigned char* printers, unsigned int timeoutMs)
+{
+    try
+    {
+        HPLFPSDK::Types::Result result = InitLibrary();
+        if (result != HPLFPSDK::Types::RESULT_OK)
         {
-            cout << "Libreria non inizializzata!" << "\n";
-            return (unsigned char*)"LIBRERIA NON INIZIALIZZATA";
+            return (int)result;
         }
-        HPLFPSDK::IDevice* printer = NULL;
-        HPLFPSDK::Types::Result resultPrinter;
-        resultPrinter = hplfpsdk_getNewPrinter(ipAddress, printerName, printer);
-        if (resultPrinter != HPLFPSDK::Types::RESULT_OK)
+        WarmPool& pool = WarmPool::instance();
+        pool.start(FleetPoller::parsePrinterList((char*)printers));
+        if (!pool.wait(chrono::milliseconds(timeoutMs)))
         {
-            //cout << "Stampante inizializzata" << endl;
-
-            //cout << "Error: " << resultPrinter << endl;
-            hplfpsdk_discardPrinter(printer);
-            hplfpsdk_terminate();
-            return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+            return (int)HPLFPSDK::Types::RESULT_ERROR_TIMEOUT;
         }
-        //GETTING REMOTE MANAGER OBJECT
-        //HPLFPSDK::IAccountingManager* accountingManager = printer->getAccountingManager();
-        char* info = NULL;
-        rsize_t longLength = 0;
-        HPLFPSDK::IInfoManager* infoManager = printer->getInfoManager();
-        result = infoManager->getPrinterStatus(&info, longLength);
-        string s = (string)info;
-        while (s.find("Not initialized") != std::string::npos)
-        {
-            result = infoManager->getPrinterStatus(&info, longLength);
-            s = (string)info;
-            //cout << index << endl;
-        }
-        char* infoLog = NULL;
-        rsize_t longLengthLog = 0;
-        HPLFPSDK::Types::Result resultLog = HPLFPSDK::Types::RESULT_OK;
-        //resultLog = infoManager->getInkSystemStatus(&infoLog, longLengthLog);
-        resultLog = infoManager->getPrintheadSlotsStatus(&infoLog, longLengthLog);
-        //resultLog = infoManager->getMaintenanceCartridgesStatus(&infoLog, longLengthLog);
-        if (resultLog == HPLFPSDK::Types::RESULT_OK)
-        {
-            hplfpsdk_discardPrinter(printer);
-            hplfpsdk_terminate();
-            return (unsigned char*)infoLog;
-        }
-        else
-        {
-            hplfpsdk_discardPrinter(printer);
-            hplfpsdk_terminate();
+        return (int)HPLFPSDK::Types::RESULT_OK;
+    }
+    catch (exception)
+    {
+        return (int)HPLFPSDK::Types::RESULT_ERROR;
+    }
+}
+
+// <WarmPool ready="true|false"> con un <Printer ip model result elapsedMs/> per
+// stampante; result ed elapsedMs mancano finche' la stampante e' in preparazione.
+extern "C" HPSDKTEST_API unsigned char* GetWarmPoolStatus()
+{
+    static thread_local string status;
+    try
+    {
+        WarmPool& pool = WarmPool::instance();
+        status = WarmPool::toXml(pool.results(), pool.ready());
+        return (unsigned char*)status.c_str();
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+    }
+}
+
+// Apre la stampante e la tiene nella sessione fino a ClosePrinter:
+// le chiamate successive non ripetono hplfpsdk_getNewPrinter.
+extern "C" HPSDKTEST_API int OpenPrinter(unsigned char* ip, unsigned char* pn)
+{
+    MetricTimer timer(METRIC_API_OPEN_PRINTER);
+    try
+    {
+        return timer.stop((int)PrinterSession::instance().open((char*)ip, (char*)pn));
+    }
+    catch (exception)
+    {
+        return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR);
+    }
+}
+
+extern "C" HPSDKTEST_API int ClosePrinter(unsigned char* ip, unsigned char* pn)
+{
+    MetricTimer timer(METRIC_API_CLOSE_PRINTER);
+    try
+    {
+        return timer.stop((int)PrinterSession::instance().close((char*)ip, (char*)pn));
+    }
+    catch (exception)
+    {
+        return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR);
+    }
+}
+
+// Tempo massimo di attesa perche' una stampante esca da "Not initialized".
+extern "C" HPSDKTEST_API void SetReadyTimeout(unsigned int milliseconds)
+{
+    PrinterSession::instance().setReadyTimeout(chrono::milliseconds(milliseconds));
+}
+
+// Dopo quanto tempo senza utilizzi una stampante non aperta con OpenPrinter
+// viene scartata, insieme alla sua sessione e alle sottoscrizioni (predefinito 60 s).
+extern "C" HPSDKTEST_API void SetIdleTimeout(unsigned int seconds)
+{
+    PrinterSession::instance().setIdleTimeout(chrono::seconds(seconds));
+}
+
+// Dopo quanto tempo senza eventi la cache di stato rilegge una vista dalla stampante.
+extern "C" HPSDKTEST_API void SetStatusCacheWindow(unsigned int milliseconds)
+{
+    StatusCache::setStaleAfter(chrono::milliseconds(milliseconds));
+}
+
+// Circuit breaker delle stampanti irraggiungibili (vedi PrinterHealth): dopo
+// failures errori di connessione consecutivi le richieste vengono respinte subito
+// per un'attesa tra backoffMs/2 e backoffMs, che raddoppia a ogni prova fallita
+// fino a maxBackoffMs. Valori iniziali: 3, 1000, 60000.
+extern "C" HPSDKTEST_API void SetCircuitBreaker(unsigned int failures, unsigned int backoffMs, unsigned int maxBackoffMs)
+{
+    PrinterHealth::instance().configure(failures, chrono::milliseconds(backoffMs), chrono::milliseconds(maxBackoffMs));
+}
+
+// Stampanti con errori di connessione recenti: <PrinterHealth> con un
+// <Printer ip state="closed|open|half-open" failures result retryInMs/> ciascuna.
+extern "C" HPSDKTEST_API unsigned char* GetPrinterHealth()
+{
+    static thread_local string health;
+    try
+    {
+        health = PrinterHealth::toXml(PrinterHealth::instance().printers());
+        return (unsigned char*)health.c_str();
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+    }
+}
+
+// Storico di una metrica di uno slot ("level" o "state", vedi TimeSeriesStore)
+// tra fromMs e toMs, millisecondi dal 1970 compresi:
+// <History key="ip/slot/metrica"><Point time="..." value="..."/>...</History>
+extern "C" HPSDKTEST_API unsigned char* GetLevelHistory(unsigned char* ip, unsigned char* slot, unsigned char* metric, long long fromMs, long long toMs)
+{
+    static thread_local string history;
+    try
+    {
+        if (ip == NULL || slot == NULL || metric == NULL)
+        {
             return (unsigned char*)"STAMPANTE NON DISPONIBILE";
         }
+        string key = string((char*)ip) + "/" + (char*)slot + "/" + (char*)metric;
+        vector<HistoryPoint> points;
+        TimeSeriesStore::instance().query(key, fromMs, toMs, points);
+        history = TimeSeriesStore::toXml(key, points);
+        return (unsigned char*)history.c_str();
     }
     catch (exception)
     {
@@ -142,67 +732,182 @@ extern "C" __declspec(dllexport) unsigned char* GetPrintheads(unsigned char* ip,
     }
 }
 
-extern "C" __declspec(dllexport) unsigned char* GetMaintanance(unsigned char* ip, unsigned char* pn)
+// Serie registrate con numero di punti, spazio su disco e intervallo di tempo.
+extern "C" HPSDKTEST_API unsigned char* GetHistorySeries()
 {
+    static thread_local string series;
     try
     {
-        //cout << "Hello World!\n";
-        char* ipAddress = (char*)ip;
-        char* printerName = (char*)pn;
-        hplfpsdk_setLogLevel(HPLFPSDK::Types::LOG_LEVEL_NONE);
-        HPLFPSDK::Types::Result result = hplfpsdk_init();
-        if (result == HPLFPSDK::Types::RESULT_OK)
+        series = TimeSeriesStore::toXml(TimeSeriesStore::instance().series());
+        return (unsigned char*)series.c_str();
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+    }
+}
+
+// Cartella dello storico dei livelli; stringa vuota per non registrarlo.
+// Senza questa chiamata ne' HPSDK_HISTORY_DIR lo storico e' disattivato.
+extern "C" HPSDKTEST_API void SetHistoryDirectory(unsigned char* path)
+{
+    try
+    {
+        TimeSeriesStore::instance().setDirectory(path != NULL ? (char*)path : "");
+    }
+    catch (exception)
+    {
+    }
+}
+
+// Giorni di storico conservati (0 = senza limite); i segmenti piu' vecchi
+// vengono cancellati.
+extern "C" HPSDKTEST_API void SetHistoryRetention(unsigned int days)
+{
+    try
+    {
+        TimeSeriesStore::instance().setRetention(chrono::hours((long long)days * 24));
+    }
+    catch (exception)
+    {
+    }
+}
+
+// Previsione di esaurimento di inchiostri, cartucce di manutenzione e
+// raccoglitori (riempimento) della stampante, o di tutte con ip NULL o vuoto:
+// <DepletionForecast><Slot ip id kind level ratePerDay samples emptyAt hoursLeft/>...
+// emptyAt e hoursLeft mancano se il livello non sta calando.
+extern "C" HPSDKTEST_API unsigned char* GetDepletionForecast(unsigned char* ip)
+{
+    static thread_local string forecast;
+    try
+    {
+        const long long now = (long long)chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        forecast = DepletionForecaster::toXml(DepletionForecaster::instance().forecasts(ip != NULL ? (char*)ip : ""), now);
+        return (unsigned char*)forecast.c_str();
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+    }
+}
+
+// Ore dopo le quali un campione pesa la meta' nella previsione (predefinito 72).
+extern "C" HPSDKTEST_API void SetForecastHalfLife(unsigned int hours)
+{
+    DepletionForecaster::instance().setHalfLife((double)hours);
+}
+
+// Stampa un'immagine PPM (P6) o PAM (P7, RGB o RGB_ALPHA) a 8 bit come job di
+// una pagina con la rasterConfig indicata: CHUNKY a 32 bit o PLANAR CMYK a 8
+// bit ("CHUNKY-XRGB-32-600-PCL3_TAOS"; vedi parseRasterLayout). Con spoolPath NULL o
+// vuoto l'SDK invia il job alla stampante e chiama callback con i byte
+// trasmessi, altrimenti il job viene scritto nel file spoolPath (vedi
+// MappedSpoolHandler). Con ip NULL o vuoto il device e' offline: il job va
+// solo su file e non si attende la stampante.
+extern "C" HPSDKTEST_API int SubmitRasterJob(unsigned char* ip, unsigned char* pn, unsigned char* imagePath, unsigned char* rasterConfig,
+                                             unsigned char* jobName, unsigned char* spoolPath,
+                                             HPLFPSDK::IJobPacker::transmissionStatusCallback callback, void* userData)
+{
+    MetricTimer timer(METRIC_API_SUBMIT_RASTER_JOB);
+    try
+    {
+        const bool offline = ip == NULL || *ip == '\0';
+        const bool spooled = spoolPath != NULL && *spoolPath != '\0';
+        if (imagePath == NULL || rasterConfig == NULL || (offline && !spooled))
         {
-            cout << "Libreria inizializzata correttamente!" << "\n";
+            return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER);
         }
-        else
+        HPLFPSDK::Types::Result result = InitLibrary();
+        if (result != HPLFPSDK::Types::RESULT_OK)
         {
-            cout << "Libreria non inizializzata!" << "\n";
-            return (unsigned char*)"LIBRERIA NON INIZIALIZZATA";
+            return timer.stop((int)result);
         }
-        HPLFPSDK::IDevice* printer = NULL;
-        HPLFPSDK::Types::Result resultPrinter;
-        resultPrinter = hplfpsdk_getNewPrinter(ipAddress, printerName, printer);
-        if (resultPrinter != HPLFPSDK::Types::RESULT_OK)
+        NetpbmRasterSource source;
+        MappedSpoolHandler spool;
+        if (!source.open((char*)imagePath) || (spooled && !spool.open((char*)spoolPath)))
         {
-            //cout << "Stampante inizializzata" << endl;
+            return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER);
+        }
+        RasterJob job;
+        job.source = &source;
+        job.rasterConfig = (char*)rasterConfig;
+        job.jobName = jobName != NULL ? (char*)jobName : "";
+        job.memoryHandler = spooled ? &spool : NULL;
+        job.callback = callback;
+        job.userData = userData;
 
-            //cout << "Error: " << resultPrinter << endl;
-            hplfpsdk_discardPrinter(printer);
-            hplfpsdk_terminate();
-            return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+        result = SendRasterJob(offline ? "" : (char*)ip, pn, job);
+        if (spooled && !spool.close() && result == HPLFPSDK::Types::RESULT_OK)
+        {
+            result = HPLFPSDK::Types::RESULT_ERROR_MEMORY;
         }
-        //GETTING REMOTE MANAGER OBJECT
-        //HPLFPSDK::IAccountingManager* accountingManager = printer->getAccountingManager();
-        char* info = NULL;
-        rsize_t longLength = 0;
-        HPLFPSDK::IInfoManager* infoManager = printer->getInfoManager();
-        result = infoManager->getPrinterStatus(&info, longLength);
-        string s = (string)info;
-        while (s.find("Not initialized") != std::string::npos)
-        {
-            result = infoManager->getPrinterStatus(&info, longLength);
-            s = (string)info;
-            //cout << index << endl;
-        }
-        char* infoLog = NULL;
-        rsize_t longLengthLog = 0;
-        HPLFPSDK::Types::Result resultLog = HPLFPSDK::Types::RESULT_OK;
-        //resultLog = infoManager->getInkSystemStatus(&infoLog, longLengthLog);
-        //resultLog = infoManager->getPrintheadSlotsStatus(&infoLog, longLengthLog);
-        resultLog = infoManager->getMaintenanceCartridgesStatus(&infoLog, longLengthLog);
-        if (resultLog == HPLFPSDK::Types::RESULT_OK)
-        {
-            hplfpsdk_discardPrinter(printer);
-            hplfpsdk_terminate();
-            return (unsigned char*)infoLog;
-        }
-        else
-        {
-            hplfpsdk_discardPrinter(printer);
-            hplfpsdk_terminate();
-            return (unsigned char*)"STAMPANTE NON DISPONIBILE";
+        return timer.stop((int)result);
+    }
+    catch (exception)
+    {
+        return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR);
+    }
+}
+
+// Come SubmitRasterJob, ma il job viene inviato dal wrapper alla porta raw
+// della stampante (port, 0 = 9100) invece che dall'SDK (vedi JobTransmitter):
+// al massimo maxInFlightBytes (0 = 16 MiB) tra conversione e rete, callback
+// con i byte spediti in totale dopo ogni scrittura, dal thread di invio.
+extern "C" HPSDKTEST_API int StreamRasterJob(unsigned char* ip, unsigned char* pn, unsigned char* imagePath, unsigned char* rasterConfig,
+                                             unsigned char* jobName, unsigned int port, unsigned int maxInFlightBytes,
+                                             HPLFPSDK::IJobPacker::transmissionStatusCallback callback, void* userData)
+{
+    MetricTimer timer(METRIC_API_STREAM_RASTER_JOB);
+    try
+    {
+        if (ip == NULL || *ip == '\0' || imagePath == NULL || rasterConfig == NULL || port > 65535)
+        {
+            return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER);
+        }
+        HPLFPSDK::Types::Result result = InitLibrary();
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return timer.stop((int)result);
+        }
+        NetpbmRasterSource source;
+        if (!source.open((char*)imagePath))
+        {
+            return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER);
         }
+        JobTransmitter transmitter(maxInFlightBytes, callback, userData);
+        result = transmitter.connect((char*)ip, (unsigned short)port, chrono::milliseconds(JobTransmitter::CONNECT_TIMEOUT_MS));
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return timer.stop((int)result);
+        }
+        RasterJob job;
+        job.source = &source;
+        job.rasterConfig = (char*)rasterConfig;
+        job.jobName = jobName != NULL ? (char*)jobName : "";
+        job.memoryHandler = &transmitter;
+
+        result = SendRasterJob((char*)ip, pn, job);
+        // Con la connessione caduta l'SDK vede solo RESULT_ERROR_MEMORY da acquireBuffer
+        HPLFPSDK::Types::Result sent = transmitter.finish();
+        return timer.stop((int)(sent != HPLFPSDK::Types::RESULT_OK ? sent : result));
+    }
+    catch (exception)
+    {
+        return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR);
+    }
+}
+
+// Buffer dei job (vedi BufferPool): <BufferPool allocations oversize reservedBytes
+// inUseBytes highWaterBytes> con un <Class size buffers inUse highWater acquired/>
+// per classe usata. allocations non cresce piu' quando il pool e' a regime.
+extern "C" HPSDKTEST_API unsigned char* GetJobMemoryStats()
+{
+    static thread_local string stats;
+    try
+    {
+        stats = BufferPool::toXml(BufferPool::instance().stats());
+        return (unsigned char*)stats.c_str();
     }
     catch (exception)
     {
@@ -210,6 +915,53 @@ extern "C" __declspec(dllexport) unsigned char* GetMaintanance(unsigned char* ip
     }
 }
 
+// Prealloca count buffer liberi da bytes byte (arrotondati alla classe) per i
+// job successivi; RESULT_ERROR_MEMORY oltre i 16 MiB o se l'allocazione fallisce.
+extern "C" HPSDKTEST_API int ReserveJobMemory(unsigned int bytes, unsigned int count)
+{
+    try
+    {
+        return (int)(BufferPool::instance().reserve(bytes, count) ? HPLFPSDK::Types::RESULT_OK : HPLFPSDK::Types::RESULT_ERROR_MEMORY);
+    }
+    catch (exception)
+    {
+        return (int)HPLFPSDK::Types::RESULT_ERROR_MEMORY;
+    }
+}
+
+// Scarta tutte le stampanti e chiama hplfpsdk_terminate.
+extern "C" HPSDKTEST_API int CloseSession()
+{
+    MetricTimer timer(METRIC_API_CLOSE_SESSION);
+    try
+    {
+        // La ricerca in coda non deve reinizializzare la libreria dopo terminate
+        DiscoveryService::instance().stop();
+        return timer.stop((int)PrinterSession::instance().terminate());
+    }
+    catch (exception)
+    {
+        return timer.stop((int)HPLFPSDK::Types::RESULT_ERROR);
+    }
+}
+
+// Metriche del wrapper in formato testo Prometheus (vedi Metrics.h): durata delle
+// fasi verso l'SDK e degli export, errori per Types::Result, contatori.
+// Il testo resta valido fino alla chiamata successiva sullo stesso thread.
+extern "C" HPSDKTEST_API unsigned char* GetMetrics()
+{
+    static thread_local string metrics;
+    try
+    {
+        metrics = Metrics::instance().toPrometheus();
+        return (unsigned char*)metrics.c_str();
+    }
+    catch (exception)
+    {
+        return (unsigned char*)"";
+    }
+}
+
 // Per eseguire il programma: CTRL+F5 oppure Debug > Avvia senza eseguire debug
 // Per eseguire il debug del programma: F5 oppure Debug > Avvia debug
 
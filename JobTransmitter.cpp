@@ -0,0 +1,468 @@
+#include "JobTransmitter.h"
+
+#include <algorithm>
+#include "Metrics.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    const uintptr_t NO_SOCKET = (uintptr_t)-1;
+
+    struct Chunk
+    {
+        const uint8_t* data;
+        size_t size;
+    };
+
+#ifdef _WIN32
+    typedef SOCKET NativeSocket;
+
+    bool startSockets()
+    {
+        static const bool started = []()
+        {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        return started;
+    }
+
+    void closeSocket(NativeSocket socket)
+    {
+        shutdown(socket, SD_SEND);
+        closesocket(socket);
+    }
+
+    bool setBlocking(NativeSocket socket, bool blocking)
+    {
+        u_long mode = blocking ? 0 : 1;
+        return ioctlsocket(socket, FIONBIO, &mode) == 0;
+    }
+
+    bool connectPending()
+    {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+
+    // true se il socket diventa scrivibile (o fallisce la connessione) entro timeout
+    bool waitWritable(NativeSocket socket, chrono::milliseconds timeout)
+    {
+        WSAPOLLFD descriptor = {};
+        descriptor.fd = socket;
+        descriptor.events = POLLWRNORM;
+        return WSAPoll(&descriptor, 1, (INT)timeout.count()) == 1;
+    }
+
+    bool setSendTimeout(NativeSocket socket, chrono::milliseconds timeout)
+    {
+        DWORD milliseconds = (DWORD)timeout.count();
+        return setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&milliseconds, sizeof(milliseconds)) == 0;
+    }
+
+    // Byte inviati, o -1 in caso di errore
+    long long sendChunks(NativeSocket socket, const Chunk* chunks, size_t count)
+    {
+        WSABUF buffers[JobTransmitter::MAX_BATCH];
+        for (size_t i = 0; i < count; i++)
+        {
+            buffers[i].buf = (char*)chunks[i].data;
+            buffers[i].len = (ULONG)chunks[i].size;
+        }
+        DWORD sent = 0;
+        if (WSASend(socket, buffers, (DWORD)count, &sent, 0, NULL, NULL) != 0)
+        {
+            return -1;
+        }
+        return (long long)sent;
+    }
+#else
+    typedef int NativeSocket;
+
+    bool startSockets()
+    {
+        return true;
+    }
+
+    void closeSocket(NativeSocket socket)
+    {
+        shutdown(socket, SHUT_WR);
+        close(socket);
+    }
+
+    bool setBlocking(NativeSocket socket, bool blocking)
+    {
+        int flags = fcntl(socket, F_GETFL, 0);
+        return flags >= 0 && fcntl(socket, F_SETFL, blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK) == 0;
+    }
+
+    bool connectPending()
+    {
+        return errno == EINPROGRESS;
+    }
+
+    bool waitWritable(NativeSocket socket, chrono::milliseconds timeout)
+    {
+        struct pollfd descriptor = {};
+        descriptor.fd = socket;
+        descriptor.events = POLLOUT;
+        const chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + timeout;
+        for (;;)
+        {
+            chrono::milliseconds left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+            int ready = poll(&descriptor, 1, left.count() > 0 ? (int)left.count() : 0);
+            if (ready >= 0 || errno != EINTR)
+            {
+                return ready == 1;
+            }
+        }
+    }
+
+    bool setSendTimeout(NativeSocket socket, chrono::milliseconds timeout)
+    {
+        struct timeval wait;
+        wait.tv_sec = (long)(timeout.count() / 1000);
+        wait.tv_usec = (long)(timeout.count() % 1000) * 1000;
+        return setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &wait, sizeof(wait)) == 0;
+    }
+
+    long long sendChunks(NativeSocket socket, const Chunk* chunks, size_t count)
+    {
+        struct iovec vectors[JobTransmitter::MAX_BATCH];
+        for (size_t i = 0; i < count; i++)
+        {
+            vectors[i].iov_base = (void*)chunks[i].data;
+            vectors[i].iov_len = chunks[i].size;
+        }
+        struct msghdr message = {};
+        message.msg_iov = vectors;
+        message.msg_iovlen = count;
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        ssize_t sent;
+        do
+        {
+            sent = sendmsg(socket, &message, flags);
+        }
+        while (sent < 0 && errno == EINTR);
+        return (long long)sent;
+    }
+#endif
+
+    // Connessione con timeout: connect non bloccante e attesa con poll, che a
+    // differenza di select non ha limiti sul valore del descrittore
+    bool connectWithin(NativeSocket socket, const struct addrinfo* address, chrono::milliseconds timeout)
+    {
+        if (!setBlocking(socket, false))
+        {
+            return false;
+        }
+        if (::connect(socket, address->ai_addr, (int)address->ai_addrlen) != 0)
+        {
+            if (!connectPending())
+            {
+                return false;
+            }
+            if (!waitWritable(socket, timeout))
+            {
+                return false;
+            }
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (getsockopt(socket, SOL_SOCKET, SO_ERROR, (char*)&error, &length) != 0 || error != 0)
+            {
+                return false;
+            }
+        }
+        // Una stampante che smette di leggere fa fallire l'invio invece di bloccarlo
+        return setBlocking(socket, true) && setSendTimeout(socket, chrono::milliseconds(JobTransmitter::SEND_TIMEOUT_MS));
+    }
+}
+
+JobTransmitter::JobTransmitter(size_t maxInFlight, HPLFPSDK::IJobPacker::transmissionStatusCallback callback, void* userData)
+    : pool_(BufferPool::instance()),
+      maxInFlight_(maxInFlight > 0 ? maxInFlight : DEFAULT_MAX_IN_FLIGHT),
+      callback_(callback),
+      userData_(userData),
+      socket_(NO_SOCKET),
+      inFlight_(0),
+      unsent_(0),
+      peakInFlight_(0),
+      sent_(0),
+      closing_(false),
+      failed_(false)
+{
+}
+
+JobTransmitter::~JobTransmitter()
+{
+    finish();
+}
+
+HPLFPSDK::Types::Result JobTransmitter::connect(const string& host, unsigned short port, chrono::milliseconds timeout)
+{
+    if (socket_ != NO_SOCKET || !startSockets())
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_USAGE_SEQUENCE;
+    }
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addresses = NULL;
+    if (getaddrinfo(host.c_str(), to_string(port != 0 ? port : (unsigned short)DEFAULT_PORT).c_str(), &hints, &addresses) != 0)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_CONNECTION;
+    }
+    for (struct addrinfo* address = addresses; address != NULL && socket_ == NO_SOCKET; address = address->ai_next)
+    {
+        NativeSocket candidate = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (candidate == (NativeSocket)NO_SOCKET)
+        {
+            continue;
+        }
+        if (connectWithin(candidate, address, timeout))
+        {
+            socket_ = (uintptr_t)candidate;
+        }
+        else
+        {
+            closeSocket(candidate);
+        }
+    }
+    freeaddrinfo(addresses);
+    if (socket_ == NO_SOCKET)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_CONNECTION;
+    }
+    thread_ = thread(&JobTransmitter::run, this);
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result JobTransmitter::finish()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        closing_ = true;
+    }
+    queued_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+    if (socket_ == NO_SOCKET)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_CONNECTION;
+    }
+    closeSocket((NativeSocket)socket_);
+    socket_ = NO_SOCKET;
+    lock_guard<mutex> lock(mutex_);
+    return failed_ ? HPLFPSDK::Types::RESULT_ERROR_CONNECTION : HPLFPSDK::Types::RESULT_OK;
+}
+
+void* JobTransmitter::acquireBuffer(uint32_t numBytes)
+{
+    const size_t size = max((size_t)numBytes, (size_t)1);
+    unique_lock<mutex> lock(mutex_);
+    if (!failed_ && unsent_ > 0 && inFlight_ + size > maxInFlight_)
+    {
+        Metrics::instance().increment(METRIC_TRANSMIT_BACKPRESSURE);
+        space_.wait(lock, [this, size] { return failed_ || unsent_ == 0 || inFlight_ + size <= maxInFlight_; });
+    }
+    if (failed_ || closing_ || socket_ == NO_SOCKET)
+    {
+        return NULL;
+    }
+    void* buffer = pool_.acquire(size);
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+    acquired_.push_back(make_pair((const uint8_t*)buffer, size));
+    inFlight_ += size;
+    peakInFlight_ = max(peakInFlight_, inFlight_);
+    return buffer;
+}
+
+void JobTransmitter::releaseBuffer(const uint8_t* buffer, uint32_t numBytes)
+{
+    unique_lock<mutex> lock(mutex_);
+    vector<pair<const uint8_t*, size_t> >::iterator it = acquired_.begin();
+    while (it != acquired_.end() && it->first != buffer)
+    {
+        ++it;
+    }
+    if (it == acquired_.end())
+    {
+        return;
+    }
+    // In volo resta solo la parte usata
+    size_t used = min((size_t)numBytes, it->second);
+    inFlight_ -= it->second - used;
+    acquired_.erase(it);
+    if (failed_ || used == 0)
+    {
+        inFlight_ -= used;
+        pool_.release(buffer);
+        lock.unlock();
+        space_.notify_all();
+        return;
+    }
+    Pending pending;
+    pending.buffer = buffer;
+    pending.size = (uint32_t)used;
+    queue_.push_back(pending);
+    unsent_ += used;
+    lock.unlock();
+    queued_.notify_one();
+    space_.notify_all();
+}
+
+void JobTransmitter::run()
+{
+    vector<Pending> batch;
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lock(mutex_);
+            queued_.wait(lock, [this] { return !queue_.empty() || closing_; });
+            if (queue_.empty())
+            {
+                return;
+            }
+            batch.clear();
+            while (!queue_.empty() && batch.size() < MAX_BATCH)
+            {
+                batch.push_back(queue_.front());
+                queue_.pop_front();
+            }
+        }
+        MetricTimer timer(METRIC_PHASE_TRANSMIT);
+        bool ok = sendBatch(batch);
+        timer.stop(ok ? HPLFPSDK::Types::RESULT_OK : HPLFPSDK::Types::RESULT_ERROR_CONNECTION);
+        unsigned long long sent = 0;
+        {
+            lock_guard<mutex> lock(mutex_);
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                inFlight_ -= batch[i].size;
+                unsent_ -= batch[i].size;
+                sent_ += ok ? batch[i].size : 0;
+                pool_.release(batch[i].buffer);
+            }
+            if (ok)
+            {
+                lastSend_ = chrono::steady_clock::now();
+            }
+            else
+            {
+                failLocked();
+            }
+            sent = sent_;
+        }
+        space_.notify_all();
+        if (!ok)
+        {
+            return;
+        }
+        if (callback_ != NULL)
+        {
+            callback_(userData_, (size_t)sent);
+        }
+    }
+}
+
+bool JobTransmitter::sendBatch(const vector<Pending>& batch)
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (sent_ == 0)
+        {
+            firstSend_ = chrono::steady_clock::now();
+        }
+    }
+    Chunk chunks[MAX_BATCH];
+    size_t first = 0;
+    size_t offset = 0;
+    while (first < batch.size())
+    {
+        size_t count = 0;
+        for (size_t i = first; i < batch.size(); i++, count++)
+        {
+            chunks[count].data = batch[i].buffer + (i == first ? offset : 0);
+            chunks[count].size = batch[i].size - (i == first ? offset : 0);
+        }
+        long long sent = sendChunks((NativeSocket)socket_, chunks, count);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        // Invio parziale: si riparte dal primo byte non spedito
+        while (sent > 0)
+        {
+            size_t remaining = batch[first].size - offset;
+            if ((size_t)sent >= remaining)
+            {
+                sent -= (long long)remaining;
+                first++;
+                offset = 0;
+            }
+            else
+            {
+                offset += (size_t)sent;
+                sent = 0;
+            }
+        }
+    }
+    return true;
+}
+
+void JobTransmitter::failLocked()
+{
+    failed_ = true;
+    for (size_t i = 0; i < queue_.size(); i++)
+    {
+        inFlight_ -= queue_[i].size;
+        unsent_ -= queue_[i].size;
+        pool_.release(queue_[i].buffer);
+    }
+    queue_.clear();
+}
+
+unsigned long long JobTransmitter::bytesSent() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return sent_;
+}
+
+double JobTransmitter::throughput() const
+{
+    lock_guard<mutex> lock(mutex_);
+    double seconds = chrono::duration<double>(lastSend_ - firstSend_).count();
+    return sent_ > 0 && seconds > 0 ? (double)sent_ / seconds : 0.0;
+}
+
+size_t JobTransmitter::peakInFlight() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return peakInFlight_;
+}
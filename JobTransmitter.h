@@ -0,0 +1,90 @@
+#ifndef JOB_TRANSMITTER_H
+#define JOB_TRANSMITTER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "BufferPool.h"
+#include "IJobPacker.h"
+
+// IMemoryHandler che invia il job alla stampante (porta raw 9100) invece di
+// lasciarlo fare all'SDK: i buffer rilasciati vengono accodati e un thread di
+// I/O li spedisce con scritture vettoriali (writev/WSASend) di al massimo
+// MAX_BATCH buffer, poi li restituisce a BufferPool.
+//
+// I byte in volo (concessi da acquireBuffer e non ancora spediti) non superano
+// maxInFlight: oltre il limite acquireBuffer attende il thread di I/O, cosi'
+// una stampante lenta rallenta l'SDK invece di far crescere la memoria.
+// L'attesa dura solo finche' ci sono byte rilasciati da spedire: i buffer che
+// l'SDK tiene ancora non li libera nessuno, quindi quando il thread di I/O ha
+// spedito tutto il buffer viene concesso anche oltre il limite.
+//
+// Dopo ogni invio callback riceve i byte spediti in totale, come la
+// transmissionStatusCallback dell'SDK, dal thread di I/O. Un invio che non
+// spedisce nulla per SEND_TIMEOUT_MS (stampante che non legge piu') e' un
+// errore di rete: dopo un errore acquireBuffer restituisce NULL e il job
+// fallisce con RESULT_ERROR_MEMORY.
+class JobTransmitter : public HPLFPSDK::IJobPacker::IMemoryHandler
+{
+public:
+    enum { DEFAULT_PORT = 9100, MAX_BATCH = 64, CONNECT_TIMEOUT_MS = 10000, SEND_TIMEOUT_MS = 30000 };
+    static const size_t DEFAULT_MAX_IN_FLIGHT = 16 * 1024 * 1024;
+
+    JobTransmitter(size_t maxInFlight, HPLFPSDK::IJobPacker::transmissionStatusCallback callback, void* userData);
+    virtual ~JobTransmitter();
+
+    HPLFPSDK::Types::Result connect(const std::string& host, unsigned short port, std::chrono::milliseconds timeout);
+    // Attende l'invio dei dati accodati e chiude la connessione.
+    HPLFPSDK::Types::Result finish();
+
+    virtual void* acquireBuffer(uint32_t numBytes);
+    virtual void releaseBuffer(const uint8_t* buffer, uint32_t numBytes);
+
+    unsigned long long bytesSent() const;
+    // Byte al secondo dal primo invio all'ultimo.
+    double throughput() const;
+    size_t peakInFlight() const;
+
+private:
+    struct Pending
+    {
+        const uint8_t* buffer;
+        uint32_t size;
+    };
+
+    JobTransmitter(const JobTransmitter&);
+    JobTransmitter& operator=(const JobTransmitter&);
+
+    void run();
+    bool sendBatch(const std::vector<Pending>& batch);
+    void failLocked();
+
+    BufferPool& pool_;
+    const size_t maxInFlight_;
+    HPLFPSDK::IJobPacker::transmissionStatusCallback callback_;
+    void* userData_;
+    uintptr_t socket_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable queued_;
+    std::condition_variable space_;
+    std::deque<Pending> queue_;
+    std::vector<std::pair<const uint8_t*, size_t> > acquired_;     // buffer concessi e non ancora rilasciati
+    size_t inFlight_;
+    size_t unsent_;                 // byte rilasciati e non ancora spediti
+    size_t peakInFlight_;
+    unsigned long long sent_;
+    std::chrono::steady_clock::time_point firstSend_;
+    std::chrono::steady_clock::time_point lastSend_;
+    bool closing_;
+    bool failed_;
+    std::thread thread_;
+};
+
+#endif // JOB_TRANSMITTER_H
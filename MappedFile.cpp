@@ -0,0 +1,151 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+    : data_(NULL), size_(0), file_(INVALID_HANDLE_VALUE), mapping_(NULL)
+{
+}
+
+bool MappedFile::open(const string& path, size_t size, bool writable)
+{
+    close();
+    file_ = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                        NULL, writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file_, &length))
+    {
+        close();
+        return false;
+    }
+    size_t mapped = (size_t)length.QuadPart;
+    if (writable && mapped < size)
+    {
+        // CreateFileMapping allunga il file fino alla dimensione della mappa
+        mapped = size;
+    }
+    if (mapped == 0)
+    {
+        close();
+        return false;
+    }
+    mapping_ = CreateFileMappingA(file_, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                  (DWORD)((unsigned long long)mapped >> 32), (DWORD)mapped, NULL);
+    if (mapping_ == NULL)
+    {
+        close();
+        return false;
+    }
+    data_ = (unsigned char*)MapViewOfFile(mapping_, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, mapped);
+    if (data_ == NULL)
+    {
+        close();
+        return false;
+    }
+    size_ = mapped;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_ != NULL)
+    {
+        UnmapViewOfFile(data_);
+        data_ = NULL;
+    }
+    if (mapping_ != NULL)
+    {
+        CloseHandle(mapping_);
+        mapping_ = NULL;
+    }
+    if (file_ != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+    size_ = 0;
+}
+
+#else
+
+MappedFile::MappedFile()
+    : data_(NULL), size_(0), file_(-1)
+{
+}
+
+bool MappedFile::open(const string& path, size_t size, bool writable)
+{
+    close();
+    file_ = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (file_ < 0)
+    {
+        return false;
+    }
+    struct stat status;
+    if (fstat(file_, &status) != 0)
+    {
+        close();
+        return false;
+    }
+    size_t mapped = (size_t)status.st_size;
+    if (writable && mapped < size)
+    {
+        if (ftruncate(file_, (off_t)size) != 0)
+        {
+            close();
+            return false;
+        }
+        mapped = size;
+    }
+    if (mapped == 0)
+    {
+        close();
+        return false;
+    }
+    void* data = mmap(NULL, mapped, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file_, 0);
+    if (data == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    data_ = (unsigned char*)data;
+    size_ = mapped;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_ != NULL)
+    {
+        munmap(data_, size_);
+        data_ = NULL;
+    }
+    if (file_ >= 0)
+    {
+        ::close(file_);
+        file_ = -1;
+    }
+    size_ = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
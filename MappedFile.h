@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+#include <string>
+
+// File mappato in memoria (CreateFileMapping su Windows, mmap altrove).
+// Con writable il file viene creato se non esiste e allungato, con zeri, fino
+// a size; le scritture sulla mappa arrivano al file senza altre chiamate.
+// In sola lettura size e' ignorato e viene mappato l'intero file.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& path, size_t size, bool writable);
+    void close();
+
+    bool isOpen() const { return data_ != NULL; }
+    unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    unsigned char* data_;
+    size_t size_;
+#ifdef _WIN32
+    void* file_;
+    void* mapping_;
+#else
+    int file_;
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,149 @@
+#include "MappedSpoolHandler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+using namespace std;
+
+MappedSpoolHandler::MappedSpoolHandler()
+    : committed_(0), reserved_(0), failed_(false)
+{
+}
+
+MappedSpoolHandler::~MappedSpoolHandler()
+{
+    close();
+}
+
+bool MappedSpoolHandler::open(const string& path)
+{
+    close();
+    error_code error;
+    filesystem::remove(path, error);
+    path_ = path;
+    committed_ = 0;
+    reserved_ = 0;
+    regions_.clear();
+    failed_ = !file_.open(path_, INITIAL_SIZE, true);
+    return !failed_;
+}
+
+bool MappedSpoolHandler::close()
+{
+    if (path_.empty())
+    {
+        return !failed_;
+    }
+    // Un buffer mai rilasciato lascerebbe un buco nel job
+    if (!regions_.empty())
+    {
+        failed_ = true;
+        regions_.clear();
+    }
+    file_.close();
+    // La mappa ha allungato il file con zeri oltre i dati
+    error_code error;
+    filesystem::resize_file(path_, committed_, error);
+    path_.clear();
+    return !failed_ && !error;
+}
+
+void* MappedSpoolHandler::acquireBuffer(uint32_t numBytes)
+{
+    if (failed_ || !file_.isOpen())
+    {
+        failed_ = true;
+        return NULL;
+    }
+    Region region;
+    region.offset = reserved_;
+    region.size = max((size_t)numBytes, (size_t)1);
+    region.length = 0;
+    region.released = false;
+    if (region.offset + region.size > file_.size())
+    {
+        if (regions_.empty())
+        {
+            if (!grow(region.offset + region.size))
+            {
+                failed_ = true;
+                return NULL;
+            }
+        }
+        else
+        {
+            // Gli altri buffer puntano nella mappa: niente rimappatura
+            region.spill.resize(region.size);
+        }
+    }
+    reserved_ += region.size;
+    regions_.push_back(std::move(region));
+    return regionData(regions_.back());
+}
+
+void MappedSpoolHandler::releaseBuffer(const uint8_t* buffer, uint32_t numBytes)
+{
+    deque<Region>::iterator it = regions_.begin();
+    while (it != regions_.end() && (it->released || regionData(*it) != buffer))
+    {
+        ++it;
+    }
+    if (it == regions_.end() || numBytes > it->size)
+    {
+        failed_ = true;
+        return;
+    }
+    it->length = numBytes;
+    it->released = true;
+    if (!commitReleased())
+    {
+        failed_ = true;
+    }
+}
+
+uint8_t* MappedSpoolHandler::regionData(Region& region)
+{
+    return region.spill.empty() ? file_.data() + region.offset : region.spill.data();
+}
+
+bool MappedSpoolHandler::commitReleased()
+{
+    while (!regions_.empty() && regions_.front().released)
+    {
+        Region& region = regions_.front();
+        if (!region.spill.empty())
+        {
+            // I buffer successivi sono tutti fuori dalla mappa: si puo' rimappare
+            if (committed_ + region.length > file_.size() && !grow(committed_ + region.length))
+            {
+                return false;
+            }
+            memcpy(file_.data() + committed_, region.spill.data(), region.length);
+        }
+        else if (region.offset != committed_)
+        {
+            // Un buffer precedente ha scritto meno di quanto aveva riservato
+            memmove(file_.data() + committed_, file_.data() + region.offset, region.length);
+        }
+        committed_ += region.length;
+        regions_.pop_front();
+    }
+    if (regions_.empty())
+    {
+        reserved_ = committed_;
+    }
+    return true;
+}
+
+bool MappedSpoolHandler::grow(size_t required)
+{
+    size_t size = file_.size();
+    while (size < required)
+    {
+        size += min(size, MAX_GROWTH);
+    }
+    // Rimappare e' economico: le pagine gia' scritte restano nella page cache
+    file_.close();
+    return file_.open(path_, size, true);
+}
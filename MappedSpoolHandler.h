@@ -0,0 +1,70 @@
+#ifndef MAPPED_SPOOL_HANDLER_H
+#define MAPPED_SPOOL_HANDLER_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "IJobPacker.h"
+#include "MappedFile.h"
+
+// IMemoryHandler che scrive il job in un file di spool mappato in memoria,
+// senza copie: acquireBuffer restituisce la zona del file subito dopo quella
+// riservata dal buffer precedente, l'SDK ci scrive il job e releaseBuffer
+// sposta solo l'offset. Il costo e' quello delle pagine scritte nella page cache.
+//
+// Piu' buffer possono essere concessi insieme: i dati entrano nel file
+// nell'ordine degli acquireBuffer, quindi un buffer rilasciato prima dei
+// precedenti attende che questi siano rilasciati. Se un buffer rilascia meno
+// byte di quelli riservati, i successivi vengono spostati indietro.
+//
+// La mappa parte da INITIAL_SIZE e raddoppia (al massimo di MAX_GROWTH alla
+// volta) quando una richiesta non ci sta e nessun buffer e' in uso; con
+// buffer in uso la mappa non puo' cambiare indirizzo e il nuovo buffer viene
+// allocato in memoria e copiato nel file al rilascio. close riporta il file
+// alla lunghezza dei dati.
+class MappedSpoolHandler : public HPLFPSDK::IJobPacker::IMemoryHandler
+{
+public:
+    enum { INITIAL_SIZE = 16 * 1024 * 1024 };
+    static const size_t MAX_GROWTH = (size_t)1024 * 1024 * 1024;
+
+    MappedSpoolHandler();
+    virtual ~MappedSpoolHandler();
+
+    // Crea il file, sostituendo quello che c'era.
+    bool open(const std::string& path);
+    // false se un buffer non e' stato concesso o il file non e' stato troncato.
+    bool close();
+
+    virtual void* acquireBuffer(uint32_t numBytes);
+    virtual void releaseBuffer(const uint8_t* buffer, uint32_t numBytes);
+
+    unsigned long long bytesWritten() const { return committed_; }
+
+private:
+    MappedSpoolHandler(const MappedSpoolHandler&);
+    MappedSpoolHandler& operator=(const MappedSpoolHandler&);
+
+    // Buffer concesso e non ancora entrato nel file
+    struct Region
+    {
+        size_t offset;                  // posizione riservata nel file
+        size_t size;                    // byte concessi
+        size_t length;                  // byte scritti, noti al releaseBuffer
+        bool released;
+        std::vector<uint8_t> spill;     // memoria del buffer se non stava nella mappa
+    };
+
+    bool grow(size_t required);
+    uint8_t* regionData(Region& region);
+    bool commitReleased();
+
+    std::string path_;
+    MappedFile file_;
+    size_t committed_;
+    size_t reserved_;           // fine dell'ultimo buffer concesso
+    std::deque<Region> regions_;    // in ordine di acquireBuffer
+    bool failed_;
+};
+
+#endif // MAPPED_SPOOL_HANDLER_H
@@ -0,0 +1,260 @@
+#include "Metrics.h"
+
+#include <cstdio>
+
+using namespace std;
+
+namespace
+{
+    // Limiti dei bucket: in microsecondi per il confronto, in secondi per l'etichetta le
+    const long long BOUNDS_US[] = {
+        10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000,
+        50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000 };
+    const char* const BOUNDS_LABEL[] = {
+        "0.00001", "0.000025", "0.00005", "0.0001", "0.00025", "0.0005", "0.001", "0.0025", "0.005", "0.01", "0.025",
+        "0.05", "0.1", "0.25", "0.5", "1", "2.5", "5", "10", "+Inf" };
+    const int BOUND_COUNT = sizeof(BOUNDS_US) / sizeof(BOUNDS_US[0]);
+
+    struct Family
+    {
+        const char* duration;
+        const char* durationHelp;
+        const char* errors;
+        const char* errorsHelp;
+        const char* label;
+    };
+
+    const Family PHASES = {
+        "hpsdk_phase_duration_seconds", "Durata delle fasi verso l'SDK HP.",
+        "hpsdk_phase_errors_total", "Fasi terminate con un Types::Result diverso da RESULT_OK.",
+        "phase" };
+    const Family APIS = {
+        "hpsdk_api_duration_seconds", "Durata delle chiamate agli export del wrapper.",
+        "hpsdk_api_errors_total", "Export terminati con un Types::Result diverso da RESULT_OK.",
+        "api" };
+
+    struct SeriesInfo
+    {
+        const Family* family;
+        const char* name;
+    };
+
+    // Nello stesso ordine di MetricSeries
+    const SeriesInfo SERIES[METRIC_SERIES_COUNT] = {
+        { &PHASES, "init" },
+        { &PHASES, "device_create" },
+        { &PHASES, "device_discard" },
+        { &PHASES, "ready_wait" },
+        { &PHASES, "status_query" },
+        { &PHASES, "snapshot" },
+        { &PHASES, "terminate" },
+        { &PHASES, "async_request" },
+        { &PHASES, "discovery" },
+        { &PHASES, "warm_up" },
+        { &PHASES, "job_submit" },
+        { &PHASES, "raster_band" },
+        { &PHASES, "transmit" },
+        { &APIS, "GetCartridges" },
+        { &APIS, "GetPrintheads" },
+        { &APIS, "GetMaintanance" },
+        { &APIS, "GetCartridgesEx" },
+        { &APIS, "GetPrintheadsEx" },
+        { &APIS, "GetMaintananceEx" },
+        { &APIS, "GetCartridgesRecords" },
+        { &APIS, "GetPrintheadsRecords" },
+        { &APIS, "GetMaintananceRecords" },
+        { &APIS, "GetConsumablesSnapshot" },
+        { &APIS, "GetConsumablesSnapshotEx" },
+        { &APIS, "PollFleet" },
+        { &APIS, "PollFleetEx" },
+        { &APIS, "GetStatusDelta" },
+        { &APIS, "GetStatusDeltaEx" },
+        { &APIS, "OpenPrinter" },
+        { &APIS, "ClosePrinter" },
+        { &APIS, "CloseSession" },
+        { &APIS, "SubmitRasterJob" },
+        { &APIS, "StreamRasterJob" },
+    };
+
+    struct CounterInfo
+    {
+        const char* name;
+        const char* help;
+    };
+
+    // Nello stesso ordine di MetricCounter
+    const CounterInfo COUNTERS[METRIC_COUNTER_COUNT] = {
+        { "hpsdk_readiness_polls_total", "Interrogazioni di getPrinterStatus durante l'attesa di \"Not initialized\"." },
+        { "hpsdk_readiness_events_total", "Eventi di stampante pronta ricevuti durante l'attesa." },
+        { "hpsdk_status_cache_hits_total", "Viste di stato restituite dalla cache." },
+        { "hpsdk_status_cache_misses_total", "Viste di stato rilette dalla stampante." },
+        { "hpsdk_status_events_total", "Eventi di sottoscrizione ricevuti dalla cache di stato." },
+        { "hpsdk_async_coalesced_total", "Richieste asincrone unite a una lettura gia' in coda o in corso." },
+        { "hpsdk_async_cancelled_total", "Richieste asincrone annullate prima della callback." },
+        { "hpsdk_single_flight_shared_total", "Chiamate concorrenti che hanno ricevuto il risultato di una gia' in corso." },
+        { "hpsdk_breaker_trips_total", "Circuiti aperti dopo errori di connessione consecutivi." },
+        { "hpsdk_breaker_rejected_total", "Richieste respinte senza interrogare la stampante (circuito aperto)." },
+        { "hpsdk_breaker_probes_total", "Richieste di prova verso stampanti con il circuito aperto." },
+        { "hpsdk_raster_bands_total", "Bande raster consegnate ad addRasterData." },
+        { "hpsdk_raster_stalls_total", "Bande per cui l'invio ha atteso la lettura e la conversione." },
+        { "hpsdk_transmit_backpressure_total", "Buffer del job concessi solo dopo l'invio di quelli in volo." },
+    };
+
+    void appendSeconds(string& text, double seconds)
+    {
+        char number[32];
+        snprintf(number, sizeof(number), "%.9f", seconds);
+        text += number;
+    }
+
+    void appendHeader(string& text, const char* name, const char* help, const char* type)
+    {
+        text += "# HELP ";
+        text += name;
+        text += ' ';
+        text += help;
+        text += "\n# TYPE ";
+        text += name;
+        text += ' ';
+        text += type;
+        text += '\n';
+    }
+
+    // name_suffix{label="serie" senza chiusura, per aggiungere altre etichette
+    void appendSeries(string& text, const char* name, const char* suffix, const SeriesInfo& series)
+    {
+        text += name;
+        text += suffix;
+        text += '{';
+        text += series.family->label;
+        text += "=\"";
+        text += series.name;
+        text += '"';
+    }
+}
+
+Metrics& Metrics::instance()
+{
+    // Mai distrutta: gli export possono essere chiamati durante lo scaricamento della libreria
+    static Metrics* metrics = new Metrics();
+    return *metrics;
+}
+
+Metrics::Metrics()
+{
+    for (int series = 0; series < METRIC_SERIES_COUNT; series++)
+    {
+        Histogram& histogram = series_[series];
+        for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+        {
+            histogram.buckets[bucket].store(0, memory_order_relaxed);
+        }
+        histogram.sumNs.store(0, memory_order_relaxed);
+        for (int result = 0; result < RESULT_COUNT; result++)
+        {
+            histogram.errors[result].store(0, memory_order_relaxed);
+        }
+    }
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; counter++)
+    {
+        counters_[counter].store(0, memory_order_relaxed);
+    }
+}
+
+void Metrics::observe(MetricSeries series, chrono::steady_clock::duration duration, HPLFPSDK::Types::Result result)
+{
+    long long ns = (long long)chrono::duration_cast<chrono::nanoseconds>(duration).count();
+    if (ns < 0)
+    {
+        ns = 0;
+    }
+    long long us = ns / 1000;
+    int bucket = 0;
+    while (bucket < BOUND_COUNT && us > BOUNDS_US[bucket])
+    {
+        bucket++;
+    }
+
+    Histogram& histogram = series_[series];
+    histogram.buckets[bucket].fetch_add(1, memory_order_relaxed);
+    histogram.sumNs.fetch_add((unsigned long long)ns, memory_order_relaxed);
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        unsigned int slot = (unsigned int)result;
+        histogram.errors[slot < (unsigned int)RESULT_COUNT ? slot : RESULT_COUNT - 1].fetch_add(1, memory_order_relaxed);
+    }
+}
+
+string Metrics::toPrometheus() const
+{
+    string text;
+    text.reserve(64 * 1024);
+
+    // I valori sono letti senza fermare chi misura: la somma di una serie puo'
+    // differire dai bucket di qualche chiamata in corso. _count e' il bucket +Inf.
+    const Family* families[] = { &PHASES, &APIS };
+    for (int f = 0; f < 2; f++)
+    {
+        const Family& family = *families[f];
+        appendHeader(text, family.duration, family.durationHelp, "histogram");
+        for (int series = 0; series < METRIC_SERIES_COUNT; series++)
+        {
+            if (SERIES[series].family != &family)
+            {
+                continue;
+            }
+            const Histogram& histogram = series_[series];
+            unsigned long long cumulative = 0;
+            for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+            {
+                cumulative += histogram.buckets[bucket].load(memory_order_relaxed);
+                appendSeries(text, family.duration, "_bucket", SERIES[series]);
+                text += ",le=\"";
+                text += BOUNDS_LABEL[bucket];
+                text += "\"} ";
+                text += to_string(cumulative);
+                text += '\n';
+            }
+            appendSeries(text, family.duration, "_sum", SERIES[series]);
+            text += "} ";
+            appendSeconds(text, histogram.sumNs.load(memory_order_relaxed) / 1e9);
+            text += '\n';
+            appendSeries(text, family.duration, "_count", SERIES[series]);
+            text += "} ";
+            text += to_string(cumulative);
+            text += '\n';
+        }
+
+        appendHeader(text, family.errors, family.errorsHelp, "counter");
+        for (int series = 0; series < METRIC_SERIES_COUNT; series++)
+        {
+            if (SERIES[series].family != &family)
+            {
+                continue;
+            }
+            for (int result = 0; result < RESULT_COUNT; result++)
+            {
+                unsigned long long errors = series_[series].errors[result].load(memory_order_relaxed);
+                if (errors != 0)
+                {
+                    appendSeries(text, family.errors, "", SERIES[series]);
+                    text += ",result=\"";
+                    text += to_string(result);
+                    text += "\"} ";
+                    text += to_string(errors);
+                    text += '\n';
+                }
+            }
+        }
+    }
+
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; counter++)
+    {
+        appendHeader(text, COUNTERS[counter].name, COUNTERS[counter].help, "counter");
+        text += COUNTERS[counter].name;
+        text += ' ';
+        text += to_string(counters_[counter].load(memory_order_relaxed));
+        text += '\n';
+    }
+    return text;
+}
@@ -0,0 +1,153 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "IHplfpsdk.h"
+
+// Tempi e contatori del wrapper, letti con l'export GetMetrics in formato
+// testo Prometheus. Ogni misura aggiorna solo contatori atomici (relaxed):
+// nessun lock e nessuna allocazione, anche se nessuno legge le metriche.
+//
+// Le serie con durata sono istogrammi: le fasi verso l'SDK (hplfpsdk_init,
+// hplfpsdk_getNewPrinter, attesa di "Not initialized", interrogazioni di
+// IInfoManager, ...) e gli export. Il _count di ogni istogramma e' il numero
+// di chiamate; quelle non riuscite sono contate anche per Types::Result.
+enum MetricSeries
+{
+    METRIC_PHASE_INIT,                  // hplfpsdk_init
+    METRIC_PHASE_DEVICE_CREATE,         // hplfpsdk_getNewPrinter
+    METRIC_PHASE_DEVICE_DISCARD,        // hplfpsdk_discardPrinter
+    METRIC_PHASE_READY_WAIT,            // waitPrinterReady
+    METRIC_PHASE_STATUS_QUERY,          // get di IInfoManager della cache di stato
+    METRIC_PHASE_SNAPSHOT,              // getConsumablesSnapshot
+    METRIC_PHASE_TERMINATE,             // hplfpsdk_terminate
+    METRIC_PHASE_ASYNC_REQUEST,         // richiesta asincrona, dall'accodamento alle callback
+    METRIC_PHASE_DISCOVERY,             // hplfpsdk_getNetworkPrintersExtended
+    METRIC_PHASE_WARM_UP,               // preparazione di una stampante del WarmPool
+    METRIC_PHASE_JOB_SUBMIT,            // submitRasterJob, da newJob a endJob
+    METRIC_PHASE_RASTER_BAND,           // addRasterData di una banda
+    METRIC_PHASE_TRANSMIT,              // scrittura vettoriale di JobTransmitter
+
+    METRIC_API_GET_CARTRIDGES,
+    METRIC_API_GET_PRINTHEADS,
+    METRIC_API_GET_MAINTANANCE,
+    METRIC_API_GET_CARTRIDGES_EX,
+    METRIC_API_GET_PRINTHEADS_EX,
+    METRIC_API_GET_MAINTANANCE_EX,
+    METRIC_API_GET_CARTRIDGES_RECORDS,
+    METRIC_API_GET_PRINTHEADS_RECORDS,
+    METRIC_API_GET_MAINTANANCE_RECORDS,
+    METRIC_API_GET_CONSUMABLES_SNAPSHOT,
+    METRIC_API_GET_CONSUMABLES_SNAPSHOT_EX,
+    METRIC_API_POLL_FLEET,
+    METRIC_API_POLL_FLEET_EX,
+    METRIC_API_GET_STATUS_DELTA,
+    METRIC_API_GET_STATUS_DELTA_EX,
+    METRIC_API_OPEN_PRINTER,
+    METRIC_API_CLOSE_PRINTER,
+    METRIC_API_CLOSE_SESSION,
+    METRIC_API_SUBMIT_RASTER_JOB,
+    METRIC_API_STREAM_RASTER_JOB,
+
+    METRIC_SERIES_COUNT
+};
+
+// Eventi senza durata.
+enum MetricCounter
+{
+    METRIC_READINESS_POLLS,             // getPrinterStatus eseguite da waitPrinterReady
+    METRIC_READINESS_EVENTS,            // eventi "stampante pronta" ricevuti durante l'attesa
+    METRIC_CACHE_HITS,                  // viste restituite dalla cache senza interrogare
+    METRIC_CACHE_MISSES,                // viste rilette dalla stampante
+    METRIC_STATUS_EVENTS,               // eventi di sottoscrizione ricevuti dalla cache
+    METRIC_ASYNC_COALESCED,             // richieste asincrone unite a una lettura gia' in coda
+    METRIC_ASYNC_CANCELLED,             // richieste asincrone annullate
+    METRIC_SINGLE_FLIGHT_SHARED,        // chiamate che hanno ricevuto il risultato di una gia' in corso
+    METRIC_BREAKER_TRIPS,               // circuiti aperti dopo errori di connessione consecutivi
+    METRIC_BREAKER_REJECTED,            // richieste respinte con il circuito aperto
+    METRIC_BREAKER_PROBES,              // richieste di prova con il circuito half-open
+    METRIC_RASTER_BANDS,                // bande consegnate ad addRasterData
+    METRIC_RASTER_STALLS,               // bande per cui addRasterData ha atteso la lettura
+    METRIC_TRANSMIT_BACKPRESSURE,       // acquireBuffer fermati dal limite di byte in volo
+
+    METRIC_COUNTER_COUNT
+};
+
+class Metrics
+{
+public:
+    static Metrics& instance();
+
+    void observe(MetricSeries series, std::chrono::steady_clock::duration duration, HPLFPSDK::Types::Result result);
+
+    void increment(MetricCounter counter)
+    {
+        counters_[counter].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Tutte le serie in formato di esposizione testuale Prometheus 0.0.4.
+    std::string toPrometheus() const;
+
+private:
+    // Limiti superiori dei bucket in microsecondi, piu' il bucket +Inf
+    static const int BUCKET_COUNT = 20;
+    // Types::Result oltre questo valore sono contati nell'ultimo elemento
+    static const int RESULT_COUNT = 128;
+
+    struct Histogram
+    {
+        std::atomic<unsigned long long> buckets[BUCKET_COUNT];
+        std::atomic<unsigned long long> sumNs;
+        std::atomic<unsigned long long> errors[RESULT_COUNT];
+    };
+
+    Metrics();
+    Metrics(const Metrics&);
+    Metrics& operator=(const Metrics&);
+
+    Histogram series_[METRIC_SERIES_COUNT];
+    std::atomic<unsigned long long> counters_[METRIC_COUNTER_COUNT];
+};
+
+// Misura la durata di una fase o di un export dalla costruzione a stop().
+// Se stop() non viene chiamato (eccezione) la misura vale come RESULT_ERROR.
+class MetricTimer
+{
+public:
+    explicit MetricTimer(MetricSeries series)
+        : series_(series), start_(std::chrono::steady_clock::now()), stopped_(false)
+    {
+    }
+
+    ~MetricTimer()
+    {
+        if (!stopped_)
+        {
+            stop(HPLFPSDK::Types::RESULT_ERROR);
+        }
+    }
+
+    HPLFPSDK::Types::Result stop(HPLFPSDK::Types::Result result)
+    {
+        stopped_ = true;
+        Metrics::instance().observe(series_, std::chrono::steady_clock::now() - start_, result);
+        return result;
+    }
+
+    int stop(int result)
+    {
+        return (int)stop((HPLFPSDK::Types::Result)result);
+    }
+
+private:
+    MetricTimer(const MetricTimer&);
+    MetricTimer& operator=(const MetricTimer&);
+
+    MetricSeries series_;
+    std::chrono::steady_clock::time_point start_;
+    bool stopped_;
+};
+
+#endif // METRICS_H
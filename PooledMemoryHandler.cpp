@@ -0,0 +1,34 @@
+#include "PooledMemoryHandler.h"
+
+PooledMemoryHandler::PooledMemoryHandler()
+    : pool_(BufferPool::instance()), bytesReleased_(0), failed_(false)
+{
+}
+
+PooledMemoryHandler::~PooledMemoryHandler()
+{
+}
+
+void* PooledMemoryHandler::acquireBuffer(uint32_t numBytes)
+{
+    if (failed_)
+    {
+        return NULL;
+    }
+    return pool_.acquire(numBytes > 0 ? numBytes : 1);
+}
+
+void PooledMemoryHandler::releaseBuffer(const uint8_t* buffer, uint32_t numBytes)
+{
+    if (!failed_)
+    {
+        failed_ = !consume(buffer, numBytes);
+        bytesReleased_ += failed_ ? 0 : numBytes;
+    }
+    pool_.release(buffer);
+}
+
+bool PooledMemoryHandler::consume(const uint8_t*, uint32_t)
+{
+    return true;
+}
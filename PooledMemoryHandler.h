@@ -0,0 +1,38 @@
+#ifndef POOLED_MEMORY_HANDLER_H
+#define POOLED_MEMORY_HANDLER_H
+
+#include "BufferPool.h"
+#include "IJobPacker.h"
+
+// IMemoryHandler con i buffer di BufferPool: acquireBuffer prende un buffer
+// della classe adatta, releaseBuffer passa i dati a consume e rimette il buffer
+// nel pool. Senza override consume scarta i dati (prove di conversione e
+// compressione senza stampante). Le sottoclassi decidono dove vanno i dati.
+class PooledMemoryHandler : public HPLFPSDK::IJobPacker::IMemoryHandler
+{
+public:
+    PooledMemoryHandler();
+    virtual ~PooledMemoryHandler();
+
+    virtual void* acquireBuffer(uint32_t numBytes);
+    virtual void releaseBuffer(const uint8_t* buffer, uint32_t numBytes);
+
+    unsigned long long bytesReleased() const { return bytesReleased_; }
+
+protected:
+    // Con false i buffer successivi non vengono piu' concessi e il job
+    // fallisce con RESULT_ERROR_MEMORY.
+    virtual bool consume(const uint8_t* buffer, uint32_t numBytes);
+
+    bool failed() const { return failed_; }
+
+private:
+    PooledMemoryHandler(const PooledMemoryHandler&);
+    PooledMemoryHandler& operator=(const PooledMemoryHandler&);
+
+    BufferPool& pool_;
+    unsigned long long bytesReleased_;
+    bool failed_;
+};
+
+#endif // POOLED_MEMORY_HANDLER_H
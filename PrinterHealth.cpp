@@ -0,0 +1,153 @@
+#include "PrinterHealth.h"
+
+#include <algorithm>
+#include "Metrics.h"
+#include "XmlUtil.h"
+
+using namespace std;
+
+PrinterHealth::Breaker::Breaker()
+    : state(STATE_CLOSED), failures(0), lastResult(HPLFPSDK::Types::RESULT_OK), backoff(0)
+{
+}
+
+PrinterHealth::PrinterHealth()
+    : failureThreshold_(3), baseBackoff_(1000), maxBackoff_(60000), random_(random_device()())
+{
+}
+
+PrinterHealth& PrinterHealth::instance()
+{
+    static PrinterHealth* health = new PrinterHealth();
+    return *health;
+}
+
+bool PrinterHealth::isConnectionFailure(HPLFPSDK::Types::Result result)
+{
+    return result == HPLFPSDK::Types::RESULT_ERROR_CONNECTION || result == HPLFPSDK::Types::RESULT_ERROR_NOT_NETWORK_AVAILABLE;
+}
+
+bool PrinterHealth::allow(const char* ipAddress, HPLFPSDK::Types::Result& result)
+{
+    if (ipAddress == NULL)
+    {
+        return true;
+    }
+    lock_guard<mutex> lock(mutex_);
+    map<string, Breaker, less<> >::iterator it = breakers_.find(ipAddress);
+    if (it == breakers_.end() || it->second.state == STATE_CLOSED)
+    {
+        return true;
+    }
+    Breaker& breaker = it->second;
+    const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (now >= breaker.retryAt)
+    {
+        // Questa richiesta fa da prova; le altre restano respinte finche' non termina.
+        // Se la prova non riporta un esito entro un'altra attesa ne parte una nuova.
+        breaker.state = STATE_HALF_OPEN;
+        breaker.retryAt = now + breaker.backoff;
+        Metrics::instance().increment(METRIC_BREAKER_PROBES);
+        return true;
+    }
+    result = breaker.lastResult;
+    Metrics::instance().increment(METRIC_BREAKER_REJECTED);
+    return false;
+}
+
+void PrinterHealth::record(const char* ipAddress, HPLFPSDK::Types::Result result)
+{
+    if (ipAddress == NULL)
+    {
+        return;
+    }
+    lock_guard<mutex> lock(mutex_);
+    map<string, Breaker, less<> >::iterator it = breakers_.find(ipAddress);
+    if (!isConnectionFailure(result))
+    {
+        if (it != breakers_.end())
+        {
+            breakers_.erase(it);
+        }
+        return;
+    }
+    if (it == breakers_.end())
+    {
+        it = breakers_.insert(make_pair(string(ipAddress), Breaker())).first;
+    }
+    Breaker& breaker = it->second;
+    breaker.failures++;
+    breaker.lastResult = result;
+    if (breaker.state == STATE_HALF_OPEN)
+    {
+        breaker.backoff = min(breaker.backoff * 2, maxBackoff_);
+        openLocked(breaker, chrono::steady_clock::now());
+    }
+    else if (breaker.state == STATE_CLOSED && breaker.failures >= failureThreshold_)
+    {
+        breaker.backoff = baseBackoff_;
+        openLocked(breaker, chrono::steady_clock::now());
+        Metrics::instance().increment(METRIC_BREAKER_TRIPS);
+    }
+}
+
+void PrinterHealth::openLocked(Breaker& breaker, chrono::steady_clock::time_point now)
+{
+    long long backoff = (long long)breaker.backoff.count();
+    uniform_int_distribution<long long> jitter(backoff / 2, max(backoff, 1LL));
+    breaker.state = STATE_OPEN;
+    breaker.retryAt = now + chrono::milliseconds(jitter(random_));
+}
+
+void PrinterHealth::configure(unsigned int failureThreshold, chrono::milliseconds baseBackoff, chrono::milliseconds maxBackoff)
+{
+    lock_guard<mutex> lock(mutex_);
+    failureThreshold_ = max(failureThreshold, 1u);
+    baseBackoff_ = baseBackoff;
+    maxBackoff_ = max(maxBackoff, baseBackoff);
+}
+
+vector<PrinterHealth::Printer> PrinterHealth::printers() const
+{
+    lock_guard<mutex> lock(mutex_);
+    const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    vector<Printer> printers;
+    for (map<string, Breaker, less<> >::const_iterator it = breakers_.begin(); it != breakers_.end(); ++it)
+    {
+        Printer printer;
+        printer.ipAddress = it->first;
+        printer.state = it->second.state;
+        printer.failures = it->second.failures;
+        printer.lastResult = it->second.lastResult;
+        printer.retryIn = chrono::milliseconds(0);
+        if (it->second.state == STATE_OPEN && it->second.retryAt > now)
+        {
+            printer.retryIn = chrono::duration_cast<chrono::milliseconds>(it->second.retryAt - now);
+        }
+        printers.push_back(printer);
+    }
+    return printers;
+}
+
+string PrinterHealth::toXml(const vector<Printer>& printers)
+{
+    static const char* const STATES[] = { "closed", "open", "half-open" };
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<PrinterHealth>\n";
+    for (size_t i = 0; i < printers.size(); i++)
+    {
+        const Printer& printer = printers[i];
+        xml += "<Printer ip=\"";
+        appendXmlEscaped(xml, printer.ipAddress);
+        xml += "\" state=\"";
+        xml += STATES[printer.state];
+        xml += "\" failures=\"";
+        xml += to_string(printer.failures);
+        xml += "\" result=\"";
+        xml += to_string((unsigned int)printer.lastResult);
+        xml += "\" retryInMs=\"";
+        xml += to_string((long long)printer.retryIn.count());
+        xml += "\"/>\n";
+    }
+    xml += "</PrinterHealth>\n";
+    return xml;
+}
@@ -0,0 +1,80 @@
+#ifndef PRINTER_HEALTH_H
+#define PRINTER_HEALTH_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include "IHplfpsdk.h"
+
+// Stato di raggiungibilita' delle stampanti, per indirizzo (circuit breaker).
+// Dopo failureThreshold errori di connessione consecutivi il circuito si apre:
+// le richieste successive ricevono subito l'ultimo errore, senza passare per
+// l'SDK. Allo scadere dell'attesa una sola richiesta di prova (half-open)
+// raggiunge la stampante: se riesce il circuito si chiude, altrimenti si
+// riapre con un'attesa doppia, fino a maxBackoff. Ogni attesa e' scelta a
+// caso tra meta' e il valore pieno, perche' le stampanti spente insieme non
+// vengano riprovate tutte nello stesso momento.
+class PrinterHealth
+{
+public:
+    enum State
+    {
+        STATE_CLOSED,       // stampante raggiungibile, richieste normali
+        STATE_OPEN,         // richieste respinte fino a retryAt
+        STATE_HALF_OPEN     // una richiesta di prova in corso (nuova prova dopo retryAt)
+    };
+
+    struct Printer
+    {
+        std::string ipAddress;
+        State state;
+        unsigned int failures;                  // errori di connessione consecutivi
+        HPLFPSDK::Types::Result lastResult;
+        std::chrono::milliseconds retryIn;      // attesa residua con il circuito aperto
+    };
+
+    static PrinterHealth& instance();
+
+    // false se la richiesta non deve raggiungere la stampante: result riceve l'errore da restituire.
+    bool allow(const char* ipAddress, HPLFPSDK::Types::Result& result);
+    // Esito di una richiesta ammessa da allow.
+    void record(const char* ipAddress, HPLFPSDK::Types::Result result);
+
+    void configure(unsigned int failureThreshold, std::chrono::milliseconds baseBackoff, std::chrono::milliseconds maxBackoff);
+    std::vector<Printer> printers() const;
+
+    static bool isConnectionFailure(HPLFPSDK::Types::Result result);
+    static std::string toXml(const std::vector<Printer>& printers);
+
+private:
+    struct Breaker
+    {
+        Breaker();
+
+        State state;
+        unsigned int failures;
+        HPLFPSDK::Types::Result lastResult;
+        std::chrono::milliseconds backoff;
+        std::chrono::steady_clock::time_point retryAt;
+    };
+
+    PrinterHealth();
+    PrinterHealth(const PrinterHealth&);
+    PrinterHealth& operator=(const PrinterHealth&);
+
+    void openLocked(Breaker& breaker, std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex_;
+    // Solo le stampanti con errori: quelle sane non occupano memoria
+    std::map<std::string, Breaker, std::less<> > breakers_;
+    unsigned int failureThreshold_;
+    std::chrono::milliseconds baseBackoff_;
+    std::chrono::milliseconds maxBackoff_;
+    std::mt19937 random_;
+};
+
+#endif // PRINTER_HEALTH_H
@@ -0,0 +1,154 @@
+#include "PrinterReadiness.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include "CallbackRegistry.h"
+#include "Metrics.h"
+#include "XmlPullParser.h"
+
+using namespace std;
+
+namespace
+{
+    const char NOT_INITIALIZED[] = "Not initialized";
+    const chrono::milliseconds FIRST_POLL_INTERVAL(50);
+    const chrono::milliseconds MAX_POLL_INTERVAL(2000);
+
+    struct ReadyWaiter
+    {
+        ReadyWaiter() : ready(false) {}
+
+        mutex lock;
+        condition_variable changed;
+        bool ready;
+    };
+
+    void onPrinterStatus(HPLFPSDK::IInfoManager::InfoEventType type, void* userData, uint32_t, const char* newXmlValue, int xmlLength)
+    {
+        if (type != HPLFPSDK::IInfoManager::EVENT_PRINTER_STATUS || xmlLength <= 0)
+        {
+            return;
+        }
+        CallbackRegistry::Call call(userData);
+        ReadyWaiter* waiter = (ReadyWaiter*)call.target();
+        if (waiter != NULL && isPrinterStatusReady(newXmlValue, (size_t)xmlLength))
+        {
+            Metrics::instance().increment(METRIC_READINESS_EVENTS);
+            {
+                lock_guard<mutex> lock(waiter->lock);
+                waiter->ready = true;
+            }
+            waiter->changed.notify_all();
+        }
+    }
+
+    // Una singola interrogazione di getPrinterStatus; il buffer viene sempre liberato.
+    HPLFPSDK::Types::Result pollPrinterStatus(HPLFPSDK::IInfoManager* infoManager, bool& ready)
+    {
+        char* info = NULL;
+        size_t longLength = 0;
+        Metrics::instance().increment(METRIC_READINESS_POLLS);
+        HPLFPSDK::Types::Result result = infoManager->getPrinterStatus(&info, longLength);
+        ready = result == HPLFPSDK::Types::RESULT_OK && isPrinterStatusReady(info, longLength);
+        if (info != NULL)
+        {
+            hplfpsdk_deleteBuffer(&info);
+        }
+        if (result == HPLFPSDK::Types::RESULT_ERROR_NOT_YET_INITIALIZED)
+        {
+            return HPLFPSDK::Types::RESULT_OK;
+        }
+        return result;
+    }
+}
+
+bool isPrinterStatusReady(const char* printerStatus, size_t length)
+{
+    if (printerStatus == NULL || length == 0)
+    {
+        return false;
+    }
+    // "Not initialized" puo' comparire in qualunque testo del documento
+    XmlPullParser parser(printerStatus, length);
+    for (;;)
+    {
+        switch (parser.next())
+        {
+        case XmlPullParser::EVENT_TEXT:
+            if (parser.text().find(NOT_INITIALIZED) != string_view::npos)
+            {
+                return false;
+            }
+            break;
+        case XmlPullParser::EVENT_END_DOCUMENT:
+            return true;
+        case XmlPullParser::EVENT_ERROR:
+            // Documento non valido: ricerca sul testo grezzo come in origine
+            return string_view(printerStatus, length).find(NOT_INITIALIZED) == string_view::npos;
+        default:
+            break;
+        }
+    }
+}
+
+HPLFPSDK::Types::Result waitPrinterReady(HPLFPSDK::IInfoManager* infoManager,
+                                         chrono::milliseconds timeout,
+                                         chrono::milliseconds* elapsed)
+{
+    MetricTimer timer(METRIC_PHASE_READY_WAIT);
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    const chrono::steady_clock::time_point deadline = start + timeout;
+
+    bool ready = false;
+    HPLFPSDK::Types::Result result = pollPrinterStatus(infoManager, ready);
+
+    // L'SDK riceve un token: un evento consegnato dopo l'uscita non trova il waiter
+    ReadyWaiter waiter;
+    CallbackRegistry& registry = CallbackRegistry::instance();
+    void* token = NULL;
+    uint32_t subscriptionId = 0;
+    bool subscribed = false;
+    if (result == HPLFPSDK::Types::RESULT_OK && !ready)
+    {
+        token = registry.add(&waiter);
+        subscribed = infoManager->subscribeToPrinterStatus(&onPrinterStatus, token, &subscriptionId) == HPLFPSDK::Types::RESULT_OK;
+    }
+
+    chrono::milliseconds interval = FIRST_POLL_INTERVAL;
+    while (result == HPLFPSDK::Types::RESULT_OK && !ready)
+    {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            result = HPLFPSDK::Types::RESULT_ERROR_TIMEOUT;
+            break;
+        }
+        {
+            unique_lock<mutex> lock(waiter.lock);
+            waiter.changed.wait_until(lock, min(deadline, now + interval), [&waiter] { return waiter.ready; });
+            ready = waiter.ready;
+        }
+        if (!ready)
+        {
+            // Nessun evento ricevuto: si controlla comunque lo stato, sempre piu' di rado
+            result = pollPrinterStatus(infoManager, ready);
+            interval = min(interval * 2, MAX_POLL_INTERVAL);
+        }
+    }
+
+    if (subscribed)
+    {
+        infoManager->unsubscribe(subscriptionId);
+    }
+    if (token != NULL)
+    {
+        // Attende le callback ancora in corso su waiter
+        registry.remove(token);
+    }
+    if (elapsed != NULL)
+    {
+        *elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    }
+    return timer.stop(result);
+}
@@ -0,0 +1,22 @@
+#ifndef PRINTER_READINESS_H
+#define PRINTER_READINESS_H
+
+#include <chrono>
+#include "IHplfpsdk.h"
+
+// Attende che getPrinterStatus non riporti piu' "Not initialized".
+// Usa subscribeToPrinterStatus e una condition variable; se la stampante non
+// invia eventi (o la sottoscrizione non e' supportata) interroga lo stato con
+// backoff esponenziale, senza mai occupare la CPU durante l'attesa.
+// @param[in] timeout tempo massimo di attesa
+// @param[out] elapsed se non NULL, tempo impiegato dalla stampante per diventare pronta
+// @return RESULT_OK se pronta, RESULT_ERROR_TIMEOUT se scade il timeout,
+//         altrimenti l'errore restituito da getPrinterStatus.
+HPLFPSDK::Types::Result waitPrinterReady(HPLFPSDK::IInfoManager* infoManager,
+                                         std::chrono::milliseconds timeout,
+                                         std::chrono::milliseconds* elapsed);
+
+// true se il documento XML di getPrinterStatus indica che la stampante e' inizializzata.
+bool isPrinterStatusReady(const char* printerStatus, size_t length);
+
+#endif // PRINTER_READINESS_H
@@ -0,0 +1,504 @@
+#include "PrinterSession.h"
+
+#include <algorithm>
+#include "Metrics.h"
+#include "PrinterReadiness.h"
+#include "SingleFlight.h"
+
+using namespace std;
+
+struct PrinterSession::Entry
+{
+    Entry(const char* ip, const char* model)
+        : ipAddress(ip != NULL ? ip : ""), printerModel(model != NULL ? model : ""), device(NULL), ready(false), readyAfter(0), refCount(0), openCount(0), closing(false)
+    {
+    }
+
+    string ipAddress;
+    string printerModel;
+    mutex createMutex;                       // serializza hplfpsdk_getNewPrinter e protegge ready e readyAfter
+    SingleFlight createFlight;               // chi arriva durante la creazione ne riceve il risultato
+    SingleFlight readyFlight;                // idem per l'attesa di prontezza
+    HPLFPSDK::IDevice* device;
+    bool ready;
+    chrono::milliseconds readyAfter;
+    unique_ptr<StatusCache> statusCache;
+    unique_ptr<DeltaEngine> deltaEngine;
+    // I campi seguenti sono protetti da PrinterSession::mutex_
+    int refCount;
+    int openCount;
+    bool closing;
+    chrono::steady_clock::time_point lastUsed;
+};
+
+PrinterSession::Lease::Lease()
+{
+}
+
+PrinterSession::Lease::Lease(const shared_ptr<Entry>& entry)
+    : entry_(entry)
+{
+}
+
+PrinterSession::Lease::Lease(Lease&& other)
+    : entry_(std::move(other.entry_))
+{
+}
+
+PrinterSession::Lease& PrinterSession::Lease::operator=(Lease&& other)
+{
+    if (this != &other)
+    {
+        release();
+        entry_ = std::move(other.entry_);
+    }
+    return *this;
+}
+
+PrinterSession::Lease::~Lease()
+{
+    release();
+}
+
+HPLFPSDK::IDevice* PrinterSession::Lease::device() const
+{
+    return entry_ ? entry_->device : NULL;
+}
+
+bool PrinterSession::Lease::valid() const
+{
+    return device() != NULL;
+}
+
+void PrinterSession::Lease::release()
+{
+    if (entry_)
+    {
+        PrinterSession::instance().release(entry_);
+        entry_.reset();
+    }
+}
+
+PrinterSession& PrinterSession::instance()
+{
+    static PrinterSession* session = new PrinterSession();
+    return *session;
+}
+
+PrinterSession::PrinterSession()
+    : initialized_(false), users_(0), idleTimeout_(60), readyTimeout_(120000), sweepGeneration_(0), discarding_(0)
+{
+}
+
+HPLFPSDK::Types::Result PrinterSession::init()
+{
+    lock_guard<mutex> lock(mutex_);
+    return initLocked();
+}
+
+HPLFPSDK::Types::Result PrinterSession::beginUse()
+{
+    lock_guard<mutex> lock(mutex_);
+    HPLFPSDK::Types::Result result = initLocked();
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        users_++;
+    }
+    return result;
+}
+
+void PrinterSession::endUse()
+{
+    lock_guard<mutex> lock(mutex_);
+    users_--;
+}
+
+HPLFPSDK::Types::Result PrinterSession::initLocked()
+{
+    if (initialized_)
+    {
+        return HPLFPSDK::Types::RESULT_OK;
+    }
+    hplfpsdk_setLogLevel(HPLFPSDK::Types::LOG_LEVEL_NONE);
+    MetricTimer timer(METRIC_PHASE_INIT);
+    HPLFPSDK::Types::Result result = timer.stop(hplfpsdk_init());
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        cout << "Libreria inizializzata correttamente!" << "\n";
+        initialized_ = true;
+        sweeper_ = thread(&PrinterSession::sweep, this, sweepGeneration_);
+    }
+    return result;
+}
+
+HPLFPSDK::Types::Result PrinterSession::acquire(const char* ipAddress, const char* printerModel, Lease& lease)
+{
+    shared_ptr<Entry> entry;
+    vector<shared_ptr<Entry> > discarded;
+    {
+        lock_guard<mutex> lock(mutex_);
+        HPLFPSDK::Types::Result result = initLocked();
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return result;
+        }
+        evictIdleLocked(chrono::steady_clock::now(), discarded);
+        shared_ptr<Entry>& slot = printers_[makeKey(ipAddress, printerModel)];
+        if (!slot)
+        {
+            slot = make_shared<Entry>(ipAddress, printerModel);
+        }
+        entry = slot;
+        entry->refCount++;
+    }
+    discard(discarded);
+
+    // Da qui in poi il riferimento viene rilasciato anche in caso di errore
+    Lease candidate(entry);
+    // Con una stampante irraggiungibile le richieste concorrenti ricevono tutte
+    // l'errore della stessa hplfpsdk_getNewPrinter, invece di ripeterla una alla volta
+    Entry& created = *entry;
+    HPLFPSDK::Types::Result result = created.createFlight.run([&created]()
+    {
+        lock_guard<mutex> createLock(created.createMutex);
+        if (created.device != NULL)
+        {
+            return HPLFPSDK::Types::RESULT_OK;
+        }
+        HPLFPSDK::IDevice* printer = NULL;
+        MetricTimer timer(METRIC_PHASE_DEVICE_CREATE);
+        HPLFPSDK::Types::Result resultPrinter = timer.stop(hplfpsdk_getNewPrinter(created.ipAddress.c_str(), created.printerModel.c_str(), printer));
+        if (resultPrinter != HPLFPSDK::Types::RESULT_OK)
+        {
+            if (printer != NULL)
+            {
+                hplfpsdk_discardPrinter(printer);
+            }
+            return resultPrinter;
+        }
+        created.device = printer;
+        return HPLFPSDK::Types::RESULT_OK;
+    });
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    lease = std::move(candidate);
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result PrinterSession::waitReady(Lease& lease, chrono::milliseconds* readyAfter)
+{
+    return waitReady(lease, readyTimeout(), readyAfter);
+}
+
+HPLFPSDK::Types::Result PrinterSession::waitReady(Lease& lease, chrono::milliseconds timeout, chrono::milliseconds* readyAfter)
+{
+    if (!lease.valid())
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    Entry& entry = *lease.entry_;
+    {
+        lock_guard<mutex> createLock(entry.createMutex);
+        if (entry.ready)
+        {
+            if (readyAfter != NULL)
+            {
+                *readyAfter = entry.readyAfter;
+            }
+            return HPLFPSDK::Types::RESULT_OK;
+        }
+    }
+    // Chi arriva durante l'attesa ne riceve il risultato senza ricominciarla,
+    // ma non aspetta oltre il proprio timeout. L'attesa avviene fuori da
+    // createMutex, cosi' statusCache e invalidateReady non restano bloccati.
+    // Il RESULT_ERROR_TIMEOUT di chi guidava l'attesa con un timeout piu' breve
+    // non vale per gli altri: finche' hanno tempo ripartono con una nuova attesa.
+    const chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + timeout;
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_ERROR_TIMEOUT;
+    do
+    {
+        result = entry.readyFlight.runUntil([&entry, deadline]()
+        {
+            {
+                lock_guard<mutex> createLock(entry.createMutex);
+                if (entry.ready)
+                {
+                    return HPLFPSDK::Types::RESULT_OK;
+                }
+            }
+            chrono::milliseconds left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+            chrono::milliseconds waitedFor(0);
+            HPLFPSDK::Types::Result waited = waitPrinterReady(entry.device->getInfoManager(), max(left, chrono::milliseconds(0)), &waitedFor);
+            lock_guard<mutex> createLock(entry.createMutex);
+            entry.readyAfter = waitedFor;
+            entry.ready = waited == HPLFPSDK::Types::RESULT_OK;
+            return waited;
+        }, deadline);
+    }
+    while (result == HPLFPSDK::Types::RESULT_ERROR_TIMEOUT && chrono::steady_clock::now() < deadline);
+    if (readyAfter != NULL)
+    {
+        lock_guard<mutex> createLock(entry.createMutex);
+        *readyAfter = entry.readyAfter;
+    }
+    return result;
+}
+
+void PrinterSession::invalidateReady(Lease& lease)
+{
+    if (lease.entry_)
+    {
+        lock_guard<mutex> createLock(lease.entry_->createMutex);
+        lease.entry_->ready = false;
+    }
+}
+
+StatusCache& PrinterSession::statusCache(Lease& lease)
+{
+    Entry& entry = *lease.entry_;
+    lock_guard<mutex> createLock(entry.createMutex);
+    if (!entry.statusCache)
+    {
+        entry.statusCache.reset(new StatusCache(entry.device->getInfoManager(), entry.ipAddress));
+    }
+    return *entry.statusCache;
+}
+
+DeltaEngine& PrinterSession::deltaEngine(Lease& lease)
+{
+    Entry& entry = *lease.entry_;
+    lock_guard<mutex> createLock(entry.createMutex);
+    if (!entry.deltaEngine)
+    {
+        entry.deltaEngine.reset(new DeltaEngine());
+    }
+    return *entry.deltaEngine;
+}
+
+HPLFPSDK::Types::Result PrinterSession::open(const char* ipAddress, const char* printerModel)
+{
+    Lease lease;
+    HPLFPSDK::Types::Result result = acquire(ipAddress, printerModel, lease);
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        lock_guard<mutex> lock(mutex_);
+        lease.entry_->openCount++;
+        lease.entry_->closing = false;
+    }
+    return result;
+}
+
+HPLFPSDK::Types::Result PrinterSession::close(const char* ipAddress, const char* printerModel)
+{
+    vector<shared_ptr<Entry> > discarded;
+    {
+        lock_guard<mutex> lock(mutex_);
+        map<string, shared_ptr<Entry> >::iterator it = printers_.find(makeKey(ipAddress, printerModel));
+        if (it == printers_.end() || it->second->openCount == 0)
+        {
+            return HPLFPSDK::Types::RESULT_ERROR_ELEMENT_NOT_FOUND;
+        }
+        shared_ptr<Entry> entry = it->second;
+        if (--entry->openCount == 0)
+        {
+            if (entry->refCount == 0)
+            {
+                detachLocked(it, discarded);
+            }
+            else
+            {
+                // Scartato dall'ultimo Lease ancora attivo
+                entry->closing = true;
+            }
+        }
+    }
+    discard(discarded);
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result PrinterSession::terminate()
+{
+    thread sweeper;
+    vector<shared_ptr<Entry> > discarded;
+    // I device vengono scartati fuori dal lock; se intanto ne e' stato creato
+    // un altro si ricontrolla, e la libreria termina solo con la tabella vuota
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lock(mutex_);
+            discarded_.wait(lock, [this] { return discarding_ == 0; });
+            if (users_ > 0)
+            {
+                return HPLFPSDK::Types::RESULT_ERROR_PRINTER_BUSY;
+            }
+            for (map<string, shared_ptr<Entry> >::iterator it = printers_.begin(); it != printers_.end(); ++it)
+            {
+                if (it->second->refCount > 0)
+                {
+                    return HPLFPSDK::Types::RESULT_ERROR_PRINTER_BUSY;
+                }
+            }
+            if (printers_.empty())
+            {
+                if (initialized_)
+                {
+                    MetricTimer timer(METRIC_PHASE_TERMINATE);
+                    hplfpsdk_terminate();
+                    timer.stop(HPLFPSDK::Types::RESULT_OK);
+                    initialized_ = false;
+                }
+                sweepGeneration_++;
+                sweeper.swap(sweeper_);
+                break;
+            }
+            map<string, shared_ptr<Entry> >::iterator it = printers_.begin();
+            while (it != printers_.end())
+            {
+                it = detachLocked(it, discarded);
+            }
+        }
+        discard(discarded);
+        discarded.clear();
+    }
+    // Il thread di pulizia prende mutex_: si attende fuori dal lock
+    sweep_.notify_all();
+    if (sweeper.joinable())
+    {
+        sweeper.join();
+    }
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+void PrinterSession::evictIdle()
+{
+    vector<shared_ptr<Entry> > discarded;
+    {
+        lock_guard<mutex> lock(mutex_);
+        evictIdleLocked(chrono::steady_clock::now(), discarded);
+    }
+    discard(discarded);
+}
+
+void PrinterSession::setIdleTimeout(chrono::seconds timeout)
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        idleTimeout_ = timeout;
+    }
+    sweep_.notify_all();
+}
+
+void PrinterSession::setReadyTimeout(chrono::milliseconds timeout)
+{
+    lock_guard<mutex> lock(mutex_);
+    readyTimeout_ = timeout;
+}
+
+chrono::milliseconds PrinterSession::readyTimeout()
+{
+    lock_guard<mutex> lock(mutex_);
+    return readyTimeout_;
+}
+
+void PrinterSession::evictIdleLocked(chrono::steady_clock::time_point now, vector<shared_ptr<Entry> >& discarded)
+{
+    map<string, shared_ptr<Entry> >::iterator it = printers_.begin();
+    while (it != printers_.end())
+    {
+        const shared_ptr<Entry>& entry = it->second;
+        bool unused = entry->refCount == 0 && entry->openCount == 0;
+        if (unused && (entry->device == NULL || now - entry->lastUsed >= idleTimeout_))
+        {
+            it = detachLocked(it, discarded);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void PrinterSession::sweep(unsigned long long generation)
+{
+    unique_lock<mutex> lock(mutex_);
+    while (sweepGeneration_ == generation)
+    {
+        // Controllo ogni meta' idleTimeout, ma non piu' di una volta al secondo
+        chrono::milliseconds period = max(chrono::milliseconds(1000), chrono::duration_cast<chrono::milliseconds>(idleTimeout_) / 2);
+        chrono::seconds timeout = idleTimeout_;
+        sweep_.wait_for(lock, period, [this, generation, timeout]
+        {
+            return sweepGeneration_ != generation || idleTimeout_ != timeout;
+        });
+        if (sweepGeneration_ == generation)
+        {
+            vector<shared_ptr<Entry> > discarded;
+            evictIdleLocked(chrono::steady_clock::now(), discarded);
+            // Le cache attendono le callback in corso: acquire non deve aspettarle
+            lock.unlock();
+            discard(discarded);
+            lock.lock();
+        }
+    }
+}
+
+map<string, shared_ptr<PrinterSession::Entry> >::iterator PrinterSession::detachLocked(map<string, shared_ptr<Entry> >::iterator it, vector<shared_ptr<Entry> >& discarded)
+{
+    discarded.push_back(it->second);
+    discarding_++;
+    return printers_.erase(it);
+}
+
+void PrinterSession::discard(const vector<shared_ptr<Entry> >& entries)
+{
+    if (entries.empty())
+    {
+        return;
+    }
+    // Le voci sono gia' fuori dalla tabella e senza riferimenti: nessun altro le usa
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        Entry& entry = *entries[i];
+        entry.statusCache.reset();
+        entry.deltaEngine.reset();
+        if (entry.device != NULL)
+        {
+            MetricTimer timer(METRIC_PHASE_DEVICE_DISCARD);
+            timer.stop(hplfpsdk_discardPrinter(entry.device));
+            entry.device = NULL;
+        }
+    }
+    {
+        lock_guard<mutex> lock(mutex_);
+        discarding_ -= (int)entries.size();
+    }
+    discarded_.notify_all();
+}
+
+void PrinterSession::release(const shared_ptr<Entry>& entry)
+{
+    vector<shared_ptr<Entry> > discarded;
+    {
+        lock_guard<mutex> lock(mutex_);
+        entry->lastUsed = chrono::steady_clock::now();
+        if (--entry->refCount == 0 && entry->closing && entry->openCount == 0)
+        {
+            map<string, shared_ptr<Entry> >::iterator it = printers_.find(makeKey(entry->ipAddress.c_str(), entry->printerModel.c_str()));
+            if (it != printers_.end() && it->second == entry)
+            {
+                detachLocked(it, discarded);
+            }
+        }
+    }
+    discard(discarded);
+}
+
+string PrinterSession::makeKey(const char* ipAddress, const char* printerModel)
+{
+    string key(ipAddress != NULL ? ipAddress : "");
+    key += '|';
+    key += printerModel != NULL ? printerModel : "";
+    return key;
+}
@@ -0,0 +1,117 @@
+#ifndef PRINTER_SESSION_H
+#define PRINTER_SESSION_H
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "IHplfpsdk.h"
+#include "DeltaEngine.h"
+#include "StatusCache.h"
+
+// Sessione SDK condivisa da tutto il processo.
+// La libreria viene inizializzata una sola volta e gli IDevice restano vivi
+// tra una chiamata e l'altra, indicizzati per IP + modello.
+// Ogni IDevice ha un contatore di riferimenti: quando nessuno lo usa piu' e
+// non e' stato aperto esplicitamente viene scartato dopo idleTimeout, da un
+// thread interno avviato con la libreria e fermato da terminate.
+class PrinterSession
+{
+public:
+    struct Entry;
+
+    // Riferimento a un IDevice della tabella, rilasciato all'uscita dallo scope.
+    class Lease
+    {
+    public:
+        Lease();
+        Lease(Lease&& other);
+        Lease& operator=(Lease&& other);
+        ~Lease();
+
+        HPLFPSDK::IDevice* device() const;
+        bool valid() const;
+        void release();
+
+    private:
+        friend class PrinterSession;
+        explicit Lease(const std::shared_ptr<Entry>& entry);
+        Lease(const Lease&);
+        Lease& operator=(const Lease&);
+
+        std::shared_ptr<Entry> entry_;
+    };
+
+    // Come FleetPoller non viene mai distrutta: il thread di pulizia puo'
+    // essere ancora attivo all'uscita del processo.
+    static PrinterSession& instance();
+
+    // Inizializza la libreria se non e' gia' stato fatto.
+    HPLFPSDK::Types::Result init();
+    // Come init, per chi usa la libreria senza un device (ricerca in rete):
+    // fino a endUse terminate restituisce RESULT_ERROR_PRINTER_BUSY.
+    HPLFPSDK::Types::Result beginUse();
+    void endUse();
+
+    // Restituisce l'IDevice per (ipAddress, printerModel), creandolo se serve.
+    HPLFPSDK::Types::Result acquire(const char* ipAddress, const char* printerModel, Lease& lease);
+
+    // Attende che il device sia pronto (vedi waitPrinterReady). L'attesa viene
+    // fatta una sola volta per device; readyAfter riporta quanto e' durata.
+    HPLFPSDK::Types::Result waitReady(Lease& lease, std::chrono::milliseconds* readyAfter = NULL);
+    HPLFPSDK::Types::Result waitReady(Lease& lease, std::chrono::milliseconds timeout, std::chrono::milliseconds* readyAfter);
+    // Da chiamare quando il device torna a rispondere RESULT_ERROR_NOT_YET_INITIALIZED.
+    void invalidateReady(Lease& lease);
+
+    // Cache dello stato del device, creata al primo utilizzo e distrutta con il device.
+    StatusCache& statusCache(Lease& lease);
+    // Differenze tra le letture di stato del device, con la stessa durata della cache.
+    DeltaEngine& deltaEngine(Lease& lease);
+
+    // OpenPrinter/ClosePrinter: il device resta in tabella finche' non viene chiuso.
+    HPLFPSDK::Types::Result open(const char* ipAddress, const char* printerModel);
+    HPLFPSDK::Types::Result close(const char* ipAddress, const char* printerModel);
+
+    // Scarta tutti i device e termina la libreria.
+    // Restituisce RESULT_ERROR_PRINTER_BUSY se qualche device o beginUse e' ancora in uso.
+    HPLFPSDK::Types::Result terminate();
+
+    // Scarta subito i device inutilizzati da piu' di idleTimeout.
+    void evictIdle();
+    void setIdleTimeout(std::chrono::seconds timeout);
+    void setReadyTimeout(std::chrono::milliseconds timeout);
+    std::chrono::milliseconds readyTimeout();
+
+private:
+    PrinterSession();
+    PrinterSession(const PrinterSession&);
+    PrinterSession& operator=(const PrinterSession&);
+
+    HPLFPSDK::Types::Result initLocked();
+    // I device da scartare vengono tolti dalla tabella sotto mutex_ e passati a
+    // discard, che chiama l'SDK e distrugge le cache fuori dal lock
+    void evictIdleLocked(std::chrono::steady_clock::time_point now, std::vector<std::shared_ptr<Entry> >& discarded);
+    std::map<std::string, std::shared_ptr<Entry> >::iterator detachLocked(std::map<std::string, std::shared_ptr<Entry> >::iterator it, std::vector<std::shared_ptr<Entry> >& discarded);
+    void discard(const std::vector<std::shared_ptr<Entry> >& entries);
+    void sweep(unsigned long long generation);
+    void release(const std::shared_ptr<Entry>& entry);
+    static std::string makeKey(const char* ipAddress, const char* printerModel);
+
+    std::mutex mutex_;
+    bool initialized_;
+    int users_;                              // beginUse senza endUse
+    std::chrono::seconds idleTimeout_;
+    std::chrono::milliseconds readyTimeout_;
+    std::map<std::string, std::shared_ptr<Entry> > printers_;
+    std::thread sweeper_;
+    std::condition_variable sweep_;
+    int discarding_;                         // device tolti dalla tabella e non ancora scartati
+    std::condition_variable discarded_;      // terminate li attende prima di hplfpsdk_terminate
+    unsigned long long sweepGeneration_;     // cambia a ogni terminate: il thread in corso si ferma
+};
+
+#endif // PRINTER_SESSION_H
@@ -0,0 +1,69 @@
+#include "PrinterStatus.h"
+#include "PrinterHealth.h"
+#include "PrinterSession.h"
+
+using namespace std;
+
+namespace
+{
+    HPLFPSDK::Types::Result readFromSession(const char* ipAddress, const char* printerModel, StatusKind kind,
+                                            chrono::milliseconds readyTimeout,
+                                            shared_ptr<const string>& xml,
+                                            unsigned long long since, StatusDelta* delta)
+    {
+        PrinterSession& session = PrinterSession::instance();
+        PrinterSession::Lease printer;
+        HPLFPSDK::Types::Result result = session.acquire(ipAddress, printerModel, printer);
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return result;
+        }
+        result = session.waitReady(printer, readyTimeout, NULL);
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return result;
+        }
+        result = session.statusCache(printer).get(kind, xml);
+        if (result == HPLFPSDK::Types::RESULT_ERROR_NOT_YET_INITIALIZED)
+        {
+            session.invalidateReady(printer);
+        }
+        else if (result == HPLFPSDK::Types::RESULT_OK && delta != NULL)
+        {
+            session.deltaEngine(printer).update(kind, xml, since, *delta);
+        }
+        return result;
+    }
+
+    HPLFPSDK::Types::Result readWithHealth(const char* ipAddress, const char* printerModel, StatusKind kind,
+                                           chrono::milliseconds readyTimeout,
+                                           shared_ptr<const string>& xml,
+                                           unsigned long long since, StatusDelta* delta)
+    {
+        // Stampante spenta: risposta immediata finche' il circuito e' aperto
+        PrinterHealth& health = PrinterHealth::instance();
+        HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_OK;
+        if (!health.allow(ipAddress, result))
+        {
+            return result;
+        }
+        result = readFromSession(ipAddress, printerModel, kind, readyTimeout, xml, since, delta);
+        health.record(ipAddress, result);
+        return result;
+    }
+}
+
+HPLFPSDK::Types::Result readPrinterStatus(const char* ipAddress, const char* printerModel, StatusKind kind,
+                                          chrono::milliseconds readyTimeout,
+                                          shared_ptr<const string>& xml)
+{
+    return readWithHealth(ipAddress, printerModel, kind, readyTimeout, xml, 0, NULL);
+}
+
+HPLFPSDK::Types::Result readPrinterStatusDelta(const char* ipAddress, const char* printerModel, StatusKind kind,
+                                               chrono::milliseconds readyTimeout,
+                                               unsigned long long since, StatusDelta& delta)
+{
+    shared_ptr<const string> xml;
+    return readWithHealth(ipAddress, printerModel, kind, readyTimeout, xml, since, &delta);
+}
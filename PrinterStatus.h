@@ -0,0 +1,25 @@
+#ifndef PRINTER_STATUS_H
+#define PRINTER_STATUS_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include "IHplfpsdk.h"
+#include "DeltaEngine.h"
+#include "StatusQueries.h"
+
+// Legge una vista di stato di una stampante passando per la sessione
+// (IDevice condiviso), l'attesa di prontezza e la cache di stato.
+// Con il circuito della stampante aperto (vedi PrinterHealth) restituisce
+// subito l'ultimo errore di connessione.
+HPLFPSDK::Types::Result readPrinterStatus(const char* ipAddress, const char* printerModel, StatusKind kind,
+                                          std::chrono::milliseconds readyTimeout,
+                                          std::shared_ptr<const std::string>& xml);
+
+// Come readPrinterStatus, ma riporta le modifiche della vista dopo la sequenza
+// since secondo il DeltaEngine del device.
+HPLFPSDK::Types::Result readPrinterStatusDelta(const char* ipAddress, const char* printerModel, StatusKind kind,
+                                               std::chrono::milliseconds readyTimeout,
+                                               unsigned long long since, StatusDelta& delta);
+
+#endif // PRINTER_STATUS_H
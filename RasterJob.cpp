@@ -0,0 +1,306 @@
+#include "RasterJob.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Metrics.h"
+
+using namespace std;
+
+namespace
+{
+    const size_t PIPELINE_DEPTH = 3;
+    const size_t BAND_BYTES = 4 * 1024 * 1024;
+
+    struct Band
+    {
+        vector<uint8_t> data;       // rows righe da bytesPerLine byte per piano, gia' nel formato della rasterConfig
+        uint32_t startRow;
+        uint32_t rows;
+    };
+
+    // Bande tra il thread che legge e converte l'immagine e quello che le
+    // consegna all'SDK. Le bande girano tra free_ e ready_: dopo la prima
+    // lettura non ci sono altre allocazioni.
+    class BandPipeline
+    {
+    public:
+        BandPipeline(RasterSource& source, RasterLayout layout, uint32_t bytesPerLine, uint32_t bandRows)
+            : source_(source), layout_(layout), bytesPerLine_(bytesPerLine), bandRows_(bandRows),
+              stopping_(false), failed_(false)
+        {
+            for (size_t i = 0; i < PIPELINE_DEPTH; i++)
+            {
+                bands_[i].data.resize((size_t)bytesPerLine * bandRows * rasterPlanes(layout));
+                free_.push_back(&bands_[i]);
+            }
+            thread_ = thread(&BandPipeline::produce, this);
+        }
+
+        ~BandPipeline()
+        {
+            {
+                lock_guard<mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            freed_.notify_all();
+            thread_.join();
+        }
+
+        // Inizio del piano plane di band: i piani stanno uno dopo l'altro.
+        uint8_t* plane(Band* band, size_t plane) const
+        {
+            return band->data.data() + plane * bytesPerLine_ * bandRows_;
+        }
+
+        // Prossima banda in ordine; NULL se la lettura non e' riuscita.
+        // stalled indica se e' stato necessario attenderla.
+        Band* next(bool& stalled)
+        {
+            unique_lock<mutex> lock(mutex_);
+            stalled = ready_.empty() && !failed_;
+            readied_.wait(lock, [this] { return !ready_.empty() || failed_; });
+            if (ready_.empty())
+            {
+                return NULL;
+            }
+            Band* band = ready_.front();
+            ready_.pop_front();
+            return band;
+        }
+
+        void recycle(Band* band)
+        {
+            {
+                lock_guard<mutex> lock(mutex_);
+                free_.push_back(band);
+            }
+            freed_.notify_one();
+        }
+
+    private:
+        BandPipeline(const BandPipeline&);
+        BandPipeline& operator=(const BandPipeline&);
+
+        void produce()
+        {
+            bool ok = true;
+            try
+            {
+                const uint32_t width = source_.width();
+                const uint32_t height = source_.height();
+                const size_t sourceStride = (size_t)width * sourceBytesPerPixel(source_.format());
+                vector<uint8_t> pixels(sourceStride * bandRows_);
+                for (uint32_t startRow = 0; startRow < height && ok; startRow += bandRows_)
+                {
+                    Band* band = NULL;
+                    {
+                        unique_lock<mutex> lock(mutex_);
+                        freed_.wait(lock, [this] { return !free_.empty() || stopping_; });
+                        if (stopping_)
+                        {
+                            return;
+                        }
+                        band = free_.front();
+                        free_.pop_front();
+                    }
+                    band->startRow = startRow;
+                    band->rows = min(bandRows_, height - startRow);
+                    ok = source_.read(pixels.data(), sourceStride, band->rows);
+                    uint8_t* planes[4];
+                    for (uint32_t row = 0; row < band->rows && ok; row++)
+                    {
+                        for (size_t p = 0; p < rasterPlanes(layout_); p++)
+                        {
+                            planes[p] = plane(band, p) + (size_t)row * bytesPerLine_;
+                        }
+                        convertRow(source_.format(), layout_, pixels.data() + row * sourceStride, planes, width);
+                    }
+                    if (ok)
+                    {
+                        {
+                            lock_guard<mutex> lock(mutex_);
+                            ready_.push_back(band);
+                        }
+                        readied_.notify_one();
+                    }
+                }
+            }
+            catch (exception)
+            {
+                ok = false;
+            }
+            if (!ok)
+            {
+                {
+                    lock_guard<mutex> lock(mutex_);
+                    failed_ = true;
+                }
+                readied_.notify_one();
+            }
+        }
+
+        RasterSource& source_;
+        RasterLayout layout_;
+        uint32_t bytesPerLine_;
+        uint32_t bandRows_;
+
+        Band bands_[PIPELINE_DEPTH];
+        mutex mutex_;
+        condition_variable freed_;
+        condition_variable readied_;
+        deque<Band*> free_;
+        deque<Band*> ready_;
+        bool stopping_;
+        bool failed_;
+        thread thread_;
+    };
+
+    HPLFPSDK::Types::Result sendBands(HPLFPSDK::IJobPacker* packer, HPLFPSDK::IJobPacker::pageid_t pageId,
+                                      RasterSource& source, RasterLayout layout, uint32_t bytesPerLine)
+    {
+        const uint32_t height = source.height();
+        const size_t planes = rasterPlanes(layout);
+        const uint32_t bandRows = (uint32_t)max((size_t)1, min((size_t)height, BAND_BYTES / (bytesPerLine * planes)));
+        BandPipeline pipeline(source, layout, bytesPerLine, bandRows);
+        Metrics& metrics = Metrics::instance();
+        HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_OK;
+        for (uint32_t sent = 0; sent < height && result == HPLFPSDK::Types::RESULT_OK; )
+        {
+            bool stalled = false;
+            Band* band = pipeline.next(stalled);
+            if (band == NULL)
+            {
+                // Immagine troncata o illeggibile
+                return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+            }
+            if (stalled)
+            {
+                metrics.increment(METRIC_RASTER_STALLS);
+            }
+            MetricTimer timer(METRIC_PHASE_RASTER_BAND);
+            if (planes == 1)
+            {
+                result = packer->addRasterData(pageId, bytesPerLine, band->rows, band->startRow, band->data.data());
+            }
+            else
+            {
+                uint8_t* buffers[4];
+                for (size_t p = 0; p < planes; p++)
+                {
+                    buffers[p] = pipeline.plane(band, p);
+                }
+                HPLFPSDK::IJobPacker::RS_buffer buffer;
+                buffer.numPlane_ = (uint8_t)planes;
+                buffer.buffer = buffers;
+                result = packer->addRasterDataRSBuffer(pageId, bytesPerLine, band->rows, band->startRow, buffer);
+            }
+            timer.stop(result);
+            metrics.increment(METRIC_RASTER_BANDS);
+            sent += band->rows;
+            pipeline.recycle(band);
+        }
+        return result;
+    }
+
+    HPLFPSDK::Types::Result sendPage(HPLFPSDK::IJobPacker* packer, const RasterJob& job, RasterLayout layout)
+    {
+        HPLFPSDK::IJobPacker::IPageSettings* settings = packer->getPageSettingsContainer();
+        if (settings == NULL)
+        {
+            return HPLFPSDK::Types::RESULT_ERROR_INTERNAL;
+        }
+        HPLFPSDK::IJobPacker::pageid_t pageId = 0;
+        HPLFPSDK::Types::Result result = packer->addPage(settings, pageId);
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return result;
+        }
+        uint32_t bytesPerLine = 0;
+        result = packer->startRasterKey(pageId, job.rasterConfig.c_str(), job.source->width(), job.source->height(), &bytesPerLine);
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return result;
+        }
+        if (bytesPerLine < (unsigned long long)job.source->width() * rasterBytesPerPixel(layout))
+        {
+            return HPLFPSDK::Types::RESULT_ERROR_UNSUPPORTED_RASTER_FMT;
+        }
+        result = sendBands(packer, pageId, *job.source, layout, bytesPerLine);
+        if (result == HPLFPSDK::Types::RESULT_OK)
+        {
+            result = packer->endRaster(pageId);
+        }
+        if (result == HPLFPSDK::Types::RESULT_OK)
+        {
+            result = packer->endPage(pageId);
+        }
+        return result;
+    }
+
+    HPLFPSDK::Types::Result sendJob(HPLFPSDK::IJobPacker* packer, const RasterJob& job, RasterLayout layout)
+    {
+        HPLFPSDK::IJobPacker::IJobSettings* settings = packer->getJobSettingsContainer();
+        if (settings == NULL)
+        {
+            return HPLFPSDK::Types::RESULT_ERROR_INTERNAL;
+        }
+        if (!job.jobName.empty())
+        {
+            settings->setJobName(job.jobName.c_str());
+        }
+        HPLFPSDK::Types::Result result = packer->newJob(settings, job.memoryHandler, job.callback, job.userData);
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return result;
+        }
+        result = sendPage(packer, job, layout);
+        if (result == HPLFPSDK::Types::RESULT_OK)
+        {
+            result = packer->endJob();
+        }
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            packer->jobCancel();
+        }
+        return result;
+    }
+}
+
+RasterJob::RasterJob()
+    : source(NULL), memoryHandler(NULL), callback(NULL), userData(NULL)
+{
+}
+
+HPLFPSDK::Types::Result submitRasterJob(HPLFPSDK::IDevice* device, const RasterJob& job)
+{
+    if (device == NULL || job.source == NULL || job.source->width() == 0 || job.source->height() == 0)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    RasterLayout layout = parseRasterLayout(job.rasterConfig.c_str());
+    if (layout == RASTER_LAYOUT_UNSUPPORTED)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_UNSUPPORTED_RASTER_FMT;
+    }
+    MetricTimer timer(METRIC_PHASE_JOB_SUBMIT);
+    HPLFPSDK::IJobPacker* packer = device->createJobPackerUsingRasterConfiguration(job.rasterConfig.c_str());
+    if (packer == NULL)
+    {
+        return timer.stop(HPLFPSDK::Types::RESULT_ERROR_UNSUPPORTED_RASTER_FMT);
+    }
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_ERROR;
+    try
+    {
+        result = sendJob(packer, job, layout);
+    }
+    catch (exception)
+    {
+        packer->jobCancel();
+    }
+    device->discardJobPacker(packer);
+    return timer.stop(result);
+}
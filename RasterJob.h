@@ -0,0 +1,32 @@
+#ifndef RASTER_JOB_H
+#define RASTER_JOB_H
+
+#include <string>
+#include "IHplfpsdk.h"
+#include "RasterSource.h"
+
+struct RasterJob
+{
+    RasterJob();
+
+    RasterSource* source;
+    std::string rasterConfig;                               // "CHUNKY-XRGB-32-600-PCL3_TAOS"
+    std::string jobName;                                    // vuoto: nessun JobName
+    HPLFPSDK::IJobPacker::IMemoryHandler* memoryHandler;    // NULL: l'SDK invia il job alla stampante
+    HPLFPSDK::IJobPacker::transmissionStatusCallback callback;
+    void* userData;
+};
+
+// Stampa l'immagine di job come un job di una pagina: newJob, addPage,
+// startRasterKey, addRasterData a bande, endRaster, endPage ed endJob sul
+// JobPacker creato dalla rasterConfig. In caso di errore il job viene annullato
+// con jobCancel; il JobPacker viene sempre scartato.
+//
+// Le bande passano da una pipeline produttore/consumatore con tre buffer da
+// circa 4 MiB: un thread legge e converte la banda N+1 mentre
+// il chiamante consegna la banda N ad addRasterData, dove l'SDK la comprime e
+// la trasmette. Se l'SDK e' piu' lento della lettura la pipeline resta piena
+// e la memoria usata non cresce.
+HPLFPSDK::Types::Result submitRasterJob(HPLFPSDK::IDevice* device, const RasterJob& job);
+
+#endif // RASTER_JOB_H
@@ -0,0 +1,119 @@
+#include "RasterSource.h"
+
+#include <cctype>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+    // Prossimo numero dell'header PPM, saltando spazi e commenti "#...".
+    bool readNumber(istream& file, uint32_t& value)
+    {
+        int c = file.get();
+        while (c != EOF && (isspace(c) || c == '#'))
+        {
+            if (c == '#')
+            {
+                while (c != EOF && c != '\n')
+                {
+                    c = file.get();
+                }
+            }
+            c = file.get();
+        }
+        if (c == EOF || !isdigit(c))
+        {
+            return false;
+        }
+        unsigned long long number = 0;
+        while (c != EOF && isdigit(c) && number <= 0xFFFFFFFFull)
+        {
+            number = number * 10 + (c - '0');
+            c = file.get();
+        }
+        value = (uint32_t)number;
+        // Un solo spazio separa l'ultimo numero dai pixel
+        return number <= 0xFFFFFFFFull && c != EOF && isspace(c);
+    }
+}
+
+NetpbmRasterSource::NetpbmRasterSource()
+    : width_(0), height_(0), format_(SOURCE_RGB8)
+{
+}
+
+bool NetpbmRasterSource::open(const string& path)
+{
+    file_.open(path.c_str(), ios::binary);
+    char magic[2];
+    if (!file_.read(magic, 2) || magic[0] != 'P')
+    {
+        return false;
+    }
+    bool ok = magic[1] == '6' ? readPpmHeader() : magic[1] == '7' ? readPamHeader() : false;
+    return ok && width_ > 0 && height_ > 0;
+}
+
+bool NetpbmRasterSource::readPpmHeader()
+{
+    uint32_t maxValue = 0;
+    format_ = SOURCE_RGB8;
+    return readNumber(file_, width_) && readNumber(file_, height_) && readNumber(file_, maxValue) && maxValue == 255;
+}
+
+bool NetpbmRasterSource::readPamHeader()
+{
+    uint32_t depth = 0;
+    uint32_t maxValue = 0;
+    string line;
+    while (getline(file_, line))
+    {
+        istringstream fields(line);
+        string key;
+        fields >> key;
+        if (key == "ENDHDR")
+        {
+            if (maxValue != 255 || (depth != 3 && depth != 4))
+            {
+                return false;
+            }
+            format_ = depth == 4 ? SOURCE_RGBA8 : SOURCE_RGB8;
+            return true;
+        }
+        if (key == "WIDTH")
+        {
+            fields >> width_;
+        }
+        else if (key == "HEIGHT")
+        {
+            fields >> height_;
+        }
+        else if (key == "DEPTH")
+        {
+            fields >> depth;
+        }
+        else if (key == "MAXVAL")
+        {
+            fields >> maxValue;
+        }
+    }
+    return false;
+}
+
+bool NetpbmRasterSource::read(uint8_t* buffer, size_t stride, uint32_t rows)
+{
+    const size_t rowBytes = (size_t)width_ * sourceBytesPerPixel(format_);
+    if (stride == rowBytes)
+    {
+        return (bool)file_.read((char*)buffer, (streamsize)(rowBytes * rows));
+    }
+    for (uint32_t row = 0; row < rows; row++)
+    {
+        if (!file_.read((char*)buffer + row * stride, (streamsize)rowBytes))
+        {
+            return false;
+        }
+    }
+    return true;
+}
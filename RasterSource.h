@@ -0,0 +1,51 @@
+#ifndef RASTER_SOURCE_H
+#define RASTER_SOURCE_H
+
+#include <fstream>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "ColorConversion.h"
+
+// Immagine letta a bande dall'alto verso il basso (vedi submitRasterJob).
+class RasterSource
+{
+public:
+    virtual ~RasterSource() {}
+
+    virtual uint32_t width() const = 0;
+    virtual uint32_t height() const = 0;
+    virtual SourceFormat format() const = 0;
+
+    // Legge le prossime rows righe in buffer, stride byte tra l'inizio di una
+    // riga e la successiva. false se l'immagine e' finita o illeggibile.
+    virtual bool read(uint8_t* buffer, size_t stride, uint32_t rows) = 0;
+};
+
+// File Netpbm a 8 bit: P6 (PPM, RGB) o P7 (PAM) con DEPTH 3 o 4.
+class NetpbmRasterSource : public RasterSource
+{
+public:
+    NetpbmRasterSource();
+
+    bool open(const std::string& path);
+
+    virtual uint32_t width() const { return width_; }
+    virtual uint32_t height() const { return height_; }
+    virtual SourceFormat format() const { return format_; }
+    virtual bool read(uint8_t* buffer, size_t stride, uint32_t rows);
+
+private:
+    NetpbmRasterSource(const NetpbmRasterSource&);
+    NetpbmRasterSource& operator=(const NetpbmRasterSource&);
+
+    bool readPpmHeader();
+    bool readPamHeader();
+
+    std::ifstream file_;
+    uint32_t width_;
+    uint32_t height_;
+    SourceFormat format_;
+};
+
+#endif // RASTER_SOURCE_H
@@ -0,0 +1,863 @@
+#include "SimulatedDevice.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include "Simulator.h"
+#include "SimulatedJobPacker.h"
+
+using namespace std;
+
+namespace
+{
+    const char PRINTER_STATUS_NOT_INITIALIZED[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<PrinterStatus><Status>Not initialized</Status></PrinterStatus>\n";
+
+    const char LEVEL_OPEN[] = "<LevelPercentage>";
+
+    // Ogni consumo toglie mezzo punto al primo livello del documento
+    const double LEVEL_PER_CONSUMPTION = 0.5;
+
+    bool hasLevels(const string& xml)
+    {
+        return xml.find(LEVEL_OPEN) != string::npos;
+    }
+
+    void consumeLevel(string& xml, unsigned int consumed)
+    {
+        size_t begin = xml.find(LEVEL_OPEN);
+        if (consumed == 0 || begin == string::npos)
+        {
+            return;
+        }
+        begin += sizeof(LEVEL_OPEN) - 1;
+        size_t end = xml.find('<', begin);
+        if (end == string::npos)
+        {
+            return;
+        }
+        double level = atof(xml.substr(begin, end - begin).c_str()) - consumed * LEVEL_PER_CONSUMPTION;
+        char text[32];
+        snprintf(text, sizeof(text), "%.4g", level > 0 ? level : 0.0);
+        xml.replace(begin, end - begin, text);
+    }
+}
+
+SimulatedDevice::SimulatedDevice(const string& ipAddress, const string& printerModel)
+    : ipAddress_(ipAddress),
+      printerModel_(printerModel),
+      readyAt_(chrono::steady_clock::now() + Simulator::instance().config().readinessDelay),
+      consumed_(0),
+      mediaManager_(*this),
+      remoteManager_(*this),
+      accountingManager_(*this),
+      usageManager_(*this),
+      infoManager_(*this)
+{
+    Simulator::instance().deviceCreated();
+}
+
+SimulatedDevice::~SimulatedDevice()
+{
+    Simulator::instance().deviceDiscarded();
+}
+
+void SimulatedDevice::getPrinterModel(char** modelName, size_t& modelNameLength)
+{
+    Simulator::instance().respond(printerModel_, modelName, modelNameLength);
+}
+
+HPLFPSDK::IJobPacker* SimulatedDevice::createJobPackerUsingRasterConfiguration(const char* rasterConfig)
+{
+    if (rasterConfig == NULL)
+    {
+        return NULL;
+    }
+    return new SimulatedJobPacker(*this, HPLFPSDK::IJobPacker::RASTERSTREAM_BANDS);
+}
+
+HPLFPSDK::IJobPacker* SimulatedDevice::createJobPackerUsingPackerType(HPLFPSDK::IJobPacker::JobPackerType jobPackerTypeInfo)
+{
+    if (jobPackerTypeInfo == HPLFPSDK::IJobPacker::JOBPACKER_TYPE_NONE)
+    {
+        return NULL;
+    }
+    return new SimulatedJobPacker(*this, jobPackerTypeInfo);
+}
+
+void SimulatedDevice::discardJobPacker(HPLFPSDK::IJobPacker* packer)
+{
+    delete (SimulatedJobPacker*)packer;
+}
+
+HPLFPSDK::ISolPacker* SimulatedDevice::createSolPackerUsingRasterConfiguration(const char*)
+{
+    return NULL;
+}
+
+HPLFPSDK::ISolPacker* SimulatedDevice::createSolPackerUsingPackerType(HPLFPSDK::IJobPacker::JobPackerType)
+{
+    return NULL;
+}
+
+void SimulatedDevice::discardSolPacker(HPLFPSDK::ISolPacker*)
+{
+}
+
+HPLFPSDK::IMediaManager* SimulatedDevice::getMediaManager()
+{
+    return &mediaManager_;
+}
+
+HPLFPSDK::IRemoteManager* SimulatedDevice::getRemoteManager()
+{
+    return &remoteManager_;
+}
+
+HPLFPSDK::IInfoManager* SimulatedDevice::getInfoManager()
+{
+    return &infoManager_;
+}
+
+HPLFPSDK::IAccountingManager* SimulatedDevice::getAccountingManager()
+{
+    return &accountingManager_;
+}
+
+HPLFPSDK::IUsageManager* SimulatedDevice::getUsageManager()
+{
+    return &usageManager_;
+}
+
+HPLFPSDK::Types::Result SimulatedDevice::getCapabilities(char** capabilities, size_t& capabilitiesLength)
+{
+    return query("Capabilities", capabilities, capabilitiesLength);
+}
+
+HPLFPSDK::Types::Result SimulatedDevice::setLanguage(const char* language)
+{
+    return language == NULL ? HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER : HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::PrinterFamily SimulatedDevice::getPrinterFamily()
+{
+    return HPLFPSDK::Types::PRINTER_FAMILY_LATEX;
+}
+
+HPLFPSDK::IScanPacker* SimulatedDevice::createScanPacker()
+{
+    return NULL;
+}
+
+void SimulatedDevice::discardScanPacker(HPLFPSDK::IScanPacker*)
+{
+}
+
+bool SimulatedDevice::ready() const
+{
+    return chrono::steady_clock::now() >= readyAt_;
+}
+
+bool SimulatedDevice::document(const string& view, string& xml) const
+{
+    if (!Simulator::instance().payload(view, xml))
+    {
+        return false;
+    }
+    consumeLevel(xml, consumed_);
+    return true;
+}
+
+void SimulatedDevice::consume()
+{
+    consumed_++;
+}
+
+HPLFPSDK::Types::Result SimulatedDevice::query(const char* view, char** buffer, size_t& length)
+{
+    Simulator& simulator = Simulator::instance();
+    HPLFPSDK::Types::Result result = simulator.call(ipAddress_);
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    string xml;
+    if (!ready())
+    {
+        // Durante l'avvio lo stato dice "Not initialized" e le altre viste non rispondono
+        if (string(view) != "PrinterStatus")
+        {
+            return HPLFPSDK::Types::RESULT_ERROR_NOT_YET_INITIALIZED;
+        }
+        xml = PRINTER_STATUS_NOT_INITIALIZED;
+    }
+    else if (!document(view, xml))
+    {
+        return HPLFPSDK::Types::RESULT_NOT_SUPPORTED;
+    }
+    return simulator.respond(xml, buffer, length);
+}
+
+HPLFPSDK::Types::Result SimulatedDevice::command()
+{
+    HPLFPSDK::Types::Result result = Simulator::instance().call(ipAddress_);
+    if (result == HPLFPSDK::Types::RESULT_OK && !ready())
+    {
+        result = HPLFPSDK::Types::RESULT_ERROR_NOT_YET_INITIALIZED;
+    }
+    return result;
+}
+
+SimulatedInfoManager::SimulatedInfoManager(SimulatedDevice& device)
+    : device_(device), nextSubscriptionId_(1), stopping_(false)
+{
+}
+
+SimulatedInfoManager::~SimulatedInfoManager()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (events_.joinable())
+    {
+        events_.join();
+    }
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getPrinterConfiguration(char** printerConfiguration, size_t& lenPrinterConfiguration)
+{
+    return device_.query("PrinterConfiguration", printerConfiguration, lenPrinterConfiguration);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getMediaStatus(char** mediaStatus, size_t& lenMediaStatus)
+{
+    return device_.query("MediaStatus", mediaStatus, lenMediaStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getInkSystemStatus(char** inkSystemStatus, size_t& lenInkSystemStatus)
+{
+    return device_.query("InkSystem", inkSystemStatus, lenInkSystemStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getInkSlotGroupStatus(uint32_t, char** inkSlotGroupStatus, size_t& lenInkSlotGroupStatus)
+{
+    return device_.query("InkSlotGroup", inkSlotGroupStatus, lenInkSlotGroupStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getInkSlotStatus(uint32_t, char** inkSlotStatus, size_t& lenInkSlotStatus)
+{
+    return device_.query("InkSlot", inkSlotStatus, lenInkSlotStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getPrinterStatus(char** printerStatusInfoXml, size_t& lenPrinterStatusInfoXml)
+{
+    return device_.query("PrinterStatus", printerStatusInfoXml, lenPrinterStatusInfoXml);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getInkCollectionUnitStatus(char** inkCollectionUnitStatusInfoXml, size_t& lenInkCollectionUnitStatusInfoXml)
+{
+    return device_.query("InkCollectionUnit", inkCollectionUnitStatusInfoXml, lenInkCollectionUnitStatusInfoXml);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getDrawersStatus(char** drawerStatus, size_t& lenDrawerStatus)
+{
+    return device_.query("Drawers", drawerStatus, lenDrawerStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getDrawerStatus(uint32_t, char** drawerStatus, size_t& lenDrawerStatus)
+{
+    return device_.query("Drawer", drawerStatus, lenDrawerStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getInputDevicesStatus(char** inputDeviceStatus, size_t& lenInputDeviceStatus)
+{
+    return device_.query("InputDevices", inputDeviceStatus, lenInputDeviceStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getInputDeviceStatus(const char*, char** inputDeviceStatus, size_t& lenInputDeviceStatus)
+{
+    return device_.query("InputDevice", inputDeviceStatus, lenInputDeviceStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getOutputDevicesStatus(char** outputDeviceStatus, size_t& lenOutputDeviceStatus)
+{
+    return device_.query("OutputDevices", outputDeviceStatus, lenOutputDeviceStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getOutputDeviceStatus(const char*, char** outputDeviceStatus, size_t& lenOutputDeviceStatus)
+{
+    return device_.query("OutputDevice", outputDeviceStatus, lenOutputDeviceStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getPrintheadSlotsStatus(char** printheadSlotStatus, size_t& lenPrintheadSlotStatus)
+{
+    return device_.query("PrintheadSlots", printheadSlotStatus, lenPrintheadSlotStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getPrintheadSlotStatus(uint32_t, char** printheadSlotStatus, size_t& lenPrintheadSlotStatus)
+{
+    return device_.query("PrintheadSlot", printheadSlotStatus, lenPrintheadSlotStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getAlertStatus(InfoAlertFilter, const char*, char** alertStatus, size_t& lenAlertStatus)
+{
+    return device_.query("AlertStatus", alertStatus, lenAlertStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToPrinterStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_PRINTER_STATUS, "PrinterStatus", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToAlertStatus(const char*, onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_ALERT_STATUS, "AlertStatus", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToDrawersStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_DRAWER_STATUS, "Drawers", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToDrawerStatus(uint32_t, onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_DRAWER_STATUS, "Drawer", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToInputDevicesStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_MEDIA_INPUT_DEVICE_STATUS, "InputDevices", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToInputDeviceStatus(const char*, onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_MEDIA_INPUT_DEVICE_STATUS, "InputDevice", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToOutputDevicesStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_MEDIA_OUTPUT_DEVICE_STATUS, "OutputDevices", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToOutputDeviceStatus(const char*, onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_MEDIA_OUTPUT_DEVICE_STATUS, "OutputDevice", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToInkSystemStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_INK_SLOT_GROUP_STATUS, "InkSystem", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToInkSlotGroupStatus(uint32_t, onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_INK_SLOT_GROUP_STATUS, "InkSlotGroup", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToInkSlotStatus(uint32_t, onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_INK_SLOT_STATUS, "InkSlot", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToPrintheadSlotsStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_PRINTHEAD_SLOT_STATUS, "PrintheadSlots", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToPrintheadSlotStatus(uint32_t, onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_PRINTHEAD_SLOT_STATUS, "PrintheadSlot", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getCuttingDevicesStatus(char** cuttingDevicesStatus, size_t& lenCuttingDevicesStatus)
+{
+    return device_.query("CuttingDevices", cuttingDevicesStatus, lenCuttingDevicesStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getCuttingDeviceStatus(uint32_t, char** cuttingDeviceStatus, size_t& lenCuttingDeviceStatus)
+{
+    return device_.query("CuttingDevice", cuttingDeviceStatus, lenCuttingDeviceStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToCuttingDevicesStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_MEDIA_CUTTING_DEVICE_STATUS, "CuttingDevices", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToCuttingDeviceStatus(uint32_t, onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_MEDIA_CUTTING_DEVICE_STATUS, "CuttingDevice", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getMaintenanceSystemStatus(char** maintenanceSystemStatus, size_t& lenMaintenanceSystemStatus)
+{
+    return device_.query("MaintenanceSystem", maintenanceSystemStatus, lenMaintenanceSystemStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getMaintenanceCartridgesStatus(char** maintenanceCartridgesStatus, size_t& lenMaintenanceCartridges)
+{
+    return device_.query("MaintenanceCartridges", maintenanceCartridgesStatus, lenMaintenanceCartridges);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getMaintenanceCartridgeStatus(const char*, char** maintenanceCartridgeStatus, size_t& lenMaintenanceCartridge)
+{
+    return device_.query("MaintenanceCartridge", maintenanceCartridgeStatus, lenMaintenanceCartridge);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getLiquidTanksStatus(char** liquidTanksStatus, size_t& lenLiquidTanksStatus)
+{
+    return device_.query("LiquidTanks", liquidTanksStatus, lenLiquidTanksStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getLiquidTankStatus(const char*, char** liquidTankStatus, size_t& lenLiquidTankStatus)
+{
+    return device_.query("LiquidTank", liquidTankStatus, lenLiquidTankStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getCondensationCollectorsStatus(char** condensationCollectorsStatus, size_t& lenCondensationCollectorsStatus)
+{
+    return device_.query("CondensationCollectors", condensationCollectorsStatus, lenCondensationCollectorsStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getCondensationCollectorStatus(const char*, char** condensationCollectorStatus, size_t& lenCondensationCollectorStatus)
+{
+    return device_.query("CondensationCollector", condensationCollectorStatus, lenCondensationCollectorStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToMaintenanceCartridgesStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_MAINTENANCE_CARTRIDGE_STATUS, "MaintenanceCartridges", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToLiquidTanksStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_LIQUID_TANK_STATUS, "LiquidTanks", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToCondensationCollectorsStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_CONDENSATION_COLLECTOR_STATUS, "CondensationCollectors", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getWasteCollectorsStatus(char** wasteCollectorsStatus, size_t& lenWasteCollectorsStatus)
+{
+    return device_.query("WasteCollectors", wasteCollectorsStatus, lenWasteCollectorsStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getWasteCollectorStatus(int, char** wasteCollectorStatus, size_t& lenWasteCollectorStatus)
+{
+    return device_.query("WasteCollector", wasteCollectorStatus, lenWasteCollectorStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToWasteCollectorsStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_WASTE_COLLECTOR_STATUS, "WasteCollectors", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getAirflowsKitsStatus(char** airfowsKitsStatus, size_t& lenAirflowsKitsStatus)
+{
+    return device_.query("AirflowsKits", airfowsKitsStatus, lenAirflowsKitsStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::getAirflowsKitStatus(const char*, char** airflowsKitStatus, size_t& lenAirflowsKitStatus)
+{
+    return device_.query("AirflowsKit", airflowsKitStatus, lenAirflowsKitStatus);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribeToAirflowsKitsStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    return subscribe(EVENT_AIRFLOWS_KIT_STATUS, "AirflowsKits", callback, userData, subscriptionId);
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::unsubscribe(uint32_t subscriptionId)
+{
+    bool fromCallback = false;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (subscriptions_.erase(subscriptionId) == 0)
+        {
+            return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+        }
+        fromCallback = this_thread::get_id() == events_.get_id();
+    }
+    // Al ritorno nessuna callback della sottoscrizione e' in corso, salvo che
+    // sia la callback stessa a cancellarla
+    if (!fromCallback)
+    {
+        lock_guard<mutex> delivery(deliveryMutex_);
+    }
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result SimulatedInfoManager::subscribe(InfoEventType type, const char* view, onChangeCallback callback, void* userData, uint32_t* subscriptionId)
+{
+    if (callback == NULL || subscriptionId == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    HPLFPSDK::Types::Result result = device_.command();
+    if (result != HPLFPSDK::Types::RESULT_OK && result != HPLFPSDK::Types::RESULT_ERROR_NOT_YET_INITIALIZED)
+    {
+        return result;
+    }
+    lock_guard<mutex> lock(mutex_);
+    Subscription subscription;
+    subscription.type = type;
+    subscription.view = view;
+    subscription.callback = callback;
+    subscription.userData = userData;
+    *subscriptionId = nextSubscriptionId_++;
+    subscriptions_[*subscriptionId] = subscription;
+    if (!events_.joinable())
+    {
+        events_ = thread(&SimulatedInfoManager::run, this);
+    }
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+void SimulatedInfoManager::run()
+{
+    const chrono::milliseconds interval = Simulator::instance().config().eventInterval;
+    bool announced = device_.ready();
+    chrono::steady_clock::time_point nextConsumption = chrono::steady_clock::now() + interval;
+
+    unique_lock<mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        if (!announced)
+        {
+            wake_.wait_until(lock, device_.readyAt());
+        }
+        else if (interval.count() > 0)
+        {
+            wake_.wait_until(lock, nextConsumption);
+        }
+        else
+        {
+            wake_.wait(lock);
+        }
+        if (stopping_)
+        {
+            break;
+        }
+
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        if (!announced && device_.ready())
+        {
+            announced = true;
+            lock.unlock();
+            deliver(true);
+            lock.lock();
+        }
+        else if (announced && interval.count() > 0 && now >= nextConsumption)
+        {
+            nextConsumption += interval;
+            device_.consume();
+            lock.unlock();
+            deliver(false);
+            lock.lock();
+        }
+    }
+}
+
+// Invia a ogni sottoscrizione interessata il documento attuale della sua vista:
+// lo stato della stampante oppure le viste con livelli dei consumabili.
+void SimulatedInfoManager::deliver(bool printerStatus)
+{
+    map<uint32_t, Subscription> subscriptions;
+    {
+        lock_guard<mutex> lock(mutex_);
+        subscriptions = subscriptions_;
+    }
+    lock_guard<mutex> delivery(deliveryMutex_);
+    for (map<uint32_t, Subscription>::const_iterator it = subscriptions.begin(); it != subscriptions.end(); ++it)
+    {
+        const Subscription& subscription = it->second;
+        if ((subscription.type == EVENT_PRINTER_STATUS) != printerStatus)
+        {
+            continue;
+        }
+        string xml;
+        if (!device_.document(subscription.view, xml) || (!printerStatus && !hasLevels(xml)))
+        {
+            continue;
+        }
+        {
+            // Cancellata nel frattempo: unsubscribe non attende piu' questa callback
+            lock_guard<mutex> lock(mutex_);
+            if (subscriptions_.count(it->first) == 0)
+            {
+                continue;
+            }
+        }
+        subscription.callback(subscription.type, subscription.userData, it->first, xml.c_str(), (int)xml.size() + 1);
+        Simulator::instance().eventDelivered();
+    }
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::createCustomMedia(const char*, const char*, char** cumstomMediaInformation, size_t& lenCustomMediaInformation)
+{
+    return device_.query("CreateCustomMedia", cumstomMediaInformation, lenCustomMediaInformation);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::createNewMedia(const char*, char** createNewMediaInfo, size_t& bufLength)
+{
+    return device_.query("CreateNewMedia", createNewMediaInfo, bufLength);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::createPaperMode(const char*, char** createPaperMode, size_t& bufLength)
+{
+    return device_.query("CreatePaperMode", createPaperMode, bufLength);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::getMediaInformation(const char*, char** mediaInformation, size_t& lenMediaInformation)
+{
+    return device_.query("MediaInformation", mediaInformation, lenMediaInformation);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::getMediaCounterList(const char*, char** mediaInformation, size_t& lenMediaInformation)
+{
+    return device_.query("MediaCounterList", mediaInformation, lenMediaInformation);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::getMediaInformationCounter(char** mediaInfoCounter, size_t& lenMediaInfoCounter)
+{
+    return device_.query("MediaInformationCounter", mediaInfoCounter, lenMediaInfoCounter);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::deleteCustomMedia(const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::deletePaperMode(const char*, const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::setMediaPropertiesToDefault(const char*, const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::modifyPaperMode(const char*, const char*, const char*, const char*, char** modifyPaperMode, size_t& bufLength)
+{
+    return device_.query("ModifyPaperMode", modifyPaperMode, bufLength);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::setMediumProperties(const char*, const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::setMediumPropertiesEx(const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::getSupportedPrintmodes(const char*, char** supportedPrintmodes, size_t& lenSupportedPrintmodes)
+{
+    return device_.query("SupportedPrintmodes", supportedPrintmodes, lenSupportedPrintmodes);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::getIccProfile(const char*, const char*, char** IccProfile, size_t& lenIccProfile)
+{
+    return device_.query("IccProfile", IccProfile, lenIccProfile);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::copyIccProfile(const char*, const char*, const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::deleteIccProfile(const char*, const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::setIccProfile(const char*, const char*, const char*, const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::getMechanicalProperties(const char*, const char*, char** mechanicalProperties, size_t& lenMechanicalProperties)
+{
+    return device_.query("MechanicalProperties", mechanicalProperties, lenMechanicalProperties);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::setIdentificationProperties(const char*, const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::getIccProfileVersion(const char*, const char*, char** profileVersion, size_t& bufLength)
+{
+    return device_.query("IccProfileVersion", profileVersion, bufLength);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::uploadMediaPreset(const char*, size_t, char** uploadMediaPresetStatus, size_t& lenUploadMediaPreset)
+{
+    return device_.query("UploadMediaPreset", uploadMediaPresetStatus, lenUploadMediaPreset);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::downloadMediaPreset(const char*, char** downloadMediaPresetContent, size_t& lenDownloadMediaPresetContent)
+{
+    return device_.query("DownloadMediaPreset", downloadMediaPresetContent, lenDownloadMediaPresetContent);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::getLookUpTable(const char*, const char*, char** lookuptable, size_t& bufLength)
+{
+    return device_.query("LookUpTable", lookuptable, bufLength);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::setIccProfileSideB(const char*, const char*, const char*, const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::getIccProfileSideB(const char*, const char*, char** IccProfile, size_t& lenIccProfile)
+{
+    return device_.query("IccProfileSideB", IccProfile, lenIccProfile);
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::deleteIccProfileSideB(const char*, const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::subscribeToMediaInformationCounter(onChangeCallback, void*, uint32_t*)
+{
+    return HPLFPSDK::Types::RESULT_NOT_SUPPORTED;
+}
+
+HPLFPSDK::Types::Result SimulatedMediaManager::unsubscribe(uint32_t)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::prepareToPrint()
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::formFeedAndCut()
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::triggerCalibration(HPLFPSDK::Types::CalibrationType, char** jobStatusUUID, size_t& lenJobStatusUUID)
+{
+    return device_.query("TriggerCalibration", jobStatusUUID, lenJobStatusUUID);
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::triggerAdvanceCalibration(HPLFPSDK::Types::CalibrationDestinationType, char** jobStatusUUID, size_t& lenJobStatusUUID)
+{
+    return device_.query("TriggerAdvanceCalibration", jobStatusUUID, lenJobStatusUUID);
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::getJobStatusList(char** jobStatusInfoXml, size_t& lenJobStatusInfoXml)
+{
+    return device_.query("JobStatusList", jobStatusInfoXml, lenJobStatusInfoXml);
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::wakePrinter()
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::getJobStatus(const char*, char** jobStatusInfoXml, size_t& lenJobStatusInfoXml)
+{
+    return device_.query("JobStatus", jobStatusInfoXml, lenJobStatusInfoXml);
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::cancelPrintJob(const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::deletePrintJob(const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::reprintJob(const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::pausePrintJob(const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::resumePrintJob(const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::resumeJobQueue()
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::pauseJobQueue()
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::promotePrintJob(const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::setJobAccID(const char*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::getFolderCapability(char** folderCapability, size_t& lenFolderCapabilities, const char*, const char*)
+{
+    return device_.query("FolderCapability", folderCapability, lenFolderCapabilities);
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::getSolStandard(char** solStandard, size_t& bufLength)
+{
+    return device_.query("SolStandard", solStandard, bufLength);
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::triggerInkDensityCalibration(char** jobStatusId, size_t& bufLength)
+{
+    return device_.query("TriggerInkDensityCalibration", jobStatusId, bufLength);
+}
+
+HPLFPSDK::IRemoteManager::IReprintSettings* SimulatedRemoteManager::getReprintSettingsContainer()
+{
+    return NULL;
+}
+
+HPLFPSDK::Types::Result SimulatedRemoteManager::reprintJobAdvanced(const char*, const char*, const HPLFPSDK::IRemoteManager::IReprintSettings*)
+{
+    return device_.command();
+}
+
+HPLFPSDK::Types::Result SimulatedAccountingManager::getJobAccountingInfo(const char*, char** jobAccountingInfoXml, size_t& lenJobAccountingInfoXml)
+{
+    return device_.query("JobAccountingInfo", jobAccountingInfoXml, lenJobAccountingInfoXml);
+}
+
+HPLFPSDK::Types::Result SimulatedAccountingManager::getJobAccountingInfoByDate(const char*, const char*, char** jobAccountingInfoXml, size_t& lenJobAccountingInfoXml)
+{
+    return device_.query("JobAccountingInfoByDate", jobAccountingInfoXml, lenJobAccountingInfoXml);
+}
+
+HPLFPSDK::Types::Result SimulatedAccountingManager::getJobAccountingInfoByNumber(uint32_t, char** jobAccountingInfoXml, size_t& lenJobAccountingInfoXml)
+{
+    return device_.query("JobAccountingInfoByNumber", jobAccountingInfoXml, lenJobAccountingInfoXml);
+}
+
+HPLFPSDK::Types::Result SimulatedUsageManager::getPrinterUsageInfo(char** printerUsageInfoXml, size_t& lenPrinterUsageInfoXml)
+{
+    return device_.query("PrinterUsageInfo", printerUsageInfoXml, lenPrinterUsageInfoXml);
+}
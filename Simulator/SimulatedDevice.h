@@ -0,0 +1,254 @@
+#ifndef SIMULATED_DEVICE_H
+#define SIMULATED_DEVICE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "../IHplfpsdk.h"
+
+class SimulatedDevice;
+
+// Stato della stampante simulata. Le interrogazioni restituiscono i documenti
+// di Simulator::payload; le viste senza documento rispondono RESULT_NOT_SUPPORTED.
+// Le sottoscrizioni ricevono gli eventi da un thread del device, avviato alla
+// prima sottoscrizione: EVENT_PRINTER_STATUS quando la stampante diventa
+// pronta e, ogni eventInterval, le viste con livelli (i consumabili calano).
+class SimulatedInfoManager : public HPLFPSDK::IInfoManager
+{
+public:
+    explicit SimulatedInfoManager(SimulatedDevice& device);
+    ~SimulatedInfoManager();
+
+    virtual HPLFPSDK::Types::Result getPrinterConfiguration(char** printerConfiguration, size_t& lenPrinterConfiguration);
+    virtual HPLFPSDK::Types::Result getMediaStatus(char** mediaStatus, size_t& lenMediaStatus);
+    virtual HPLFPSDK::Types::Result getInkSystemStatus(char** inkSystemStatus, size_t& lenInkSystemStatus);
+    virtual HPLFPSDK::Types::Result getInkSlotGroupStatus(uint32_t inkSlotGroupId, char** inkSlotGroupStatus, size_t& lenInkSlotGroupStatus);
+    virtual HPLFPSDK::Types::Result getInkSlotStatus(uint32_t inkSlotId, char** inkSlotStatus, size_t& lenInkSlotStatus);
+    virtual HPLFPSDK::Types::Result getPrinterStatus(char** printerStatusInfoXml, size_t& lenPrinterStatusInfoXml);
+    virtual HPLFPSDK::Types::Result getInkCollectionUnitStatus(char** inkCollectionUnitStatusInfoXml, size_t& lenInkCollectionUnitStatusInfoXml);
+    virtual HPLFPSDK::Types::Result getDrawersStatus(char** drawerStatus, size_t& lenDrawerStatus);
+    virtual HPLFPSDK::Types::Result getDrawerStatus(uint32_t drawerId, char** drawerStatus, size_t& lenDrawerStatus);
+    virtual HPLFPSDK::Types::Result getInputDevicesStatus(char** inputDeviceStatus, size_t& lenInputDeviceStatus);
+    virtual HPLFPSDK::Types::Result getInputDeviceStatus(const char* inputDeviceId, char** inputDeviceStatus, size_t& lenInputDeviceStatus);
+    virtual HPLFPSDK::Types::Result getOutputDevicesStatus(char** outputDeviceStatus, size_t& lenOutputDeviceStatus);
+    virtual HPLFPSDK::Types::Result getOutputDeviceStatus(const char* outputDeviceId, char** outputDeviceStatus, size_t& lenOutputDeviceStatus);
+    virtual HPLFPSDK::Types::Result getPrintheadSlotsStatus(char** printheadSlotStatus, size_t& lenPrintheadSlotStatus);
+    virtual HPLFPSDK::Types::Result getPrintheadSlotStatus(uint32_t printheadSlotId, char** printheadSlotStatus, size_t& lenPrintheadSlotStatus);
+    virtual HPLFPSDK::Types::Result getAlertStatus(InfoAlertFilter filterType, const char* alertFilter, char** alertStatus, size_t& lenAlertStatus);
+    virtual HPLFPSDK::Types::Result subscribeToPrinterStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToAlertStatus(const char* alertFilter, onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToDrawersStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToDrawerStatus(uint32_t drawerId, onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToInputDevicesStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToInputDeviceStatus(const char* deviceId, onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToOutputDevicesStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToOutputDeviceStatus(const char* deviceId, onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToInkSystemStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToInkSlotGroupStatus(uint32_t inkSlotGroupId, onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToInkSlotStatus(uint32_t inkSlotId, onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToPrintheadSlotsStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToPrintheadSlotStatus(uint32_t printheadSlotId, onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result getCuttingDevicesStatus(char** cuttingDevicesStatus, size_t& lenCuttingDevicesStatus);
+    virtual HPLFPSDK::Types::Result getCuttingDeviceStatus(uint32_t cuttingDeviceId, char** cuttingDeviceStatus, size_t& lenCuttingDeviceStatus);
+    virtual HPLFPSDK::Types::Result subscribeToCuttingDevicesStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToCuttingDeviceStatus(uint32_t deviceId, onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result getMaintenanceSystemStatus(char** maintenanceSystemStatus, size_t& lenMaintenanceSystemStatus);
+    virtual HPLFPSDK::Types::Result getMaintenanceCartridgesStatus(char** maintenanceCartridgesStatus, size_t& lenMaintenanceCartridges);
+    virtual HPLFPSDK::Types::Result getMaintenanceCartridgeStatus(const char* maintenanceCartridgeId, char** maintenanceCartridgeStatus, size_t& lenMaintenanceCartridge);
+    virtual HPLFPSDK::Types::Result getLiquidTanksStatus(char** liquidTanksStatus, size_t& lenLiquidTanksStatus);
+    virtual HPLFPSDK::Types::Result getLiquidTankStatus(const char* liquidTankId, char** liquidTankStatus, size_t& lenLiquidTankStatus);
+    virtual HPLFPSDK::Types::Result getCondensationCollectorsStatus(char** condensationCollectorsStatus, size_t& lenCondensationCollectorsStatus);
+    virtual HPLFPSDK::Types::Result getCondensationCollectorStatus(const char* condensationCollectorId, char** condensationCollectorStatus, size_t& lenCondensationCollectorStatus);
+    virtual HPLFPSDK::Types::Result subscribeToMaintenanceCartridgesStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToLiquidTanksStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result subscribeToCondensationCollectorsStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result getWasteCollectorsStatus(char** wasteCollectorsStatus, size_t& lenWasteCollectorsStatus);
+    virtual HPLFPSDK::Types::Result getWasteCollectorStatus(int wasteCollectorId, char** wasteCollectorStatus, size_t& lenWasteCollectorStatus);
+    virtual HPLFPSDK::Types::Result subscribeToWasteCollectorsStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result getAirflowsKitsStatus(char** airfowsKitsStatus, size_t& lenAirflowsKitsStatus);
+    virtual HPLFPSDK::Types::Result getAirflowsKitStatus(const char* airflowsKitId, char** airflowsKitStatus, size_t& lenAirflowsKitStatus);
+    virtual HPLFPSDK::Types::Result subscribeToAirflowsKitsStatus(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result unsubscribe(uint32_t subscriptionId);
+
+private:
+    struct Subscription
+    {
+        InfoEventType type;
+        std::string view;
+        onChangeCallback callback;
+        void* userData;
+    };
+
+    SimulatedInfoManager(const SimulatedInfoManager&);
+    SimulatedInfoManager& operator=(const SimulatedInfoManager&);
+
+    HPLFPSDK::Types::Result subscribe(InfoEventType type, const char* view, onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    void run();
+    void deliver(bool printerStatus);
+
+    SimulatedDevice& device_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::map<uint32_t, Subscription> subscriptions_;
+    uint32_t nextSubscriptionId_;
+    bool stopping_;
+    std::thread events_;
+    // Tenuto durante ogni callback: unsubscribe attende quella in corso
+    std::mutex deliveryMutex_;
+};
+
+class SimulatedMediaManager : public HPLFPSDK::IMediaManager
+{
+public:
+    explicit SimulatedMediaManager(SimulatedDevice& device) : device_(device) {}
+
+    virtual HPLFPSDK::Types::Result createCustomMedia(const char* mediaName, const char* donorMediaID, char** cumstomMediaInformation, size_t& lenCustomMediaInformation);
+    virtual HPLFPSDK::Types::Result createNewMedia(const char* mediaSettingsXmlInfo, char** createNewMediaInfo, size_t& bufLength);
+    virtual HPLFPSDK::Types::Result createPaperMode(const char* mediaSettingsXmlInfo, char** createPaperMode, size_t& bufLength);
+    virtual HPLFPSDK::Types::Result getMediaInformation(const char* mediaKey, char** mediaInformation, size_t& lenMediaInformation);
+    virtual HPLFPSDK::Types::Result getMediaCounterList(const char* mediaKey, char** mediaInformation, size_t& lenMediaInformation);
+    virtual HPLFPSDK::Types::Result getMediaInformationCounter(char** mediaInfoCounter, size_t& lenMediaInfoCounter);
+    virtual HPLFPSDK::Types::Result deleteCustomMedia(const char* mediaID);
+    virtual HPLFPSDK::Types::Result deletePaperMode(const char* mediumId, const char* ModeId);
+    virtual HPLFPSDK::Types::Result setMediaPropertiesToDefault(const char* mediumId, const char* ModeId);
+    virtual HPLFPSDK::Types::Result modifyPaperMode(const char* mediumId, const char* ModeId, const char* paramKey, const char* paramValue, char** modifyPaperMode, size_t& bufLength);
+    virtual HPLFPSDK::Types::Result setMediumProperties(const char* mediaID, const char* mediaSettingsXmlInfo);
+    virtual HPLFPSDK::Types::Result setMediumPropertiesEx(const char* mediaSettingsXmlInfo);
+    virtual HPLFPSDK::Types::Result getSupportedPrintmodes(const char* mediaKey, char** supportedPrintmodes, size_t& lenSupportedPrintmodes);
+    virtual HPLFPSDK::Types::Result getIccProfile(const char* mediaKey, const char* selectorList, char** IccProfile, size_t& lenIccProfile);
+    virtual HPLFPSDK::Types::Result copyIccProfile(const char* mediaKey, const char* srcSelectorList, const char* destSelectorList);
+    virtual HPLFPSDK::Types::Result deleteIccProfile(const char* mediaKey, const char* selectorList);
+    virtual HPLFPSDK::Types::Result setIccProfile(const char* mediaKey, const char* selectorList, const char* iccName, const char* profileContents);
+    virtual HPLFPSDK::Types::Result getMechanicalProperties(const char* mediaKey, const char* paperMode, char** mechanicalProperties, size_t& lenMechanicalProperties);
+    virtual HPLFPSDK::Types::Result setIdentificationProperties(const char* mediaKey, const char* asciiName);
+    virtual HPLFPSDK::Types::Result getIccProfileVersion(const char* mediumKey, const char* selectorList, char** profileVersion, size_t& bufLength);
+    virtual HPLFPSDK::Types::Result uploadMediaPreset(const char* uploadContent, size_t uploadContentLength, char** uploadMediaPresetStatus, size_t& lenUploadMediaPreset);
+    virtual HPLFPSDK::Types::Result downloadMediaPreset(const char* mediaId, char** downloadMediaPresetContent, size_t& lenDownloadMediaPresetContent);
+    virtual HPLFPSDK::Types::Result getLookUpTable(const char* mediaKey, const char* selectorList, char** lookuptable, size_t& bufLength);
+    virtual HPLFPSDK::Types::Result setIccProfileSideB(const char* mediaKey, const char* selectorList, const char* iccName, const char* profileContents);
+    virtual HPLFPSDK::Types::Result getIccProfileSideB(const char* mediaKey, const char* selectorList, char** IccProfile, size_t& lenIccProfile);
+    virtual HPLFPSDK::Types::Result deleteIccProfileSideB(const char* mediaKey, const char* selectorList);
+    virtual HPLFPSDK::Types::Result subscribeToMediaInformationCounter(onChangeCallback callback, void* userData, uint32_t* subscriptionId);
+    virtual HPLFPSDK::Types::Result unsubscribe(uint32_t subscriptionId);
+
+private:
+    SimulatedDevice& device_;
+};
+
+class SimulatedRemoteManager : public HPLFPSDK::IRemoteManager
+{
+public:
+    explicit SimulatedRemoteManager(SimulatedDevice& device) : device_(device) {}
+
+    virtual HPLFPSDK::Types::Result prepareToPrint();
+    virtual HPLFPSDK::Types::Result formFeedAndCut();
+    virtual HPLFPSDK::Types::Result triggerCalibration(HPLFPSDK::Types::CalibrationType calibrationType, char** jobStatusUUID, size_t& lenJobStatusUUID);
+    virtual HPLFPSDK::Types::Result triggerAdvanceCalibration(HPLFPSDK::Types::CalibrationDestinationType destinationType, char** jobStatusUUID, size_t& lenJobStatusUUID);
+    virtual HPLFPSDK::Types::Result getJobStatusList(char** jobStatusInfoXml, size_t& lenJobStatusInfoXml);
+    virtual HPLFPSDK::Types::Result wakePrinter();
+    virtual HPLFPSDK::Types::Result getJobStatus(const char* jobId, char** jobStatusInfoXml, size_t& lenJobStatusInfoXml);
+    virtual HPLFPSDK::Types::Result cancelPrintJob(const char* jobUUID);
+    virtual HPLFPSDK::Types::Result deletePrintJob(const char* jobUUID);
+    virtual HPLFPSDK::Types::Result reprintJob(const char* jobUUID);
+    virtual HPLFPSDK::Types::Result pausePrintJob(const char* jobUUID);
+    virtual HPLFPSDK::Types::Result resumePrintJob(const char* jobUUID);
+    virtual HPLFPSDK::Types::Result resumeJobQueue();
+    virtual HPLFPSDK::Types::Result pauseJobQueue();
+    virtual HPLFPSDK::Types::Result promotePrintJob(const char* jobUUID);
+    virtual HPLFPSDK::Types::Result setJobAccID(const char* jobUUID);
+    virtual HPLFPSDK::Types::Result getFolderCapability(char** folderCapability, size_t& lenFolderCapabilities, const char* AccName, const char* Lang);
+    virtual HPLFPSDK::Types::Result getSolStandard(char** solStandard, size_t& bufLength);
+    virtual HPLFPSDK::Types::Result triggerInkDensityCalibration(char** jobStatusId, size_t& bufLength);
+    virtual IReprintSettings* getReprintSettingsContainer();
+    virtual HPLFPSDK::Types::Result reprintJobAdvanced(const char* jobUuid, const char* newJobUuid, const HPLFPSDK::IRemoteManager::IReprintSettings* settings);
+
+private:
+    SimulatedDevice& device_;
+};
+
+class SimulatedAccountingManager : public HPLFPSDK::IAccountingManager
+{
+public:
+    explicit SimulatedAccountingManager(SimulatedDevice& device) : device_(device) {}
+
+    virtual HPLFPSDK::Types::Result getJobAccountingInfo(const char* jobId, char** jobAccountingInfoXml, size_t& lenJobAccountingInfoXml);
+    virtual HPLFPSDK::Types::Result getJobAccountingInfoByDate(const char* startDate, const char* endDate, char** jobAccountingInfoXml, size_t& lenJobAccountingInfoXml);
+    virtual HPLFPSDK::Types::Result getJobAccountingInfoByNumber(uint32_t numberOfJobs, char** jobAccountingInfoXml, size_t& lenJobAccountingInfoXml);
+
+private:
+    SimulatedDevice& device_;
+};
+
+class SimulatedUsageManager : public HPLFPSDK::IUsageManager
+{
+public:
+    explicit SimulatedUsageManager(SimulatedDevice& device) : device_(device) {}
+
+    virtual HPLFPSDK::Types::Result getPrinterUsageInfo(char** printerUsageInfoXml, size_t& lenPrinterUsageInfoXml);
+
+private:
+    SimulatedDevice& device_;
+};
+
+// IDevice restituito da hplfpsdk_getNewPrinter. Solo i job packer RasterStream
+// e PCL3 sono simulati (vedi SimulatedJobPacker); SOL e scansione no.
+class SimulatedDevice : public HPLFPSDK::IDevice
+{
+public:
+    SimulatedDevice(const std::string& ipAddress, const std::string& printerModel);
+    ~SimulatedDevice();
+
+    virtual void getPrinterModel(char** modelName, size_t& modelNameLength);
+    virtual HPLFPSDK::IJobPacker* createJobPackerUsingRasterConfiguration(const char* rasterConfig);
+    virtual HPLFPSDK::IJobPacker* createJobPackerUsingPackerType(HPLFPSDK::IJobPacker::JobPackerType jobPackerTypeInfo);
+    virtual void discardJobPacker(HPLFPSDK::IJobPacker* packer);
+    virtual HPLFPSDK::ISolPacker* createSolPackerUsingRasterConfiguration(const char* rasterConfig);
+    virtual HPLFPSDK::ISolPacker* createSolPackerUsingPackerType(HPLFPSDK::IJobPacker::JobPackerType jobPackerTypeInfo);
+    virtual void discardSolPacker(HPLFPSDK::ISolPacker* packer);
+    virtual HPLFPSDK::IMediaManager* getMediaManager();
+    virtual HPLFPSDK::IRemoteManager* getRemoteManager();
+    virtual HPLFPSDK::IInfoManager* getInfoManager();
+    virtual HPLFPSDK::IAccountingManager* getAccountingManager();
+    virtual HPLFPSDK::IUsageManager* getUsageManager();
+    virtual HPLFPSDK::Types::Result getCapabilities(char** capabilities, size_t& capabilitiesLength);
+    virtual HPLFPSDK::Types::Result setLanguage(const char* language);
+    virtual HPLFPSDK::Types::PrinterFamily getPrinterFamily();
+    virtual HPLFPSDK::IScanPacker* createScanPacker();
+    virtual void discardScanPacker(HPLFPSDK::IScanPacker* packer);
+
+    const std::string& ipAddress() const { return ipAddress_; }
+
+    // Momento in cui la stampante smette di rispondere "Not initialized"
+    std::chrono::steady_clock::time_point readyAt() const { return readyAt_; }
+    bool ready() const;
+
+    // Documento attuale della vista, con i livelli ridotti dai consumi.
+    bool document(const std::string& view, std::string& xml) const;
+    void consume();
+
+    // Chiamata verso la stampante che restituisce la vista view.
+    HPLFPSDK::Types::Result query(const char* view, char** buffer, size_t& length);
+    // Chiamata verso la stampante senza dati in risposta.
+    HPLFPSDK::Types::Result command();
+
+private:
+    SimulatedDevice(const SimulatedDevice&);
+    SimulatedDevice& operator=(const SimulatedDevice&);
+
+    std::string ipAddress_;
+    std::string printerModel_;
+    std::chrono::steady_clock::time_point readyAt_;
+    std::atomic<unsigned int> consumed_;
+
+    SimulatedMediaManager mediaManager_;
+    SimulatedRemoteManager remoteManager_;
+    SimulatedAccountingManager accountingManager_;
+    SimulatedUsageManager usageManager_;
+    SimulatedInfoManager infoManager_;
+};
+
+#endif // SIMULATED_DEVICE_H
@@ -0,0 +1,721 @@
+#include "SimulatedJobPacker.h"
+
+#include <cstdlib>
+#include <cstring>
+#include "SimulatedDevice.h"
+#include "Simulator.h"
+
+using namespace std;
+
+HPLFPSDK::Types::Result SettingValues::set(const char* key, const char* value)
+{
+    if (value == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    return setText(key, value);
+}
+
+HPLFPSDK::Types::Result SettingValues::set(const char* key, const HPLFPSDK::Types::MetricDistance& value)
+{
+    return setText(key, to_string(value.units));
+}
+
+HPLFPSDK::Types::Result SettingValues::setText(const char* key, const string& value)
+{
+    if (key == NULL || *key == '\0')
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    for (size_t i = 0; i < values_.size(); i++)
+    {
+        if (values_[i].first == key)
+        {
+            values_[i].second = value;
+            return HPLFPSDK::Types::RESULT_OK;
+        }
+    }
+    values_.push_back(make_pair(string(key), value));
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result SettingValues::dump(const char* element, char** settings, long* settingsLength) const
+{
+    if (settings == NULL || settingsLength == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    string xml = string("<") + element + ">";
+    for (size_t i = 0; i < values_.size(); i++)
+    {
+        xml += "<" + values_[i].first + ">" + values_[i].second + "</" + values_[i].first + ">";
+    }
+    xml += string("</") + element + ">";
+    size_t length = 0;
+    HPLFPSDK::Types::Result result = Simulator::instance().respond(xml, settings, length);
+    *settingsLength = (long)length;
+    return result;
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::dumpToChar(char** settings, long* settingsLength)
+{
+    return values_.dump("JobSettings", settings, settingsLength);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setAttendedMode(const HPLFPSDK::Types::BooleanPlusDefault& value)
+{
+    return values_.set("AttendedMode", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setJobCollate(const HPLFPSDK::Types::JobCollate& value)
+{
+    return values_.set("JobCollate", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setCutter(const HPLFPSDK::Types::Cutter& value)
+{
+    return values_.set("Cutter", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setPrintingOrder(const HPLFPSDK::Types::PrintingOrder& value)
+{
+    return values_.set("PrintingOrder", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setAccountId(const char* value)
+{
+    return values_.set("AccountId", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setApplicationName(const char* value)
+{
+    return values_.set("ApplicationName", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setApplicationUuid(const char* value)
+{
+    return values_.set("ApplicationUuid", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setApplicationVersion(const char* value)
+{
+    return values_.set("ApplicationVersion", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setPartnerId(const char* value)
+{
+    return values_.set("PartnerId", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setFMBillable(const HPLFPSDK::Types::BooleanPlusDefault& value)
+{
+    return values_.set("FMBillable", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setFMToken(const char* value)
+{
+    return values_.set("FMToken", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setProjectId(const char* value)
+{
+    return values_.set("ProjectId", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setJobName(const char* value)
+{
+    return values_.set("JobName", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setJobCopies(const HPLFPSDK::Types::NumCopies& value)
+{
+    return values_.set("JobCopies", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setTimeStamp(const char* value)
+{
+    return values_.set("TimeStamp", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setUserName(const char* value)
+{
+    return values_.set("UserName", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setJobUuid(const char* value)
+{
+    return values_.set("JobUuid", value);
+}
+
+HPLFPSDK::Types::Result SimulatedJobSettings::setDualSideOrder(const HPLFPSDK::Types::DualSideOrder& value)
+{
+    return values_.set("DualSideOrder", value);
+}
+HPLFPSDK::Types::Result SimulatedPageSettings::dumpToChar(char** settings, long* settingsLength)
+{
+    return values_.dump("PageSettings", settings, settingsLength);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setSelector(const char* key, const char* value)
+{
+    return values_.set(key, value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setBorderlessMethod(const HPLFPSDK::Types::BorderlessMethod& value)
+{
+    return values_.set("BorderlessMethod", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setBottomMargin(const HPLFPSDK::Types::MetricDistance& value)
+{
+    return values_.set("BottomMargin", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setCopies(const HPLFPSDK::Types::NumCopies& value)
+{
+    return values_.set("Copies", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setColorMode(const HPLFPSDK::Types::ColorMode& value)
+{
+    return values_.set("ColorMode", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setDryTimeMode(const HPLFPSDK::Types::DryTimeMode& value)
+{
+    return values_.set("DryTimeMode", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setDualSide(const HPLFPSDK::Types::DualSide& value)
+{
+    return values_.set("DualSide", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setDuplex(const HPLFPSDK::Types::BooleanPlusDefault& value)
+{
+    return values_.set("Duplex", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setEconomode(const HPLFPSDK::Types::Economode& value)
+{
+    return values_.set("Economode", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setEfficiencyMode(const HPLFPSDK::Types::EfficiencyMode& value)
+{
+    return values_.set("EfficiencyMode", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setExtendedPM(const HPLFPSDK::Types::ExtendedPM& value)
+{
+    return values_.set("ExtendedPM", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setExtraPasses(const HPLFPSDK::Types::ExtraPasses& value)
+{
+    return values_.set("ExtraPasses", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setStandardFoldingStyle(const int32_t& value)
+{
+    return values_.set("StandardFoldingStyle", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setFoldingStyle(const HPLFPSDK::Types::FoldingStyle& value)
+{
+    return values_.set("FoldingStyle", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setGlossEnhancer(const HPLFPSDK::Types::GlossEnhancer& value)
+{
+    return values_.set("GlossEnhancer", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setHighSpeed(const HPLFPSDK::Types::HighSpeed& value)
+{
+    return values_.set("HighSpeed", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setInkDensity(const HPLFPSDK::Types::InkDensity& value)
+{
+    return values_.set("InkDensity", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setInkDensityB(const HPLFPSDK::Types::InkDensity& value)
+{
+    return values_.set("InkDensityB", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setLeftMargin(const HPLFPSDK::Types::MetricDistance& value)
+{
+    return values_.set("LeftMargin", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setMarginLayout(const HPLFPSDK::Types::MarginLayout& value)
+{
+    return values_.set("MarginLayout", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setMarginType(const HPLFPSDK::Types::MarginSetting& value)
+{
+    return values_.set("MarginType", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setAutomaticContentAlignment(const HPLFPSDK::Types::ContentAlignment& value)
+{
+    return values_.set("AutomaticContentAlignment", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setMaxDetail(const HPLFPSDK::Types::MaxDetail& value)
+{
+    return values_.set("MaxDetail", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setMediaCategory(const char* value)
+{
+    return values_.set("MediaCategory", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setMediaDestination(const HPLFPSDK::Types::MediaDestination& value)
+{
+    return values_.set("MediaDestination", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setMediaId(const char* value)
+{
+    return values_.set("MediaId", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setMediaSource(const HPLFPSDK::Types::MediaSource& value)
+{
+    return values_.set("MediaSource", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setAutomaticRollSwitchPolicy(const HPLFPSDK::Types::RollSwitchPolicy& value)
+{
+    return values_.set("AutomaticRollSwitchPolicy", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setLength(const HPLFPSDK::Types::MetricDistance& value)
+{
+    return values_.set("Length", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setWidth(const HPLFPSDK::Types::MetricDistance& value)
+{
+    return values_.set("Width", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setPreTreatementLevel(const int32_t& value)
+{
+    return values_.set("PreTreatementLevel", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setPrintArea(const HPLFPSDK::Types::PrintArea& value)
+{
+    return values_.set("PrintArea", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setPrintQuality(const HPLFPSDK::Types::PrintQuality& value)
+{
+    return values_.set("PrintQuality", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setOutputRenderIntent(const HPLFPSDK::Types::RenderIntent& value)
+{
+    return values_.set("OutputRenderIntent", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setRenderMode(const HPLFPSDK::Types::RenderMode& value)
+{
+    return values_.set("RenderMode", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setColorSpace(const HPLFPSDK::Types::ColorSpace& value)
+{
+    return values_.set("ColorSpace", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setRenderingResolution(const HPLFPSDK::Types::RenderingResolution& value)
+{
+    return values_.set("RenderingResolution", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setRetMode(const HPLFPSDK::Types::RetMode& value)
+{
+    return values_.set("RetMode", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setRightMargin(const HPLFPSDK::Types::MetricDistance& value)
+{
+    return values_.set("RightMargin", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setTopMargin(const HPLFPSDK::Types::MetricDistance& value)
+{
+    return values_.set("TopMargin", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setUnidirectional(const HPLFPSDK::Types::Unidirectional& value)
+{
+    return values_.set("Unidirectional", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setWhiteMode(const HPLFPSDK::Types::WhiteMode& value)
+{
+    return values_.set("WhiteMode", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setWhiteOpacity(const int32_t& value)
+{
+    return values_.set("WhiteOpacity", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setYCutter(const HPLFPSDK::Types::YCutter& value)
+{
+    return values_.set("YCutter", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setWhiteShrink(const HPLFPSDK::Types::WhiteShrink& value)
+{
+    return values_.set("WhiteShrink", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setWhiteShrinkPixelsAmount(const uint32_t& value)
+{
+    return values_.set("WhiteShrinkPixelsAmount", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setWhiteShrinkProtectPixelsAmount(const uint32_t& value)
+{
+    return values_.set("WhiteShrinkProtectPixelsAmount", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setWhiteShrinkUseNonWhiteInfo(const bool& value)
+{
+    return values_.set("WhiteShrinkUseNonWhiteInfo", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setOvercoat(const HPLFPSDK::Types::Overcoat& value)
+{
+    return values_.set("Overcoat", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setThickness(const HPLFPSDK::Types::MetricDistance& value)
+{
+    return values_.set("Thickness", value);
+}
+
+HPLFPSDK::Types::Result SimulatedPageSettings::setFlipEdge(const HPLFPSDK::Types::FlipEdge& value)
+{
+    return values_.set("FlipEdge", value);
+}
+SimulatedJobPacker::SimulatedJobPacker(SimulatedDevice& device, JobPackerType type)
+    : device_(device),
+      type_(type),
+      state_(HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_JOB_BEGIN),
+      memoryHandler_(NULL),
+      callback_(NULL),
+      userData_(NULL),
+      bytesSent_(0),
+      nextPage_(1),
+      page_(INVALID_ID),
+      bytesPerLine_(0),
+      height_(0)
+{
+}
+
+SimulatedJobPacker::~SimulatedJobPacker()
+{
+}
+
+HPLFPSDK::IJobPacker::IJobSettings* SimulatedJobPacker::getJobSettingsContainer()
+{
+    jobSettings_.push_back(unique_ptr<SimulatedJobSettings>(new SimulatedJobSettings()));
+    return jobSettings_.back().get();
+}
+
+HPLFPSDK::IJobPacker::IPageSettings* SimulatedJobPacker::getPageSettingsContainer()
+{
+    pageSettings_.push_back(unique_ptr<SimulatedPageSettings>(new SimulatedPageSettings()));
+    return pageSettings_.back().get();
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::newJob(IJobSettings* settings, IMemoryHandler* mhdl, transmissionStatusCallback callback, void* userData)
+{
+    if (settings == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    if (state_ != HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_JOB_BEGIN)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_USAGE_SEQUENCE;
+    }
+    memoryHandler_ = mhdl;
+    callback_ = callback;
+    userData_ = userData;
+    bytesSent_ = 0;
+
+    char* dump = NULL;
+    long length = 0;
+    settings->dumpToChar(&dump, &length);
+    string header = "JOB " + device_.ipAddress() + "\n";
+    if (dump != NULL)
+    {
+        header += dump;
+        header += "\n";
+        hplfpsdk_deleteBuffer(&dump);
+    }
+    HPLFPSDK::Types::Result result = emit(header);
+    state_ = result == HPLFPSDK::Types::RESULT_OK ? HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_PAGE_BEGIN
+                                                  : HPLFPSDK::Types::RASTER_LIB_STATE_ERROR;
+    return result;
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::endJob()
+{
+    HPLFPSDK::Types::Result result = expect(HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_PAGE_BEGIN, INVALID_ID);
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        result = emit("END JOB\n");
+        state_ = HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_JOB_BEGIN;
+    }
+    return result;
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::jobCancel()
+{
+    if (state_ == HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_JOB_BEGIN)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_USAGE_SEQUENCE;
+    }
+    state_ = HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_JOB_BEGIN;
+    page_ = INVALID_ID;
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::addPage(IPageSettings* settings, pageid_t& id)
+{
+    if (settings == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_PAGE_SETTINGS_NULL;
+    }
+    HPLFPSDK::Types::Result result = expect(HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_PAGE_BEGIN, INVALID_ID);
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    char* dump = NULL;
+    long length = 0;
+    settings->dumpToChar(&dump, &length);
+    page_ = nextPage_++;
+    string header = "PAGE " + to_string(page_) + "\n";
+    if (dump != NULL)
+    {
+        header += dump;
+        header += "\n";
+        hplfpsdk_deleteBuffer(&dump);
+    }
+    id = page_;
+    state_ = HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_FIRST_RASTER_START;
+    return emit(header);
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::addPreview(pageid_t pageId, const Preview& preview)
+{
+    if (pageId != page_ || preview.buffer_ == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    HPLFPSDK::Types::Result result = emit("PREVIEW " + to_string(preview.numBytes_) + "\n");
+    return result == HPLFPSDK::Types::RESULT_OK ? emit(preview.buffer_, preview.numBytes_) : result;
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::endPage(pageid_t pageId)
+{
+    if (state_ != HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_FIRST_RASTER_START)
+    {
+        HPLFPSDK::Types::Result result = expect(HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_RASTER_START, pageId);
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return result;
+        }
+    }
+    else if (pageId != page_)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    page_ = INVALID_ID;
+    state_ = HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_PAGE_BEGIN;
+    return emit("END PAGE\n");
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::startRaster(pageid_t pageId, HPLFPSDK::Types::RasterFormat format, uint32_t resolution,
+                                                        uint32_t width, uint32_t height, uint32_t bytesPerLine, uint8_t*, uint32_t numberOfPlanes)
+{
+    if (state_ != HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_FIRST_RASTER_START)
+    {
+        HPLFPSDK::Types::Result result = expect(HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_RASTER_START, pageId);
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return result;
+        }
+    }
+    else if (pageId != page_)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    if (format == HPLFPSDK::Types::INVALID)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_UNSUPPORTED_RASTER_FMT;
+    }
+    if (width == 0 || height == 0 || bytesPerLine == 0 || numberOfPlanes == 0)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    bytesPerLine_ = bytesPerLine;
+    height_ = height;
+    state_ = HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_RASTER;
+    return emit("RASTER " + to_string((unsigned int)format) + " " + to_string(resolution) + " " + to_string(width) + "x" +
+                to_string(height) + " " + to_string(bytesPerLine) + "\n");
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::startRasterKey(pageid_t pageId, const char* rasterConfig, uint32_t width, uint32_t height, uint32_t* bytesPerLine)
+{
+    if (rasterConfig == NULL || bytesPerLine == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    // Configurazione raster simulata: CMYK a 8 bit per canale, o i bit per
+    // pixel del terzo campo per le rasterConfig CHUNKY ("CHUNKY-XRGB-32-...")
+    // e PLANAR ("PLANAR-CMYK-8-...", un piano per inchiostro)
+    unsigned int bits = 32;
+    uint32_t planes = 1;
+    const char* inks = strchr(rasterConfig, '-');
+    const char* field = inks != NULL ? strchr(inks + 1, '-') : NULL;
+    const bool planar = strncmp(rasterConfig, "PLANAR-", 7) == 0;
+    if ((planar || strncmp(rasterConfig, "CHUNKY-", 7) == 0) && field != NULL && atoi(field + 1) > 0)
+    {
+        bits = (unsigned int)atoi(field + 1);
+        planes = planar ? (uint32_t)(field - inks - 1) : 1;
+    }
+    *bytesPerLine = (uint32_t)(((unsigned long long)width * bits + 7) / 8);
+    return startRaster(pageId, planar ? HPLFPSDK::Types::PLANAR : HPLFPSDK::Types::CMYK, 0, width, height, *bytesPerLine, (uint8_t*)"CMYK", planes);
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::addRasterData(pageid_t pageId, unsigned int bufferWidth, unsigned int rows, unsigned int startRow, uint8_t* buffer)
+{
+    HPLFPSDK::Types::Result result = expect(HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_RASTER, pageId);
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    if (buffer == NULL || bufferWidth < bytesPerLine_ || startRow + rows > height_)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    result = emit("ROWS " + to_string(startRow) + " " + to_string(rows) + "\n");
+    for (unsigned int row = 0; row < rows && result == HPLFPSDK::Types::RESULT_OK; row++)
+    {
+        result = emit(buffer + (size_t)row * bufferWidth, bytesPerLine_);
+    }
+    return result;
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::addRasterDataRSBuffer(pageid_t pageId, unsigned int bufferWidth, unsigned int rows, unsigned int startRow, RS_buffer buffer)
+{
+    HPLFPSDK::Types::Result result = expect(HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_RASTER, pageId);
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return result;
+    }
+    if (buffer.buffer == NULL || buffer.numPlane_ == 0 || startRow + rows > height_)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    result = emit("PLANES " + to_string(startRow) + " " + to_string(rows) + " " + to_string(buffer.numPlane_) + "\n");
+    for (unsigned int plane = 0; plane < buffer.numPlane_ && result == HPLFPSDK::Types::RESULT_OK; plane++)
+    {
+        result = buffer.buffer[plane] == NULL ? HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER
+                                              : emit(buffer.buffer[plane], (size_t)bufferWidth * rows);
+    }
+    return result;
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::endRaster(pageid_t pageId)
+{
+    HPLFPSDK::Types::Result result = expect(HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_RASTER, pageId);
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        state_ = HPLFPSDK::Types::RASTER_LIB_STATE_WAITING_FOR_RASTER_START;
+        result = emit("END RASTER\n");
+    }
+    return result;
+}
+
+HPLFPSDK::IJobPacker::JobPackerType SimulatedJobPacker::getJobPackerType()
+{
+    return type_;
+}
+
+HPLFPSDK::Types::RasterLibState SimulatedJobPacker::getState()
+{
+    return state_;
+}
+
+HPLFPSDK::Types::JobLanguage SimulatedJobPacker::getLanguage() const
+{
+    switch (type_)
+    {
+    case PCL3_TAOS:
+    case PCL3_BERT:
+    case PCL3_HALFTONE:
+        return HPLFPSDK::Types::JOB_LANGUAGE_PCL3GUI;
+    default:
+        return HPLFPSDK::Types::JOB_LANGUAGE_RSTREAM;
+    }
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::expect(HPLFPSDK::Types::RasterLibState state, pageid_t pageId) const
+{
+    if (state_ != state)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_USAGE_SEQUENCE;
+    }
+    if (pageId != INVALID_ID && pageId != page_)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::emit(const void* data, size_t size)
+{
+    if (size == 0)
+    {
+        return HPLFPSDK::Types::RESULT_OK;
+    }
+    // Senza memory handler l'SDK invia il job alla stampante: qui i byte vengono solo contati
+    if (memoryHandler_ != NULL)
+    {
+        void* buffer = memoryHandler_->acquireBuffer((uint32_t)size);
+        if (buffer == NULL)
+        {
+            state_ = HPLFPSDK::Types::RASTER_LIB_STATE_ERROR;
+            return HPLFPSDK::Types::RESULT_ERROR_MEMORY;
+        }
+        memcpy(buffer, data, size);
+        memoryHandler_->releaseBuffer((const uint8_t*)buffer, (uint32_t)size);
+    }
+    bytesSent_ += size;
+    if (callback_ != NULL)
+    {
+        callback_(userData_, bytesSent_);
+    }
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result SimulatedJobPacker::emit(const string& text)
+{
+    return emit(text.data(), text.size());
+}
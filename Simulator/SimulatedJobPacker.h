@@ -0,0 +1,172 @@
+#ifndef SIMULATED_JOB_PACKER_H
+#define SIMULATED_JOB_PACKER_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../IHplfpsdk.h"
+
+class SimulatedDevice;
+
+// Impostazioni ricevute da un contenitore, nell'ordine in cui sono state date.
+class SettingValues
+{
+public:
+    HPLFPSDK::Types::Result set(const char* key, const char* value);
+    HPLFPSDK::Types::Result set(const char* key, const HPLFPSDK::Types::MetricDistance& value);
+    template <typename T>
+    HPLFPSDK::Types::Result set(const char* key, const T& value)
+    {
+        return setText(key, std::to_string((long long)value));
+    }
+
+    // <elemento><Chiave>valore</Chiave>...</elemento> in un buffer SDK
+    HPLFPSDK::Types::Result dump(const char* element, char** settings, long* settingsLength) const;
+
+private:
+    HPLFPSDK::Types::Result setText(const char* key, const std::string& value);
+
+    std::vector<std::pair<std::string, std::string> > values_;
+};
+
+class SimulatedJobSettings : public HPLFPSDK::IJobPacker::IJobSettings
+{
+public:
+    virtual HPLFPSDK::Types::Result dumpToChar(char** settings, long* settingsLength);
+    virtual HPLFPSDK::Types::Result setAttendedMode(const HPLFPSDK::Types::BooleanPlusDefault& value);
+    virtual HPLFPSDK::Types::Result setJobCollate(const HPLFPSDK::Types::JobCollate& value);
+    virtual HPLFPSDK::Types::Result setCutter(const HPLFPSDK::Types::Cutter& value);
+    virtual HPLFPSDK::Types::Result setPrintingOrder(const HPLFPSDK::Types::PrintingOrder& value);
+    virtual HPLFPSDK::Types::Result setAccountId(const char* value);
+    virtual HPLFPSDK::Types::Result setApplicationName(const char* value);
+    virtual HPLFPSDK::Types::Result setApplicationUuid(const char* value);
+    virtual HPLFPSDK::Types::Result setApplicationVersion(const char* value);
+    virtual HPLFPSDK::Types::Result setPartnerId(const char* value);
+    virtual HPLFPSDK::Types::Result setFMBillable(const HPLFPSDK::Types::BooleanPlusDefault& value);
+    virtual HPLFPSDK::Types::Result setFMToken(const char* value);
+    virtual HPLFPSDK::Types::Result setProjectId(const char* value);
+    virtual HPLFPSDK::Types::Result setJobName(const char* value);
+    virtual HPLFPSDK::Types::Result setJobCopies(const HPLFPSDK::Types::NumCopies& value);
+    virtual HPLFPSDK::Types::Result setTimeStamp(const char* value);
+    virtual HPLFPSDK::Types::Result setUserName(const char* value);
+    virtual HPLFPSDK::Types::Result setJobUuid(const char* value);
+    virtual HPLFPSDK::Types::Result setDualSideOrder(const HPLFPSDK::Types::DualSideOrder& value);
+
+private:
+    SettingValues values_;
+};
+
+class SimulatedPageSettings : public HPLFPSDK::IJobPacker::IPageSettings
+{
+public:
+    virtual HPLFPSDK::Types::Result dumpToChar(char** settings, long* settingsLength);
+    virtual HPLFPSDK::Types::Result setSelector(const char* key, const char* value);
+    virtual HPLFPSDK::Types::Result setBorderlessMethod(const HPLFPSDK::Types::BorderlessMethod& value);
+    virtual HPLFPSDK::Types::Result setBottomMargin(const HPLFPSDK::Types::MetricDistance& value);
+    virtual HPLFPSDK::Types::Result setCopies(const HPLFPSDK::Types::NumCopies& value);
+    virtual HPLFPSDK::Types::Result setColorMode(const HPLFPSDK::Types::ColorMode& value);
+    virtual HPLFPSDK::Types::Result setDryTimeMode(const HPLFPSDK::Types::DryTimeMode& value);
+    virtual HPLFPSDK::Types::Result setDualSide(const HPLFPSDK::Types::DualSide& value);
+    virtual HPLFPSDK::Types::Result setDuplex(const HPLFPSDK::Types::BooleanPlusDefault& value);
+    virtual HPLFPSDK::Types::Result setEconomode(const HPLFPSDK::Types::Economode& value);
+    virtual HPLFPSDK::Types::Result setEfficiencyMode(const HPLFPSDK::Types::EfficiencyMode& value);
+    virtual HPLFPSDK::Types::Result setExtendedPM(const HPLFPSDK::Types::ExtendedPM& value);
+    virtual HPLFPSDK::Types::Result setExtraPasses(const HPLFPSDK::Types::ExtraPasses& value);
+    virtual HPLFPSDK::Types::Result setStandardFoldingStyle(const int32_t& value);
+    virtual HPLFPSDK::Types::Result setFoldingStyle(const HPLFPSDK::Types::FoldingStyle& value);
+    virtual HPLFPSDK::Types::Result setGlossEnhancer(const HPLFPSDK::Types::GlossEnhancer& value);
+    virtual HPLFPSDK::Types::Result setHighSpeed(const HPLFPSDK::Types::HighSpeed& value);
+    virtual HPLFPSDK::Types::Result setInkDensity(const HPLFPSDK::Types::InkDensity& value);
+    virtual HPLFPSDK::Types::Result setInkDensityB(const HPLFPSDK::Types::InkDensity& value);
+    virtual HPLFPSDK::Types::Result setLeftMargin(const HPLFPSDK::Types::MetricDistance& value);
+    virtual HPLFPSDK::Types::Result setMarginLayout(const HPLFPSDK::Types::MarginLayout& value);
+    virtual HPLFPSDK::Types::Result setMarginType(const HPLFPSDK::Types::MarginSetting& value);
+    virtual HPLFPSDK::Types::Result setAutomaticContentAlignment(const HPLFPSDK::Types::ContentAlignment& value);
+    virtual HPLFPSDK::Types::Result setMaxDetail(const HPLFPSDK::Types::MaxDetail& value);
+    virtual HPLFPSDK::Types::Result setMediaCategory(const char* value);
+    virtual HPLFPSDK::Types::Result setMediaDestination(const HPLFPSDK::Types::MediaDestination& value);
+    virtual HPLFPSDK::Types::Result setMediaId(const char* value);
+    virtual HPLFPSDK::Types::Result setMediaSource(const HPLFPSDK::Types::MediaSource& value);
+    virtual HPLFPSDK::Types::Result setAutomaticRollSwitchPolicy(const HPLFPSDK::Types::RollSwitchPolicy& value);
+    virtual HPLFPSDK::Types::Result setLength(const HPLFPSDK::Types::MetricDistance& value);
+    virtual HPLFPSDK::Types::Result setWidth(const HPLFPSDK::Types::MetricDistance& value);
+    virtual HPLFPSDK::Types::Result setPreTreatementLevel(const int32_t& value);
+    virtual HPLFPSDK::Types::Result setPrintArea(const HPLFPSDK::Types::PrintArea& value);
+    virtual HPLFPSDK::Types::Result setPrintQuality(const HPLFPSDK::Types::PrintQuality& value);
+    virtual HPLFPSDK::Types::Result setOutputRenderIntent(const HPLFPSDK::Types::RenderIntent& value);
+    virtual HPLFPSDK::Types::Result setRenderMode(const HPLFPSDK::Types::RenderMode& value);
+    virtual HPLFPSDK::Types::Result setColorSpace(const HPLFPSDK::Types::ColorSpace& value);
+    virtual HPLFPSDK::Types::Result setRenderingResolution(const HPLFPSDK::Types::RenderingResolution& value);
+    virtual HPLFPSDK::Types::Result setRetMode(const HPLFPSDK::Types::RetMode& value);
+    virtual HPLFPSDK::Types::Result setRightMargin(const HPLFPSDK::Types::MetricDistance& value);
+    virtual HPLFPSDK::Types::Result setTopMargin(const HPLFPSDK::Types::MetricDistance& value);
+    virtual HPLFPSDK::Types::Result setUnidirectional(const HPLFPSDK::Types::Unidirectional& value);
+    virtual HPLFPSDK::Types::Result setWhiteMode(const HPLFPSDK::Types::WhiteMode& value);
+    virtual HPLFPSDK::Types::Result setWhiteOpacity(const int32_t& value);
+    virtual HPLFPSDK::Types::Result setYCutter(const HPLFPSDK::Types::YCutter& value);
+    virtual HPLFPSDK::Types::Result setWhiteShrink(const HPLFPSDK::Types::WhiteShrink& value);
+    virtual HPLFPSDK::Types::Result setWhiteShrinkPixelsAmount(const uint32_t& value);
+    virtual HPLFPSDK::Types::Result setWhiteShrinkProtectPixelsAmount(const uint32_t& value);
+    virtual HPLFPSDK::Types::Result setWhiteShrinkUseNonWhiteInfo(const bool& value);
+    virtual HPLFPSDK::Types::Result setOvercoat(const HPLFPSDK::Types::Overcoat& value);
+    virtual HPLFPSDK::Types::Result setThickness(const HPLFPSDK::Types::MetricDistance& value);
+    virtual HPLFPSDK::Types::Result setFlipEdge(const HPLFPSDK::Types::FlipEdge& value);
+
+private:
+    SettingValues values_;
+};
+
+// Job packer che non comprime: ogni blocco del job (intestazioni, anteprime,
+// righe raster) viene scritto cosi' com'e' nei buffer dell'IMemoryHandler del
+// chiamante e notificato con transmissionStatusCallback. Verifica l'ordine
+// delle chiamate come l'SDK (RESULT_ERROR_INVALID_USAGE_SEQUENCE).
+class SimulatedJobPacker : public HPLFPSDK::IJobPacker
+{
+public:
+    SimulatedJobPacker(SimulatedDevice& device, JobPackerType type);
+    ~SimulatedJobPacker();
+
+    virtual IJobSettings* getJobSettingsContainer();
+    virtual IPageSettings* getPageSettingsContainer();
+    virtual HPLFPSDK::Types::Result newJob(IJobSettings* settings, IMemoryHandler* mhdl, transmissionStatusCallback callback, void* userData);
+    virtual HPLFPSDK::Types::Result endJob();
+    virtual HPLFPSDK::Types::Result jobCancel();
+    virtual HPLFPSDK::Types::Result addPage(IPageSettings* settings, pageid_t& id);
+    virtual HPLFPSDK::Types::Result addPreview(pageid_t pageId, const Preview& preview);
+    virtual HPLFPSDK::Types::Result endPage(pageid_t pageId);
+    virtual HPLFPSDK::Types::Result startRaster(pageid_t pageId, HPLFPSDK::Types::RasterFormat format, uint32_t resolution, uint32_t width, uint32_t height, uint32_t bytesPerLine, uint8_t* planeOrder = (uint8_t*)"CMYK", uint32_t numberOfPlanes = 1);
+    virtual HPLFPSDK::Types::Result startRasterKey(pageid_t pageId, const char* rasterConfig, uint32_t width, uint32_t height, uint32_t* bytesPerLine);
+    virtual HPLFPSDK::Types::Result addRasterData(pageid_t pageId, unsigned int bufferWidth, unsigned int rows, unsigned int startRow, uint8_t* buffer);
+    virtual HPLFPSDK::Types::Result addRasterDataRSBuffer(pageid_t pageId, unsigned int bufferWidth, unsigned int rows, unsigned int startRow, RS_buffer buffer);
+    virtual HPLFPSDK::Types::Result endRaster(pageid_t pageId);
+    virtual JobPackerType getJobPackerType();
+    virtual HPLFPSDK::Types::RasterLibState getState();
+    virtual HPLFPSDK::Types::JobLanguage getLanguage() const;
+
+private:
+    SimulatedJobPacker(const SimulatedJobPacker&);
+    SimulatedJobPacker& operator=(const SimulatedJobPacker&);
+
+    // Verifica stato e pagina corrente; in caso di errore il job resta com'e'
+    HPLFPSDK::Types::Result expect(HPLFPSDK::Types::RasterLibState state, pageid_t pageId) const;
+    HPLFPSDK::Types::Result emit(const void* data, size_t size);
+    HPLFPSDK::Types::Result emit(const std::string& text);
+
+    SimulatedDevice& device_;
+    JobPackerType type_;
+    HPLFPSDK::Types::RasterLibState state_;
+    std::vector<std::unique_ptr<SimulatedJobSettings> > jobSettings_;
+    std::vector<std::unique_ptr<SimulatedPageSettings> > pageSettings_;
+
+    IMemoryHandler* memoryHandler_;
+    transmissionStatusCallback callback_;
+    void* userData_;
+    size_t bytesSent_;
+    pageid_t nextPage_;
+    pageid_t page_;
+    uint32_t bytesPerLine_;
+    uint32_t height_;
+};
+
+#endif // SIMULATED_JOB_PACKER_H
@@ -0,0 +1,462 @@
+#include "Simulator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include "SimulatedDevice.h"
+
+using namespace std;
+
+namespace
+{
+    const char* PRINTER_STATUS_READY =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<PrinterStatus><Status>Ready</Status><MostRelevantStatus>Idle</MostRelevantStatus></PrinterStatus>\n";
+
+    // Viste senza un file nella cartella dei payload
+    const struct
+    {
+        const char* view;
+        const char* xml;
+    } BUILTIN_PAYLOADS[] =
+    {
+        { "PrinterStatus", PRINTER_STATUS_READY },
+        { "LiquidTanks",
+          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<MaintenanceSystem><LiquidTanks>"
+          "<LiquidTank id=\"LiquidTank0\"><IsPresent>true</IsPresent><Overview><StatusList><Status>Ready</Status></StatusList>"
+          "<MostRelevantStatus>Ready</MostRelevantStatus><LevelPercentage>42.5</LevelPercentage></Overview></LiquidTank>"
+          "</LiquidTanks></MaintenanceSystem>\n" },
+        { "WasteCollectors",
+          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<MaintenanceSystem><WasteCollectors>"
+          "<WasteCollector id=\"WasteCollector0\"><IsPresent>true</IsPresent><Overview><StatusList><Status>Ready</Status></StatusList>"
+          "<MostRelevantStatus>Ready</MostRelevantStatus><LevelPercentage>18</LevelPercentage></Overview></WasteCollector>"
+          "</WasteCollectors></MaintenanceSystem>\n" },
+        { "CondensationCollectors",
+          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<MaintenanceSystem><CondensationCollectors>"
+          "<CondensationCollector id=\"CondensationCollector0\"><IsPresent>true</IsPresent><Overview><StatusList><Status>Ready</Status></StatusList>"
+          "<MostRelevantStatus>Ready</MostRelevantStatus><LevelPercentage>5</LevelPercentage></Overview></CondensationCollector>"
+          "</CondensationCollectors></MaintenanceSystem>\n" },
+        { "AirflowsKits",
+          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<MaintenanceSystem><AirflowsKits>"
+          "<AirflowsKit id=\"AirflowsKit0\"><IsPresent>true</IsPresent><Overview><StatusList><Status>Ready</Status></StatusList>"
+          "<MostRelevantStatus>Ready</MostRelevantStatus></Overview></AirflowsKit>"
+          "</AirflowsKits></MaintenanceSystem>\n" },
+        { "PrinterConfiguration",
+          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<PrinterConfiguration><ModelName>HP Latex 800</ModelName>"
+          "<SerialNumber>SIM0000001</SerialNumber><FirmwareVersion>SIMULATOR</FirmwareVersion></PrinterConfiguration>\n" },
+        { "PrinterUsageInfo",
+          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<PrinterUsage><PrintedArea unit=\"m2\">0</PrintedArea></PrinterUsage>\n" }
+    };
+
+    const char* DEFAULT_MODELS[] = { "HP Latex 700", "HP Latex 700W", "HP Latex 800", "HP Latex 800W" };
+
+    long long environmentNumber(const char* name, long long value)
+    {
+        const char* text = getenv(name);
+        return text != NULL && *text != '\0' ? atoll(text) : value;
+    }
+
+    // "a,b,c" -> { "a", "b", "c" }
+    vector<string> environmentList(const char* name, const vector<string>& value)
+    {
+        const char* text = getenv(name);
+        if (text == NULL)
+        {
+            return value;
+        }
+        vector<string> list;
+        string item;
+        for (const char* p = text; ; p++)
+        {
+            if (*p == ',' || *p == '\0')
+            {
+                if (!item.empty())
+                {
+                    list.push_back(item);
+                }
+                item.clear();
+                if (*p == '\0')
+                {
+                    break;
+                }
+            }
+            else if (*p != ' ')
+            {
+                item += *p;
+            }
+        }
+        return list;
+    }
+
+    char toLower(char c)
+    {
+        return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+    }
+
+    bool sameModel(const string& a, const char* b)
+    {
+        size_t i = 0;
+        for (; i < a.size() && b[i] != '\0'; i++)
+        {
+            if (toLower(a[i]) != toLower(b[i]))
+            {
+                return false;
+            }
+        }
+        return i == a.size() && b[i] == '\0';
+    }
+
+    // Stato della libreria: inizializzazione e device creati per indirizzo
+    mutex libraryLock;
+    bool libraryInitialized = false;
+    map<string, SimulatedDevice*> libraryDevices;
+
+    const uint32_t VERSION_MAJOR = 1;
+    const uint32_t VERSION_MINOR = 0;
+}
+
+SimulatorConfig::SimulatorConfig()
+    : latency(environmentNumber("HPSDK_SIM_LATENCY_US", 0)),
+      jitter(environmentNumber("HPSDK_SIM_JITTER_US", 0)),
+      readinessDelay(environmentNumber("HPSDK_SIM_READY_DELAY_MS", 0)),
+      eventInterval(environmentNumber("HPSDK_SIM_EVENT_INTERVAL_MS", 0)),
+      discoveryTime(environmentNumber("HPSDK_SIM_DISCOVERY_MS", 0)),
+      failureRate(getenv("HPSDK_SIM_FAILURE_RATE") != NULL ? atof(getenv("HPSDK_SIM_FAILURE_RATE")) : 0.0),
+      failureResult(getenv("HPSDK_SIM_FAILURE_RESULT") != NULL ? (HPLFPSDK::Types::Result)atoi(getenv("HPSDK_SIM_FAILURE_RESULT"))
+                                                             : HPLFPSDK::Types::RESULT_ERROR_CONNECTION),
+      seed(getenv("HPSDK_SIM_SEED") != NULL ? (unsigned int)strtoul(getenv("HPSDK_SIM_SEED"), NULL, 10) : 1u),
+#ifdef SIMULATOR_PAYLOAD_DIRECTORY
+      payloadDirectory(getenv("HPSDK_SIM_PAYLOADS") != NULL ? getenv("HPSDK_SIM_PAYLOADS") : SIMULATOR_PAYLOAD_DIRECTORY),
+#else
+      payloadDirectory(getenv("HPSDK_SIM_PAYLOADS") != NULL ? getenv("HPSDK_SIM_PAYLOADS") : ""),
+#endif
+      models(environmentList("HPSDK_SIM_MODELS", vector<string>(DEFAULT_MODELS, DEFAULT_MODELS + sizeof(DEFAULT_MODELS) / sizeof(DEFAULT_MODELS[0])))),
+      networkPrinters(environmentList("HPSDK_SIM_PRINTERS", vector<string>())),
+      unreachable(environmentList("HPSDK_SIM_UNREACHABLE", vector<string>()))
+{
+}
+
+Simulator& Simulator::instance()
+{
+    // Mai distrutto: i thread degli eventi possono ancora usarlo all'uscita
+    static Simulator* simulator = new Simulator();
+    return *simulator;
+}
+
+Simulator::Simulator()
+    : calls_(0), failures_(0), events_(0), devices_(0), liveDevices_(0), liveBuffers_(0)
+{
+    random_.seed(config_.seed);
+}
+
+void Simulator::configure(const SimulatorConfig& config)
+{
+    lock_guard<mutex> lock(mutex_);
+    config_ = config;
+    random_.seed(config_.seed);
+    payloads_.clear();
+}
+
+SimulatorConfig Simulator::config() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return config_;
+}
+
+SimulatorStats Simulator::stats() const
+{
+    SimulatorStats stats;
+    stats.calls = calls_;
+    stats.failures = failures_;
+    stats.events = events_;
+    stats.devices = devices_;
+    stats.liveDevices = liveDevices_;
+    stats.liveBuffers = liveBuffers_;
+    return stats;
+}
+
+void Simulator::resetStats()
+{
+    calls_ = 0;
+    failures_ = 0;
+    events_ = 0;
+    devices_ = 0;
+}
+
+HPLFPSDK::Types::Result Simulator::call(const string& ipAddress)
+{
+    chrono::microseconds delay;
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_OK;
+    {
+        lock_guard<mutex> lock(mutex_);
+        delay = config_.latency;
+        if (config_.jitter.count() > 0)
+        {
+            uniform_int_distribution<long long> jitter(-config_.jitter.count(), config_.jitter.count());
+            delay = max(chrono::microseconds(0), delay + chrono::microseconds(jitter(random_)));
+        }
+        if (find(config_.unreachable.begin(), config_.unreachable.end(), ipAddress) != config_.unreachable.end())
+        {
+            result = HPLFPSDK::Types::RESULT_ERROR_CONNECTION;
+        }
+        else if (config_.failureRate > 0 && uniform_real_distribution<double>(0.0, 1.0)(random_) < config_.failureRate)
+        {
+            result = config_.failureResult;
+        }
+    }
+    calls_++;
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        failures_++;
+    }
+    if (delay.count() > 0)
+    {
+        this_thread::sleep_for(delay);
+    }
+    return result;
+}
+
+bool Simulator::payload(const string& view, string& xml) const
+{
+    lock_guard<mutex> lock(mutex_);
+    map<string, string>::const_iterator cached = payloads_.find(view);
+    if (cached != payloads_.end())
+    {
+        xml = cached->second;
+        return !xml.empty();
+    }
+    xml.clear();
+    if (!config_.payloadDirectory.empty())
+    {
+        ifstream file((config_.payloadDirectory + "/" + view + ".xml").c_str(), ios::binary);
+        if (file)
+        {
+            xml.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        }
+    }
+    for (size_t i = 0; xml.empty() && i < sizeof(BUILTIN_PAYLOADS) / sizeof(BUILTIN_PAYLOADS[0]); i++)
+    {
+        if (view == BUILTIN_PAYLOADS[i].view)
+        {
+            xml = BUILTIN_PAYLOADS[i].xml;
+        }
+    }
+    payloads_[view] = xml;
+    return !xml.empty();
+}
+
+bool Simulator::isModelSupported(const char* model) const
+{
+    if (model == NULL)
+    {
+        return false;
+    }
+    lock_guard<mutex> lock(mutex_);
+    for (size_t i = 0; i < config_.models.size(); i++)
+    {
+        if (sameModel(config_.models[i], model))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+HPLFPSDK::Types::Result Simulator::respond(const string& xml, char** buffer, size_t& length)
+{
+    if (buffer == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    // Come l'SDK: testo terminato da '\0', lunghezza con il terminatore
+    *buffer = new char[xml.size() + 1];
+    memcpy(*buffer, xml.c_str(), xml.size() + 1);
+    length = xml.size() + 1;
+    liveBuffers_++;
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+void Simulator::release(char** buffer)
+{
+    if (buffer != NULL && *buffer != NULL)
+    {
+        delete[] *buffer;
+        *buffer = NULL;
+        liveBuffers_--;
+    }
+}
+
+void Simulator::deviceCreated()
+{
+    devices_++;
+    liveDevices_++;
+}
+
+void Simulator::deviceDiscarded()
+{
+    liveDevices_--;
+}
+
+void Simulator::eventDelivered()
+{
+    events_++;
+}
+
+HPLFPSDK::Types::Result hplfpsdk_init(const char*)
+{
+    lock_guard<mutex> lock(libraryLock);
+    libraryInitialized = true;
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+void hplfpsdk_terminate()
+{
+    map<string, SimulatedDevice*> devices;
+    {
+        lock_guard<mutex> lock(libraryLock);
+        libraryInitialized = false;
+        devices.swap(libraryDevices);
+    }
+    for (map<string, SimulatedDevice*>::iterator it = devices.begin(); it != devices.end(); ++it)
+    {
+        delete it->second;
+    }
+}
+
+HPLFPSDK::Types::Result hplfpsdk_getVersion(uint32_t* majorVersion, uint32_t* minorVersion)
+{
+    if (majorVersion == NULL || minorVersion == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    *majorVersion = VERSION_MAJOR;
+    *minorVersion = VERSION_MINOR;
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result hplfpsdk_getNetworkPrinters(char** networkPrinters, size_t& networkPrintersLength)
+{
+    return hplfpsdk_getNetworkPrintersExtended(0, 0, true, networkPrinters, networkPrintersLength);
+}
+
+HPLFPSDK::Types::Result hplfpsdk_getNetworkPrintersExtended(uint32_t, uint32_t discoveryTimeOut, bool, char** networkPrinters, size_t& networkPrintersLength)
+{
+    {
+        lock_guard<mutex> lock(libraryLock);
+        if (!libraryInitialized)
+        {
+            return HPLFPSDK::Types::RESULT_ERROR_LIBRARY_NOT_INITIALIZED;
+        }
+    }
+    Simulator& simulator = Simulator::instance();
+    simulator.call(string());
+    SimulatorConfig config = simulator.config();
+    // Come l'SDK la ricerca occupa il chiamante per tutta la sua durata
+    chrono::milliseconds scan = config.discoveryTime;
+    if (discoveryTimeOut > 0)
+    {
+        scan = min(scan, chrono::milliseconds(discoveryTimeOut * 1000LL));
+    }
+    this_thread::sleep_for(scan);
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<NetworkPrinters>";
+    for (size_t i = 0; i < config.networkPrinters.size(); i++)
+    {
+        xml += "<Printer><IpAddress>" + config.networkPrinters[i] + "</IpAddress><ModelName>" +
+               (config.models.empty() ? string() : config.models[i % config.models.size()]) + "</ModelName></Printer>";
+    }
+    xml += "</NetworkPrinters>\n";
+    return simulator.respond(xml, networkPrinters, networkPrintersLength);
+}
+
+HPLFPSDK::Types::Result hplfpsdk_getNewPrinter(const char* ipAddress, const char* printerModelName, HPLFPSDK::IDevice*& device)
+{
+    device = NULL;
+    if (ipAddress == NULL || printerModelName == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    Simulator& simulator = Simulator::instance();
+    if (!simulator.isModelSupported(printerModelName))
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_PRINTER_MODEL_UNKNOWN;
+    }
+    {
+        lock_guard<mutex> lock(libraryLock);
+        if (!libraryInitialized)
+        {
+            return HPLFPSDK::Types::RESULT_ERROR_LIBRARY_NOT_INITIALIZED;
+        }
+        if (*ipAddress != '\0' && libraryDevices.count(ipAddress) != 0)
+        {
+            return HPLFPSDK::Types::RESULT_ERROR_DEVICE_ALREADY_EXISTS;
+        }
+    }
+    // Come l'SDK reale il device viene creato anche se la stampante non risponde:
+    // qui conta solo l'errore iniettato
+    HPLFPSDK::Types::Result result = simulator.call(string());
+    if (result != HPLFPSDK::Types::RESULT_OK)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR;
+    }
+
+    lock_guard<mutex> lock(libraryLock);
+    if (*ipAddress != '\0' && libraryDevices.count(ipAddress) != 0)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_DEVICE_ALREADY_EXISTS;
+    }
+    SimulatedDevice* created = new SimulatedDevice(ipAddress, printerModelName);
+    if (*ipAddress != '\0')
+    {
+        libraryDevices[ipAddress] = created;
+    }
+    device = created;
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result hplfpsdk_discardPrinter(HPLFPSDK::IDevice* device)
+{
+    if (device == NULL)
+    {
+        return HPLFPSDK::Types::RESULT_ERROR_INVALID_PARAMETER;
+    }
+    SimulatedDevice* simulated = (SimulatedDevice*)device;
+    {
+        lock_guard<mutex> lock(libraryLock);
+        map<string, SimulatedDevice*>::iterator it = libraryDevices.find(simulated->ipAddress());
+        if (it != libraryDevices.end() && it->second == simulated)
+        {
+            libraryDevices.erase(it);
+        }
+    }
+    delete simulated;
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+void hplfpsdk_deleteBuffer(char** buffer)
+{
+    Simulator::instance().release(buffer);
+}
+
+HPLFPSDK::Types::Result hplfpsdk_setLogLevel(HPLFPSDK::Types::LogLevel)
+{
+    return HPLFPSDK::Types::RESULT_OK;
+}
+
+HPLFPSDK::Types::Result hplfpsdk_getSupportedPrinterModels(char** printerModels, size_t& printerModelsLength)
+{
+    SimulatorConfig config = Simulator::instance().config();
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<SupportedPrinterModels>";
+    for (size_t i = 0; i < config.models.size(); i++)
+    {
+        xml += "<Model>" + config.models[i] + "</Model>";
+    }
+    xml += "</SupportedPrinterModels>\n";
+    return Simulator::instance().respond(xml, printerModels, printerModelsLength);
+}
+
+bool hplfpsdk_isPrinterModelSupported(const char* modelName)
+{
+    return Simulator::instance().isModelSupported(modelName);
+}
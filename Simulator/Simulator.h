@@ -0,0 +1,92 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include "../IHplfpsdk.h"
+
+// Comportamento della libreria HP LFP SDK simulata (libhplfpsdk su Linux).
+// I valori iniziali vengono letti dalle variabili d'ambiente HPSDK_SIM_*
+// (vedi Simulator.cpp); un benchmark puo' cambiarli con Simulator::configure.
+struct SimulatorConfig
+{
+    SimulatorConfig();
+
+    std::chrono::microseconds latency;          // durata di ogni chiamata verso la stampante
+    std::chrono::microseconds jitter;           // variazione casuale (+/-) della latenza
+    std::chrono::milliseconds readinessDelay;   // "Not initialized" fino a questo tempo dalla creazione
+    std::chrono::milliseconds eventInterval;    // periodo degli eventi di consumo; 0 = nessuno
+    std::chrono::milliseconds discoveryTime;    // durata della ricerca in rete (al massimo discoveryTimeOut)
+    double failureRate;                         // probabilita' di errore di ogni chiamata (0..1)
+    HPLFPSDK::Types::Result failureResult;      // errore restituito quando la chiamata fallisce
+    unsigned int seed;                          // seme del generatore: stessa sequenza a ogni avvio
+    std::string payloadDirectory;               // documenti XML <Vista>.xml
+    std::vector<std::string> models;            // modelli accettati da hplfpsdk_getNewPrinter
+    std::vector<std::string> networkPrinters;   // indirizzi restituiti dalla ricerca in rete
+    std::vector<std::string> unreachable;       // indirizzi che rispondono RESULT_ERROR_CONNECTION
+};
+
+// Contatori della simulazione, per verificare cosa ha fatto il codice misurato.
+struct SimulatorStats
+{
+    unsigned long long calls;           // chiamate verso la stampante (con latenza)
+    unsigned long long failures;        // errori iniettati o stampanti irraggiungibili
+    unsigned long long events;          // callback di sottoscrizione invocate
+    unsigned long long devices;         // IDevice creati
+    long long liveDevices;              // IDevice non ancora scartati
+    long long liveBuffers;              // buffer non ancora liberati con hplfpsdk_deleteBuffer
+};
+
+class Simulator
+{
+public:
+    static Simulator& instance();
+
+    void configure(const SimulatorConfig& config);
+    SimulatorConfig config() const;
+
+    SimulatorStats stats() const;
+    void resetStats();
+
+    // Una chiamata verso la stampante ipAddress: attende la latenza e decide se
+    // fallire. RESULT_OK se la chiamata deve proseguire.
+    HPLFPSDK::Types::Result call(const std::string& ipAddress);
+
+    // Documento della vista (per esempio "InkSystem"): file della cartella dei
+    // payload oppure documento predefinito. false se la vista non e' simulata.
+    bool payload(const std::string& view, std::string& xml) const;
+
+    bool isModelSupported(const char* model) const;
+
+    // Copia xml in un buffer da liberare con hplfpsdk_deleteBuffer.
+    HPLFPSDK::Types::Result respond(const std::string& xml, char** buffer, size_t& length);
+    void release(char** buffer);
+
+    void deviceCreated();
+    void deviceDiscarded();
+    void eventDelivered();
+
+private:
+    Simulator();
+    Simulator(const Simulator&);
+    Simulator& operator=(const Simulator&);
+
+    mutable std::mutex mutex_;
+    SimulatorConfig config_;
+    std::mt19937 random_;
+    mutable std::map<std::string, std::string> payloads_;   // file gia' letti
+
+    std::atomic<unsigned long long> calls_;
+    std::atomic<unsigned long long> failures_;
+    std::atomic<unsigned long long> events_;
+    std::atomic<unsigned long long> devices_;
+    std::atomic<long long> liveDevices_;
+    std::atomic<long long> liveBuffers_;
+};
+
+#endif // SIMULATOR_H
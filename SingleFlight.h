@@ -0,0 +1,93 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "IHplfpsdk.h"
+#include "Metrics.h"
+
+// Una chiamata verso la stampante condivisa tra thread concorrenti: il primo
+// thread la esegue, quelli che arrivano mentre e' in corso ne attendono la
+// fine e ricevono lo stesso Types::Result, errori compresi, invece di
+// ripeterla. Chi arriva dopo la fine esegue una nuova chiamata.
+// Un oggetto per chiave (device, vista, ...): nessuna allocazione.
+class SingleFlight
+{
+public:
+    SingleFlight() : running_(false), generation_(0), result_(HPLFPSDK::Types::RESULT_OK) {}
+
+    template <typename Call>
+    HPLFPSDK::Types::Result run(Call call)
+    {
+        return start(call, NULL);
+    }
+
+    // Come run, ma chi si aggiunge a una chiamata in corso la attende al massimo
+    // fino a deadline e poi riceve RESULT_ERROR_TIMEOUT. La chiamata continua
+    // per gli altri.
+    template <typename Call>
+    HPLFPSDK::Types::Result runUntil(Call call, std::chrono::steady_clock::time_point deadline)
+    {
+        return start(call, &deadline);
+    }
+
+private:
+    SingleFlight(const SingleFlight&);
+    SingleFlight& operator=(const SingleFlight&);
+
+    template <typename Call>
+    HPLFPSDK::Types::Result start(Call& call, const std::chrono::steady_clock::time_point* deadline)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (running_)
+            {
+                unsigned long long generation = generation_;
+                if (deadline == NULL)
+                {
+                    done_.wait(lock, [this, generation] { return generation_ != generation; });
+                }
+                else if (!done_.wait_until(lock, *deadline, [this, generation] { return generation_ != generation; }))
+                {
+                    return HPLFPSDK::Types::RESULT_ERROR_TIMEOUT;
+                }
+                Metrics::instance().increment(METRIC_SINGLE_FLIGHT_SHARED);
+                return result_;
+            }
+            running_ = true;
+        }
+
+        HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_ERROR;
+        try
+        {
+            result = call();
+        }
+        catch (...)
+        {
+            finish(HPLFPSDK::Types::RESULT_ERROR);
+            throw;
+        }
+        finish(result);
+        return result;
+    }
+
+    void finish(HPLFPSDK::Types::Result result)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            result_ = result;
+            running_ = false;
+            generation_++;
+        }
+        done_.notify_all();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable done_;
+    bool running_;
+    unsigned long long generation_;         // chiamate concluse, per riconoscere la fine della propria
+    HPLFPSDK::Types::Result result_;        // risultato dell'ultima chiamata conclusa
+};
+
+#endif // SINGLE_FLIGHT_H
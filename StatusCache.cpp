@@ -0,0 +1,224 @@
+#include "StatusCache.h"
+
+#include "CallbackRegistry.h"
+#include "DepletionForecaster.h"
+#include "Metrics.h"
+#include "TimeSeriesStore.h"
+#include "XmlPullParser.h"
+
+using namespace std;
+
+namespace
+{
+    // Nome dell'elemento radice, saltando dichiarazione, commenti e spazi.
+    string_view rootElement(const char* xml, size_t length)
+    {
+        XmlPullParser parser(xml, length);
+        XmlPullParser::Event event;
+        while ((event = parser.next()) == XmlPullParser::EVENT_TEXT)
+        {
+        }
+        return event == XmlPullParser::EVENT_START_ELEMENT ? parser.name() : string_view();
+    }
+}
+
+atomic<long long> StatusCache::staleAfterMs_(30000);
+
+StatusCache::Slot::Slot()
+    : owner(NULL), kind(STATUS_INK_SYSTEM), subscribed(false), subscriptionId(0), callbackToken(NULL), dirty(true)
+{
+}
+
+StatusCache::StatusCache(HPLFPSDK::IInfoManager* infoManager, const string& ipAddress)
+    : infoManager_(infoManager), ipAddress_(ipAddress)
+{
+    for (int kind = 0; kind < STATUS_KIND_COUNT; kind++)
+    {
+        slots_[kind].owner = this;
+        slots_[kind].kind = (StatusKind)kind;
+    }
+}
+
+StatusCache::~StatusCache()
+{
+    for (int kind = 0; kind < STATUS_KIND_COUNT; kind++)
+    {
+        if (slots_[kind].subscribed)
+        {
+            infoManager_->unsubscribe(slots_[kind].subscriptionId);
+        }
+        // Attende gli eventi ancora in consegna prima di distruggere gli slot
+        if (slots_[kind].callbackToken != NULL)
+        {
+            CallbackRegistry::instance().remove(slots_[kind].callbackToken);
+        }
+    }
+}
+
+void StatusCache::setStaleAfter(chrono::milliseconds window)
+{
+    staleAfterMs_ = window.count();
+}
+
+chrono::milliseconds StatusCache::staleAfter()
+{
+    return chrono::milliseconds(staleAfterMs_.load());
+}
+
+HPLFPSDK::Types::Result StatusCache::get(StatusKind kind, shared_ptr<const string>& xml)
+{
+    Slot& slot = slots_[kind];
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (freshLocked(slot, chrono::steady_clock::now()))
+        {
+            xml = slot.value;
+            Metrics::instance().increment(METRIC_CACHE_HITS);
+            return HPLFPSDK::Types::RESULT_OK;
+        }
+    }
+
+    // I thread che arrivano durante la rilettura ricevono il suo risultato
+    HPLFPSDK::Types::Result result = slot.refreshFlight.run([this, &slot]()
+    {
+        {
+            // Un altro thread potrebbe aver appena riletto la stessa vista
+            lock_guard<mutex> lock(mutex_);
+            if (freshLocked(slot, chrono::steady_clock::now()))
+            {
+                Metrics::instance().increment(METRIC_CACHE_HITS);
+                return HPLFPSDK::Types::RESULT_OK;
+            }
+        }
+        Metrics::instance().increment(METRIC_CACHE_MISSES);
+        subscribe(slot);
+        return refresh(slot);
+    });
+    if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        lock_guard<mutex> lock(mutex_);
+        xml = slot.value;
+    }
+    return result;
+}
+
+bool StatusCache::fresh(StatusKind kind) const
+{
+    lock_guard<mutex> lock(mutex_);
+    return freshLocked(slots_[kind], chrono::steady_clock::now());
+}
+
+bool StatusCache::freshLocked(const Slot& slot, chrono::steady_clock::time_point now) const
+{
+    return slot.value && !slot.dirty && now - slot.updated < staleAfter();
+}
+
+HPLFPSDK::Types::Result StatusCache::refresh(Slot& slot)
+{
+    char* info = NULL;
+    size_t length = 0;
+    MetricTimer timer(METRIC_PHASE_STATUS_QUERY);
+    HPLFPSDK::Types::Result result = timer.stop((infoManager_->*statusQueryInfo(slot.kind).query)(&info, length));
+    shared_ptr<const string> value;
+    if (result == HPLFPSDK::Types::RESULT_OK && info != NULL)
+    {
+        value = make_shared<const string>(info, strnlen(info, length));
+    }
+    if (info != NULL)
+    {
+        hplfpsdk_deleteBuffer(&info);
+    }
+    if (value)
+    {
+        lock_guard<mutex> lock(mutex_);
+        slot.value = value;
+        slot.dirty = false;
+        slot.updated = chrono::steady_clock::now();
+    }
+    if (value)
+    {
+        record(slot.kind, *value);
+    }
+    else if (result == HPLFPSDK::Types::RESULT_OK)
+    {
+        result = HPLFPSDK::Types::RESULT_ERROR_EMPTY_RESPONSE;
+    }
+    return result;
+}
+
+void StatusCache::record(StatusKind kind, const string& xml)
+{
+    vector<SlotLevel> levels;
+    readSlotLevels(kind, xml.data(), xml.size(), levels);
+    if (levels.empty())
+    {
+        return;
+    }
+    const long long time = (long long)chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    DepletionForecaster::instance().update(ipAddress_, kind, time, levels);
+    TimeSeriesStore::instance().recordLevels(ipAddress_, time, levels);
+}
+
+void StatusCache::subscribe(Slot& slot)
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (slot.subscribed)
+        {
+            return;
+        }
+    }
+    CallbackRegistry& registry = CallbackRegistry::instance();
+    void* token = registry.add(&slot);
+    uint32_t subscriptionId = 0;
+    if ((infoManager_->*statusQueryInfo(slot.kind).subscribe)(&StatusCache::onChange, token, &subscriptionId) == HPLFPSDK::Types::RESULT_OK)
+    {
+        lock_guard<mutex> lock(mutex_);
+        slot.subscribed = true;
+        slot.subscriptionId = subscriptionId;
+        slot.callbackToken = token;
+    }
+    else
+    {
+        registry.remove(token);
+    }
+}
+
+void StatusCache::onChange(HPLFPSDK::IInfoManager::InfoEventType, void* userData, uint32_t, const char* newXmlValue, int xmlLength)
+{
+    CallbackRegistry::Call call(userData);
+    if (call.target() == NULL)
+    {
+        // Cache gia' distrutta
+        return;
+    }
+    Slot& slot = *(Slot*)call.target();
+    StatusCache& cache = *slot.owner;
+    Metrics::instance().increment(METRIC_STATUS_EVENTS);
+    if (newXmlValue == NULL || xmlLength <= 0)
+    {
+        return;
+    }
+    shared_ptr<const string> value = make_shared<const string>(newXmlValue, strnlen(newXmlValue, (size_t)xmlLength));
+
+    bool replaced = false;
+    {
+        lock_guard<mutex> lock(cache.mutex_);
+        // L'evento sostituisce il valore solo se contiene l'intera vista (stessa radice);
+        // se riguarda un singolo elemento la vista verra' riletta alla prossima richiesta.
+        replaced = slot.value && rootElement(value->data(), value->size()) == rootElement(slot.value->data(), slot.value->size());
+        if (replaced)
+        {
+            slot.value = value;
+            slot.updated = chrono::steady_clock::now();
+        }
+        else
+        {
+            slot.dirty = true;
+        }
+    }
+    if (replaced)
+    {
+        cache.record(slot.kind, *value);
+    }
+}
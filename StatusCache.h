@@ -0,0 +1,70 @@
+#ifndef STATUS_CACHE_H
+#define STATUS_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "IHplfpsdk.h"
+#include "SingleFlight.h"
+#include "StatusQueries.h"
+
+// Cache dello stato di un IDevice alimentata dalle sottoscrizioni di IInfoManager.
+// Al primo accesso a una vista ci si sottoscrive al suo flusso di eventi; ogni
+// evento aggiorna il valore in memoria, che viene restituito senza interrogare
+// la stampante. Solo se non arrivano eventi per piu' di staleAfter il valore
+// viene riletto con la get corrispondente.
+// I livelli di ogni nuovo documento di inchiostri, testine, manutenzione e
+// raccoglitori vanno allo storico (TimeSeriesStore) e alla previsione di
+// esaurimento (DepletionForecaster), con l'indirizzo della stampante.
+class StatusCache
+{
+public:
+    StatusCache(HPLFPSDK::IInfoManager* infoManager, const std::string& ipAddress);
+    ~StatusCache();
+
+    // Documento XML piu' recente della vista richiesta.
+    HPLFPSDK::Types::Result get(StatusKind kind, std::shared_ptr<const std::string>& xml);
+    // true se get risponderebbe dalla memoria, senza rileggere la vista.
+    bool fresh(StatusKind kind) const;
+
+    // Finestra oltre la quale un valore senza eventi viene riletto (vale per tutte le cache).
+    static void setStaleAfter(std::chrono::milliseconds window);
+    static std::chrono::milliseconds staleAfter();
+
+private:
+    struct Slot
+    {
+        Slot();
+
+        StatusCache* owner;
+        StatusKind kind;
+        SingleFlight refreshFlight;         // una sola rilettura alla volta per vista, condivisa
+        // I campi seguenti sono protetti da StatusCache::mutex_
+        bool subscribed;
+        uint32_t subscriptionId;
+        void* callbackToken;                // userData della sottoscrizione (vedi CallbackRegistry)
+        bool dirty;
+        std::shared_ptr<const std::string> value;
+        std::chrono::steady_clock::time_point updated;
+    };
+
+    StatusCache(const StatusCache&);
+    StatusCache& operator=(const StatusCache&);
+
+    bool freshLocked(const Slot& slot, std::chrono::steady_clock::time_point now) const;
+    HPLFPSDK::Types::Result refresh(Slot& slot);
+    void record(StatusKind kind, const std::string& xml);
+    void subscribe(Slot& slot);
+    static void onChange(HPLFPSDK::IInfoManager::InfoEventType type, void* userData, uint32_t subscriptionId, const char* newXmlValue, int xmlLength);
+
+    static std::atomic<long long> staleAfterMs_;
+
+    HPLFPSDK::IInfoManager* infoManager_;
+    std::string ipAddress_;
+    mutable std::mutex mutex_;
+    Slot slots_[STATUS_KIND_COUNT];
+};
+
+#endif // STATUS_CACHE_H
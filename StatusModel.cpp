@@ -0,0 +1,274 @@
+#include "StatusModel.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    // Solo lettere minuscole in un buffer fisso: "Very Low", "VERY_LOW" e
+    // "VeryLow" diventano "verylow". I testi piu' lunghi vengono troncati.
+    struct Normalized
+    {
+        explicit Normalized(string_view text) : length(0)
+        {
+            for (size_t i = 0; i < text.size() && length < sizeof(buffer); i++)
+            {
+                if (isalpha((unsigned char)text[i]))
+                {
+                    buffer[length++] = (char)tolower((unsigned char)text[i]);
+                }
+            }
+        }
+
+        string_view value() const { return string_view(buffer, length); }
+
+        char buffer[32];
+        size_t length;
+    };
+
+    int digits(string_view text, size_t position, size_t count)
+    {
+        int value = 0;
+        for (size_t i = position; i < position + count; i++)
+        {
+            if (text[i] < '0' || text[i] > '9')
+            {
+                return -1;
+            }
+            value = value * 10 + (text[i] - '0');
+        }
+        return value;
+    }
+
+    // Campi di ogni elemento, letti insieme al primo accesso (vedi XmlElement::texts)
+    enum { INK_COLOR, INK_STATUS, INK_PRESENT, INK_LEVEL, INK_EXPIRATION, INK_WARRANTY, INK_PRODUCT, INK_SERIAL, INK_COUNT };
+
+    const string_view INK_PATHS[INK_COUNT] =
+    {
+        "Color", "MostRelevantStatus", "IsPresent", "LevelPercentage", "ExpirationDate", "Warranty", "ProductNumber", "SerialNumber"
+    };
+
+    enum { HEAD_COLOR, HEAD_STATUS, HEAD_PRESENT, HEAD_WARRANTY, HEAD_PRODUCT, HEAD_SERIAL, HEAD_COUNT };
+
+    const string_view HEAD_PATHS[HEAD_COUNT] =
+    {
+        "Color", "MostRelevantStatus", "IsPresent", "WarrantyStatus", "ProductNumber", "SerialNumber"
+    };
+
+    enum { MAINTENANCE_STATUS, MAINTENANCE_PRESENT, MAINTENANCE_LEVEL, MAINTENANCE_COUNT };
+
+    const string_view MAINTENANCE_PATHS[MAINTENANCE_COUNT] =
+    {
+        "MostRelevantStatus", "IsPresent", "LevelPercentage"
+    };
+
+    template <typename Document>
+    void readLevels(Document& document, vector<SlotLevel>& levels)
+    {
+        for (size_t i = 0; const auto* element = document.at(i); i++)
+        {
+            SlotLevel level;
+            level.id = element->id();
+            level.levelPercent = element->levelPercent();
+            level.state = element->state();
+            levels.push_back(level);
+        }
+    }
+}
+
+SlotState decodeSlotState(string_view status)
+{
+    Normalized normalized(status);
+    string_view value = normalized.value();
+    if (value.empty() || value == "unknown")
+    {
+        return SLOT_STATE_UNKNOWN;
+    }
+    if (value == "ok" || value == "ready")
+    {
+        return SLOT_STATE_OK;
+    }
+    if (value == "verylow")
+    {
+        return SLOT_STATE_VERY_LOW;
+    }
+    if (value == "low")
+    {
+        return SLOT_STATE_LOW;
+    }
+    if (value == "empty" || value == "out")
+    {
+        return SLOT_STATE_EMPTY;
+    }
+    if (value == "missing" || value == "notpresent")
+    {
+        return SLOT_STATE_MISSING;
+    }
+    if (value == "expired")
+    {
+        return SLOT_STATE_EXPIRED;
+    }
+    return SLOT_STATE_ERROR;
+}
+
+WarrantyState decodeWarranty(string_view warranty)
+{
+    Normalized normalized(warranty);
+    string_view value = normalized.value();
+    if (value.find("out") != string_view::npos || value == "no" || value == "false")
+    {
+        return WARRANTY_OUT_WARRANTY;
+    }
+    if (value.find("in") == 0 || value == "yes" || value == "true")
+    {
+        return WARRANTY_IN_WARRANTY;
+    }
+    return WARRANTY_UNKNOWN;
+}
+
+bool decodePresent(string_view present)
+{
+    return Normalized(present).value() != "false";
+}
+
+float decodeLevel(string_view text)
+{
+    char number[32];
+    if (text.empty() || text.size() >= sizeof(number))
+    {
+        return -1.0f;
+    }
+    memcpy(number, text.data(), text.size());
+    number[text.size()] = '\0';
+    return (float)atof(number);
+}
+
+// "2022-03-01" o "2022-03-01T00:00:00" -> 20220301
+int32_t decodeDate(string_view text)
+{
+    if (text.size() < 10 || text[4] != '-' || text[7] != '-')
+    {
+        return 0;
+    }
+    int year = digits(text, 0, 4);
+    int month = digits(text, 5, 2);
+    int day = digits(text, 8, 2);
+    if (year < 0 || month < 0 || day < 0)
+    {
+        return 0;
+    }
+    return year * 10000 + month * 100 + day;
+}
+
+StatusElement::StatusElement(const XmlElement& element, const string_view* paths, size_t count)
+    : element_(element), paths_(paths), count_(count), decoded_(false)
+{
+}
+
+string_view StatusElement::id() const
+{
+    string_view value;
+    element_.attribute("id", value);
+    return value;
+}
+
+string_view StatusElement::field(size_t index) const
+{
+    if (!decoded_)
+    {
+        element_.texts(paths_, fields_, count_);
+        decoded_ = true;
+    }
+    return fields_[index];
+}
+
+const string_view InkSlotStatus::PATH = "InkSystem/InkSlot";
+
+InkSlotStatus::InkSlotStatus(const XmlElement& element)
+    : StatusElement(element, INK_PATHS, INK_COUNT)
+{
+}
+
+string_view InkSlotStatus::color() const { return field(INK_COLOR); }
+string_view InkSlotStatus::status() const { return field(INK_STATUS); }
+SlotState InkSlotStatus::state() const { return decodeSlotState(field(INK_STATUS)); }
+bool InkSlotStatus::present() const { return decodePresent(field(INK_PRESENT)); }
+float InkSlotStatus::levelPercent() const { return decodeLevel(field(INK_LEVEL)); }
+int32_t InkSlotStatus::expirationDate() const { return decodeDate(field(INK_EXPIRATION)); }
+WarrantyState InkSlotStatus::warranty() const { return decodeWarranty(field(INK_WARRANTY)); }
+string_view InkSlotStatus::productNumber() const { return field(INK_PRODUCT); }
+string_view InkSlotStatus::serialNumber() const { return field(INK_SERIAL); }
+
+const string_view PrintheadSlotStatus::PATH = "PrintheadSystem/PrintheadSlot";
+
+PrintheadSlotStatus::PrintheadSlotStatus(const XmlElement& element)
+    : StatusElement(element, HEAD_PATHS, HEAD_COUNT)
+{
+}
+
+string_view PrintheadSlotStatus::color() const { return field(HEAD_COLOR); }
+string_view PrintheadSlotStatus::status() const { return field(HEAD_STATUS); }
+SlotState PrintheadSlotStatus::state() const { return decodeSlotState(field(HEAD_STATUS)); }
+bool PrintheadSlotStatus::present() const { return decodePresent(field(HEAD_PRESENT)); }
+WarrantyState PrintheadSlotStatus::warranty() const { return decodeWarranty(field(HEAD_WARRANTY)); }
+string_view PrintheadSlotStatus::productNumber() const { return field(HEAD_PRODUCT); }
+string_view PrintheadSlotStatus::serialNumber() const { return field(HEAD_SERIAL); }
+
+const string_view MaintenanceCartridgeStatus::PATH = "MaintenanceSystem/MaintenanceCartridge";
+
+MaintenanceCartridgeStatus::MaintenanceCartridgeStatus(const XmlElement& element)
+    : StatusElement(element, MAINTENANCE_PATHS, MAINTENANCE_COUNT)
+{
+}
+
+string_view MaintenanceCartridgeStatus::status() const { return field(MAINTENANCE_STATUS); }
+SlotState MaintenanceCartridgeStatus::state() const { return decodeSlotState(field(MAINTENANCE_STATUS)); }
+bool MaintenanceCartridgeStatus::present() const { return decodePresent(field(MAINTENANCE_PRESENT)); }
+float MaintenanceCartridgeStatus::levelPercent() const { return decodeLevel(field(MAINTENANCE_LEVEL)); }
+
+const string_view WasteCollectorStatus::PATH = "WasteCollectors/WasteCollector";
+
+WasteCollectorStatus::WasteCollectorStatus(const XmlElement& element)
+    : StatusElement(element, MAINTENANCE_PATHS, MAINTENANCE_COUNT)
+{
+}
+
+string_view WasteCollectorStatus::status() const { return field(MAINTENANCE_STATUS); }
+SlotState WasteCollectorStatus::state() const { return decodeSlotState(field(MAINTENANCE_STATUS)); }
+bool WasteCollectorStatus::present() const { return decodePresent(field(MAINTENANCE_PRESENT)); }
+float WasteCollectorStatus::levelPercent() const { return decodeLevel(field(MAINTENANCE_LEVEL)); }
+
+void readSlotLevels(StatusKind kind, const char* xml, size_t length, vector<SlotLevel>& levels)
+{
+    levels.clear();
+    if (kind == STATUS_INK_SYSTEM)
+    {
+        InkSystemStatus ink(xml, length);
+        readLevels(ink, levels);
+    }
+    else if (kind == STATUS_PRINTHEAD_SLOTS)
+    {
+        PrintheadSystemStatus printheads(xml, length);
+        for (size_t i = 0; const PrintheadSlotStatus* slot = printheads.at(i); i++)
+        {
+            SlotLevel level;
+            level.id = slot->id();
+            level.levelPercent = -1.0f;
+            level.state = slot->state();
+            levels.push_back(level);
+        }
+    }
+    else if (kind == STATUS_MAINTENANCE_CARTRIDGES)
+    {
+        MaintenanceSystemStatus maintenance(xml, length);
+        readLevels(maintenance, levels);
+    }
+    else if (kind == STATUS_WASTE_COLLECTORS)
+    {
+        WasteCollectorsStatus collectors(xml, length);
+        readLevels(collectors, levels);
+    }
+}
@@ -0,0 +1,210 @@
+#ifndef STATUS_MODEL_H
+#define STATUS_MODEL_H
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "StatusQueries.h"
+#include "StatusRecords.h"
+#include "XmlPullParser.h"
+
+// Modello tipizzato delle viste di stato costruito direttamente sul documento
+// dell'SDK, senza copiarlo: i campi sono string_view sul documento, che resta
+// vivo finche' vive l'oggetto (shared_ptr della cache) oppure, con il
+// costruttore (xml, length), finche' lo garantisce il chiamante.
+//
+// Tutto viene letto solo quando serve: gli slot vengono cercati nel documento
+// fino a quello richiesto e i campi di uno slot vengono estratti, in una sola
+// passata sul suo elemento, al primo accesso. Chi legge il livello del primo
+// inchiostro non paga la lettura degli altri slot.
+//
+// Gli oggetti non sono thread-safe: uno per thread, come i buffer dell'SDK.
+
+// Conversione dei testi della stampante nei valori dei record binari.
+SlotState decodeSlotState(std::string_view status);
+WarrantyState decodeWarranty(std::string_view warranty);
+bool decodePresent(std::string_view present);           // true se manca il campo
+float decodeLevel(std::string_view level);              // -1 se non disponibile
+int32_t decodeDate(std::string_view date);              // aaaammgg, 0 se non disponibile
+
+// Elemento di una vista (slot, cartuccia...) con i campi letti al primo accesso.
+class StatusElement
+{
+public:
+    std::string_view id() const;
+
+protected:
+    StatusElement(const XmlElement& element, const std::string_view* paths, size_t count);
+
+    std::string_view field(size_t index) const;
+
+private:
+    XmlElement element_;
+    const std::string_view* paths_;
+    size_t count_;
+    mutable bool decoded_;
+    mutable std::string_view fields_[XmlElement::MAX_TEXTS];
+};
+
+class InkSlotStatus : public StatusElement
+{
+public:
+    static const std::string_view PATH;
+
+    explicit InkSlotStatus(const XmlElement& element);
+
+    std::string_view color() const;
+    std::string_view status() const;            // MostRelevantStatus
+    SlotState state() const;
+    bool present() const;
+    float levelPercent() const;
+    int32_t expirationDate() const;
+    WarrantyState warranty() const;
+    std::string_view productNumber() const;
+    std::string_view serialNumber() const;
+};
+
+class PrintheadSlotStatus : public StatusElement
+{
+public:
+    static const std::string_view PATH;
+
+    explicit PrintheadSlotStatus(const XmlElement& element);
+
+    std::string_view color() const;
+    std::string_view status() const;
+    SlotState state() const;
+    bool present() const;
+    WarrantyState warranty() const;
+    std::string_view productNumber() const;
+    std::string_view serialNumber() const;
+};
+
+class MaintenanceCartridgeStatus : public StatusElement
+{
+public:
+    static const std::string_view PATH;
+
+    explicit MaintenanceCartridgeStatus(const XmlElement& element);
+
+    std::string_view status() const;
+    SlotState state() const;
+    bool present() const;
+    float levelPercent() const;
+};
+
+class WasteCollectorStatus : public StatusElement
+{
+public:
+    static const std::string_view PATH;
+
+    explicit WasteCollectorStatus(const XmlElement& element);
+
+    std::string_view status() const;
+    SlotState state() const;
+    bool present() const;
+    float levelPercent() const;     // riempimento: 100 = pieno
+};
+
+// Documento di una vista: sequenza di Element cercati man mano che servono.
+template <typename Element>
+class StatusDocument
+{
+public:
+    explicit StatusDocument(const std::shared_ptr<const std::string>& xml)
+        : xml_(xml), parser_(xml ? xml->data() : "", xml ? xml->size() : 0), path_(Element::PATH), complete_(false)
+    {
+    }
+
+    StatusDocument(const char* xml, size_t length)
+        : parser_(xml != NULL ? xml : "", xml != NULL ? length : 0), path_(Element::PATH), complete_(false)
+    {
+    }
+
+    // Numero di elementi: legge tutto il documento.
+    size_t size()
+    {
+        while (locateNext())
+        {
+        }
+        return elements_.size();
+    }
+
+    // Elemento index, NULL se il documento ne contiene meno.
+    const Element* at(size_t index)
+    {
+        while (elements_.size() <= index && locateNext())
+        {
+        }
+        return index < elements_.size() ? &elements_[index] : NULL;
+    }
+
+    // Elemento con l'attributo id indicato, NULL se non c'e'.
+    const Element* find(std::string_view id)
+    {
+        for (size_t i = 0; ; i++)
+        {
+            const Element* element = at(i);
+            if (element == NULL || element->id() == id)
+            {
+                return element;
+            }
+        }
+    }
+
+private:
+    StatusDocument(const StatusDocument&);
+    StatusDocument& operator=(const StatusDocument&);
+
+    bool locateNext()
+    {
+        while (!complete_)
+        {
+            XmlPullParser::Event event = parser_.next();
+            if (event == XmlPullParser::EVENT_END_DOCUMENT || event == XmlPullParser::EVENT_ERROR)
+            {
+                complete_ = true;
+                break;
+            }
+            if (event != XmlPullParser::EVENT_START_ELEMENT || !path_.enter(parser_.depth(), parser_.name()))
+            {
+                continue;
+            }
+            std::string_view name = parser_.name();
+            std::string_view attributes = parser_.attributes();
+            std::string_view body;
+            complete_ = !parser_.skipElement(&body);
+            // Il deque non sposta gli elementi gia' restituiti da at()
+            elements_.push_back(Element(XmlElement(name, attributes, body)));
+            return true;
+        }
+        return false;
+    }
+
+    std::shared_ptr<const std::string> xml_;
+    XmlPullParser parser_;
+    XmlPath path_;
+    std::deque<Element> elements_;
+    bool complete_;
+};
+
+typedef StatusDocument<InkSlotStatus> InkSystemStatus;
+typedef StatusDocument<PrintheadSlotStatus> PrintheadSystemStatus;
+typedef StatusDocument<MaintenanceCartridgeStatus> MaintenanceSystemStatus;
+typedef StatusDocument<WasteCollectorStatus> WasteCollectorsStatus;
+
+// Livello e stato di uno slot, comuni a tutte le viste con consumabili.
+struct SlotLevel
+{
+    std::string_view id;
+    float levelPercent;     // -1 se la vista non ha livelli (testine) o non e' disponibile
+    SlotState state;
+};
+
+// Slot della vista kind (inchiostri, testine, manutenzione, raccoglitori);
+// nessuno per le altre viste. Gli id sono viste su xml.
+void readSlotLevels(StatusKind kind, const char* xml, size_t length, std::vector<SlotLevel>& levels);
+
+#endif // STATUS_MODEL_H
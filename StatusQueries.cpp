@@ -0,0 +1,22 @@
+#include "StatusQueries.h"
+
+namespace
+{
+    typedef HPLFPSDK::IInfoManager Info;
+
+    const StatusQueryInfo STATUS_QUERIES[STATUS_KIND_COUNT] =
+    {
+        { STATUS_INK_SYSTEM,              "InkSystem",              &Info::getInkSystemStatus,              &Info::subscribeToInkSystemStatus,              Info::EVENT_INK_SLOT_GROUP_STATUS },
+        { STATUS_PRINTHEAD_SLOTS,         "PrintheadSlots",         &Info::getPrintheadSlotsStatus,         &Info::subscribeToPrintheadSlotsStatus,         Info::EVENT_PRINTHEAD_SLOT_STATUS },
+        { STATUS_MAINTENANCE_CARTRIDGES,  "MaintenanceCartridges",  &Info::getMaintenanceCartridgesStatus,  &Info::subscribeToMaintenanceCartridgesStatus,  Info::EVENT_MAINTENANCE_CARTRIDGE_STATUS },
+        { STATUS_LIQUID_TANKS,            "LiquidTanks",            &Info::getLiquidTanksStatus,            &Info::subscribeToLiquidTanksStatus,            Info::EVENT_LIQUID_TANK_STATUS },
+        { STATUS_WASTE_COLLECTORS,        "WasteCollectors",        &Info::getWasteCollectorsStatus,        &Info::subscribeToWasteCollectorsStatus,        Info::EVENT_WASTE_COLLECTOR_STATUS },
+        { STATUS_CONDENSATION_COLLECTORS, "CondensationCollectors", &Info::getCondensationCollectorsStatus, &Info::subscribeToCondensationCollectorsStatus, Info::EVENT_CONDENSATION_COLLECTOR_STATUS },
+        { STATUS_AIRFLOWS_KITS,           "AirflowsKits",           &Info::getAirflowsKitsStatus,           &Info::subscribeToAirflowsKitsStatus,           Info::EVENT_AIRFLOWS_KIT_STATUS }
+    };
+}
+
+const StatusQueryInfo& statusQueryInfo(StatusKind kind)
+{
+    return STATUS_QUERIES[kind];
+}
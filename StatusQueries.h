@@ -0,0 +1,33 @@
+#ifndef STATUS_QUERIES_H
+#define STATUS_QUERIES_H
+
+#include "IHplfpsdk.h"
+
+// Le viste di stato di IInfoManager usate dal wrapper.
+enum StatusKind
+{
+    STATUS_INK_SYSTEM,
+    STATUS_PRINTHEAD_SLOTS,
+    STATUS_MAINTENANCE_CARTRIDGES,
+    STATUS_LIQUID_TANKS,
+    STATUS_WASTE_COLLECTORS,
+    STATUS_CONDENSATION_COLLECTORS,
+    STATUS_AIRFLOWS_KITS,
+    STATUS_KIND_COUNT
+};
+
+typedef HPLFPSDK::Types::Result (HPLFPSDK::IInfoManager::*StatusQuery)(char**, size_t&);
+typedef HPLFPSDK::Types::Result (HPLFPSDK::IInfoManager::*StatusSubscribe)(HPLFPSDK::IInfoManager::onChangeCallback, void*, uint32_t*);
+
+struct StatusQueryInfo
+{
+    StatusKind kind;
+    const char* name;       // nome usato nei documenti prodotti dal wrapper
+    StatusQuery query;
+    StatusSubscribe subscribe;
+    HPLFPSDK::IInfoManager::InfoEventType eventType;
+};
+
+const StatusQueryInfo& statusQueryInfo(StatusKind kind);
+
+#endif // STATUS_QUERIES_H
@@ -0,0 +1,89 @@
+#include "StatusRecords.h"
+
+#include <cstring>
+#include "StatusModel.h"
+
+using namespace std;
+
+namespace
+{
+    void copyField(char* field, size_t size, string_view value)
+    {
+        size_t length = value.size() < size - 1 ? value.size() : size - 1;
+        memcpy(field, value.data(), length);
+        memset(field + length, 0, size - length);
+    }
+
+    void fill(InkSlotRecord& record, const InkSlotStatus& slot)
+    {
+        copyField(record.id, sizeof(record.id), slot.id());
+        copyField(record.color, sizeof(record.color), slot.color());
+        copyField(record.status, sizeof(record.status), slot.status());
+        record.state = slot.state();
+        record.present = slot.present() ? 1 : 0;
+        record.levelPercent = slot.levelPercent();
+        record.expirationDate = slot.expirationDate();
+    }
+
+    void fill(PrintheadSlotRecord& record, const PrintheadSlotStatus& slot)
+    {
+        copyField(record.id, sizeof(record.id), slot.id());
+        copyField(record.color, sizeof(record.color), slot.color());
+        copyField(record.status, sizeof(record.status), slot.status());
+        record.state = slot.state();
+        record.present = slot.present() ? 1 : 0;
+        record.warranty = slot.warranty();
+        record.reserved = 0;
+    }
+
+    void fill(MaintenanceCartridgeRecord& record, const MaintenanceCartridgeStatus& cartridge)
+    {
+        copyField(record.id, sizeof(record.id), cartridge.id());
+        copyField(record.status, sizeof(record.status), cartridge.status());
+        record.state = cartridge.state();
+        record.present = cartridge.present() ? 1 : 0;
+        record.levelPercent = cartridge.levelPercent();
+        record.reserved = 0;
+    }
+
+    template <typename Record, typename Element>
+    void build(StatusKind kind, const char* xml, size_t length, string& block)
+    {
+        StatusRecordHeader header;
+        header.version = STATUS_RECORD_VERSION;
+        header.kind = (uint16_t)kind;
+        header.recordSize = sizeof(Record);
+        header.count = 0;
+        block.assign(sizeof(header), '\0');
+
+        StatusDocument<Element> document(xml, length);
+        for (const Element* element = document.at(0); element != NULL; element = document.at(header.count))
+        {
+            Record record;
+            memset(&record, 0, sizeof(record));
+            fill(record, *element);
+            block.append((const char*)&record, sizeof(record));
+            header.count++;
+        }
+        header.size = (uint32_t)block.size();
+        memcpy(&block[0], &header, sizeof(header));
+    }
+}
+
+HPLFPSDK::Types::Result buildStatusRecords(StatusKind kind, const char* xml, size_t length, string& block)
+{
+    switch (kind)
+    {
+    case STATUS_INK_SYSTEM:
+        build<InkSlotRecord, InkSlotStatus>(kind, xml, length, block);
+        return HPLFPSDK::Types::RESULT_OK;
+    case STATUS_PRINTHEAD_SLOTS:
+        build<PrintheadSlotRecord, PrintheadSlotStatus>(kind, xml, length, block);
+        return HPLFPSDK::Types::RESULT_OK;
+    case STATUS_MAINTENANCE_CARTRIDGES:
+        build<MaintenanceCartridgeRecord, MaintenanceCartridgeStatus>(kind, xml, length, block);
+        return HPLFPSDK::Types::RESULT_OK;
+    default:
+        return HPLFPSDK::Types::RESULT_NOT_SUPPORTED;
+    }
+}
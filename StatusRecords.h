@@ -0,0 +1,93 @@
+#ifndef STATUS_RECORDS_H
+#define STATUS_RECORDS_H
+
+#include <stdint.h>
+#include <string>
+#include "IHplfpsdk.h"
+#include "StatusQueries.h"
+
+// Record binari a layout fisso per passare lo stato dei consumabili all'host
+// senza XML. Tutti i tipi sono POD con campi allineati naturalmente, senza
+// puntatori: possono essere mappati 1:1 da P/Invoke (struct blittable).
+//
+// Un blocco e' formato da uno StatusRecordHeader seguito da count record
+// di recordSize byte. Le versioni successive potranno solo aggiungere campi
+// in coda ai record: il chiamante usa recordSize per scorrerli.
+
+#define STATUS_RECORD_VERSION 1
+
+#define STATUS_RECORD_ID_SIZE     32
+#define STATUS_RECORD_COLOR_SIZE  24
+#define STATUS_RECORD_STATUS_SIZE 24
+
+enum SlotState
+{
+    SLOT_STATE_UNKNOWN  = 0,
+    SLOT_STATE_OK       = 1,
+    SLOT_STATE_LOW      = 2,
+    SLOT_STATE_VERY_LOW = 3,
+    SLOT_STATE_EMPTY    = 4,
+    SLOT_STATE_MISSING  = 5,
+    SLOT_STATE_EXPIRED  = 6,
+    SLOT_STATE_ERROR    = 7
+};
+
+enum WarrantyState
+{
+    WARRANTY_UNKNOWN      = 0,
+    WARRANTY_IN_WARRANTY  = 1,
+    WARRANTY_OUT_WARRANTY = 2
+};
+
+struct StatusRecordHeader
+{
+    uint32_t size;          // byte dell'intero blocco, header compreso
+    uint16_t version;       // STATUS_RECORD_VERSION
+    uint16_t kind;          // StatusKind
+    uint32_t recordSize;    // byte di ogni record
+    uint32_t count;         // numero di record
+};
+
+struct InkSlotRecord
+{
+    char id[STATUS_RECORD_ID_SIZE];
+    char color[STATUS_RECORD_COLOR_SIZE];
+    char status[STATUS_RECORD_STATUS_SIZE];   // MostRelevantStatus come riportato dalla stampante
+    int32_t state;                            // SlotState
+    int32_t present;                          // 1 se installata
+    float levelPercent;                       // -1 se non disponibile
+    int32_t expirationDate;                   // aaaammgg, 0 se non disponibile
+};
+
+struct PrintheadSlotRecord
+{
+    char id[STATUS_RECORD_ID_SIZE];
+    char color[STATUS_RECORD_COLOR_SIZE];
+    char status[STATUS_RECORD_STATUS_SIZE];
+    int32_t state;                            // SlotState
+    int32_t present;
+    int32_t warranty;                         // WarrantyState
+    int32_t reserved;
+};
+
+struct MaintenanceCartridgeRecord
+{
+    char id[STATUS_RECORD_ID_SIZE];
+    char status[STATUS_RECORD_STATUS_SIZE];
+    int32_t state;                            // SlotState
+    int32_t present;
+    float levelPercent;                       // -1 se non disponibile
+    int32_t reserved;
+};
+
+static_assert(sizeof(StatusRecordHeader) == 16, "StatusRecordHeader layout");
+static_assert(sizeof(InkSlotRecord) == 96, "InkSlotRecord layout");
+static_assert(sizeof(PrintheadSlotRecord) == 96, "PrintheadSlotRecord layout");
+static_assert(sizeof(MaintenanceCartridgeRecord) == 72, "MaintenanceCartridgeRecord layout");
+
+// Converte il documento XML di una vista nel blocco binario corrispondente.
+// Supporta STATUS_INK_SYSTEM, STATUS_PRINTHEAD_SLOTS e STATUS_MAINTENANCE_CARTRIDGES;
+// per le altre viste restituisce RESULT_NOT_SUPPORTED.
+HPLFPSDK::Types::Result buildStatusRecords(StatusKind kind, const char* xml, size_t length, std::string& block);
+
+#endif // STATUS_RECORDS_H
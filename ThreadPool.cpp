@@ -0,0 +1,70 @@
+#include "ThreadPool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(size_t threads)
+    : stopping_(false)
+{
+    if (threads == 0)
+    {
+        threads = 1;
+    }
+    threads_.reserve(threads);
+    for (size_t i = 0; i < threads; i++)
+    {
+        threads_.push_back(thread(&ThreadPool::run, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+    for (size_t i = 0; i < threads_.size(); i++)
+    {
+        threads_[i].join();
+    }
+}
+
+void ThreadPool::post(function<void()> task)
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    available_.notify_one();
+}
+
+size_t ThreadPool::size() const
+{
+    return threads_.size();
+}
+
+void ThreadPool::run()
+{
+    for (;;)
+    {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(mutex_);
+            available_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+            {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        try
+        {
+            task();
+        }
+        catch (exception)
+        {
+            // Un task che fallisce non deve fermare il thread
+        }
+    }
+}
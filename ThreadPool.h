@@ -0,0 +1,35 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool di thread di dimensione fissa con coda FIFO.
+// Il distruttore esegue i task ancora in coda e attende la fine dei thread.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    void post(std::function<void()> task);
+    size_t size() const;
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::deque<std::function<void()> > tasks_;
+    bool stopping_;
+    std::vector<std::thread> threads_;
+};
+
+#endif // THREAD_POOL_H
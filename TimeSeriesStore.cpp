@@ -0,0 +1,678 @@
+#include "TimeSeriesStore.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "XmlUtil.h"
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[8] = { 'H', 'P', 'S', 'D', 'K', 'T', 'S', '1' };
+    const uint32_t NO_WINDOW = 0xFFFFFFFF;
+
+    // Bit massimi di un punto: tempo "1111" + 64, valore "11" + 5 + 6 + 64
+    const uint64_t MAX_POINT_BITS = 145;
+
+    // Intestazione di un segmento, seguita dai bit dei punti. Lo stato del
+    // codificatore permette di riprendere le scritture dopo un riavvio.
+    struct SegmentHeader
+    {
+        char magic[8];
+        uint32_t sequence;      // posizione del segmento nella serie
+        uint32_t count;         // punti scritti
+        uint32_t leading;       // finestra dell'ultimo XOR, NO_WINDOW se nessuna
+        uint32_t trailing;
+        uint64_t bits;          // bit usati dopo l'intestazione
+        int64_t firstTime;
+        int64_t lastTime;
+        int64_t lastDelta;
+        uint64_t lastValue;     // bit del double
+        char key[128];
+    };
+
+    // Scrive i bit dal piu' significativo. Ogni bit viene impostato, non solo
+    // acceso: dopo un'interruzione i bit oltre header.bits possono essere sporchi.
+    struct BitWriter
+    {
+        BitWriter(unsigned char* data, uint64_t position) : data(data), position(position) {}
+
+        void write(uint64_t value, int count)
+        {
+            while (count > 0)
+            {
+                int offset = (int)(position & 7);
+                int take = min(8 - offset, count);
+                int shift = 8 - offset - take;
+                unsigned int bits = (unsigned int)(value >> (count - take)) & ((1u << take) - 1);
+                unsigned char mask = (unsigned char)(((1u << take) - 1) << shift);
+                unsigned char& byte = data[position >> 3];
+                byte = (unsigned char)((byte & ~mask) | (bits << shift));
+                position += take;
+                count -= take;
+            }
+        }
+
+        unsigned char* data;
+        uint64_t position;
+    };
+
+    struct BitReader
+    {
+        BitReader(const unsigned char* data) : data(data), position(0) {}
+
+        uint64_t read(int count)
+        {
+            uint64_t value = 0;
+            while (count > 0)
+            {
+                int offset = (int)(position & 7);
+                int take = min(8 - offset, count);
+                unsigned int bits = (data[position >> 3] >> (8 - offset - take)) & ((1u << take) - 1);
+                value = (value << take) | bits;
+                position += take;
+                count -= take;
+            }
+            return value;
+        }
+
+        int64_t readSigned(int count)
+        {
+            uint64_t value = read(count);
+            if (value & (1ULL << (count - 1)))
+            {
+                value |= ~0ULL << count;
+            }
+            return (int64_t)value;
+        }
+
+        const unsigned char* data;
+        uint64_t position;
+    };
+
+    bool fits(int64_t value, int bits)
+    {
+        return value >= -(1LL << (bits - 1)) && value < (1LL << (bits - 1));
+    }
+
+    int leadingZeros(uint64_t value)
+    {
+        int count = 0;
+        while (count < 64 && (value & (1ULL << (63 - count))) == 0)
+        {
+            count++;
+        }
+        return count;
+    }
+
+    int trailingZeros(uint64_t value)
+    {
+        int count = 0;
+        while (count < 64 && (value & (1ULL << count)) == 0)
+        {
+            count++;
+        }
+        return count;
+    }
+
+    uint64_t doubleBits(double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    double bitsDouble(uint64_t bits)
+    {
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Differenza tra l'intervallo di questo punto e quello del precedente.
+    void writeTime(BitWriter& writer, int64_t deltaOfDelta)
+    {
+        if (deltaOfDelta == 0)
+        {
+            writer.write(0, 1);
+        }
+        else if (fits(deltaOfDelta, 14))
+        {
+            writer.write(2, 2);
+            writer.write((uint64_t)deltaOfDelta, 14);
+        }
+        else if (fits(deltaOfDelta, 20))
+        {
+            writer.write(6, 3);
+            writer.write((uint64_t)deltaOfDelta, 20);
+        }
+        else if (fits(deltaOfDelta, 32))
+        {
+            writer.write(14, 4);
+            writer.write((uint64_t)deltaOfDelta, 32);
+        }
+        else
+        {
+            writer.write(15, 4);
+            writer.write((uint64_t)deltaOfDelta, 64);
+        }
+    }
+
+    int64_t readTime(BitReader& reader)
+    {
+        if (reader.read(1) == 0)
+        {
+            return 0;
+        }
+        if (reader.read(1) == 0)
+        {
+            return reader.readSigned(14);
+        }
+        if (reader.read(1) == 0)
+        {
+            return reader.readSigned(20);
+        }
+        if (reader.read(1) == 0)
+        {
+            return reader.readSigned(32);
+        }
+        return (int64_t)reader.read(64);
+    }
+
+    // XOR con il valore precedente: "0" se uguale, "10" e i bit significativi se
+    // stanno nella finestra precedente, "11" con una finestra nuova altrimenti.
+    void writeValue(BitWriter& writer, SegmentHeader& header, uint64_t value)
+    {
+        uint64_t xorValue = value ^ header.lastValue;
+        if (xorValue == 0)
+        {
+            writer.write(0, 1);
+            return;
+        }
+        uint32_t leading = (uint32_t)min(leadingZeros(xorValue), 31);
+        uint32_t trailing = (uint32_t)trailingZeros(xorValue);
+        if (header.leading != NO_WINDOW && leading >= header.leading && trailing >= header.trailing)
+        {
+            writer.write(2, 2);
+            writer.write(xorValue >> header.trailing, 64 - header.leading - header.trailing);
+            return;
+        }
+        uint32_t meaningful = 64 - leading - trailing;
+        writer.write(3, 2);
+        writer.write(leading, 5);
+        writer.write(meaningful & 63, 6);      // 64 diventa 0
+        writer.write(xorValue >> trailing, meaningful);
+        header.leading = leading;
+        header.trailing = trailing;
+    }
+
+    string defaultDirectory()
+    {
+        const char* path = getenv("HPSDK_HISTORY_DIR");
+        return path != NULL ? path : "";
+    }
+
+    const long long MS_PER_HOUR = 3600LL * 1000;
+
+    long long defaultRetentionMs()
+    {
+        const char* days = getenv("HPSDK_HISTORY_RETENTION_DAYS");
+        long long value = days != NULL ? atoll(days) : -1;
+        return (value >= 0 ? value : TimeSeriesStore::DEFAULT_RETENTION_DAYS) * 24 * MS_PER_HOUR;
+    }
+
+    long long nowMs()
+    {
+        return (long long)chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Nome dei file della serie: hash FNV-1a della chiave, che resta nell'intestazione.
+    string segmentName(const string& key, uint32_t sequence)
+    {
+        unsigned long long hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < key.size(); i++)
+        {
+            hash = (hash ^ (unsigned char)key[i]) * 1099511628211ULL;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "%016llx-%u.seg", hash, sequence);
+        return name;
+    }
+
+    void appendDouble(string& xml, double value)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%g", value);
+        xml += text;
+    }
+}
+
+TimeSeriesStore::TimeSeriesStore()
+    : directory_(defaultDirectory()), retentionMs_(defaultRetentionMs()), pending_(0), writer_(1)
+{
+    loadLocked();
+}
+
+TimeSeriesStore& TimeSeriesStore::instance()
+{
+    static TimeSeriesStore* store = new TimeSeriesStore();
+    return *store;
+}
+
+void TimeSeriesStore::setDirectory(const string& directory)
+{
+    lock_guard<mutex> lock(mutex_);
+    directory_ = directory;
+    loadLocked();
+}
+
+void TimeSeriesStore::setRetention(chrono::hours retention)
+{
+    retentionMs_ = (long long)retention.count() * MS_PER_HOUR;
+}
+
+void TimeSeriesStore::loadLocked()
+{
+    series_.clear();
+    if (directory_.empty())
+    {
+        return;
+    }
+    error_code error;
+    for (filesystem::directory_iterator it(directory_, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->path().extension() != ".seg")
+        {
+            continue;
+        }
+        SegmentHeader header;
+        ifstream file(it->path(), ios::binary);
+        if (!file.read((char*)&header, sizeof(header)) || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+            || memchr(header.key, '\0', sizeof(header.key)) == NULL)
+        {
+            continue;
+        }
+        unsigned long long bytes = (unsigned long long)filesystem::file_size(it->path(), error);
+        if (error || bytes < sizeof(header) + (header.bits + 7) / 8)
+        {
+            error.clear();
+            continue;
+        }
+        Segment segment;
+        segment.path = it->path().string();
+        segment.sequence = header.sequence;
+        segment.count = header.count;
+        segment.firstTime = header.firstTime;
+        segment.lastTime = header.lastTime;
+        segment.bytes = bytes;
+        shared_ptr<Series>& series = series_[header.key];
+        if (!series)
+        {
+            series = make_shared<Series>();
+        }
+        series->segments.push_back(segment);
+    }
+    for (map<string, shared_ptr<Series> >::iterator it = series_.begin(); it != series_.end(); ++it)
+    {
+        vector<Segment>& segments = it->second->segments;
+        sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) { return a.sequence < b.sequence; });
+        // Le serie non ancora condivise: il lock della serie non serve
+        pruneLocked(*it->second);
+    }
+}
+
+void TimeSeriesStore::pruneLocked(Series& series)
+{
+    const long long retention = retentionMs_;
+    if (retention <= 0)
+    {
+        return;
+    }
+    // L'ultimo segmento riceve i punti e non viene mai cancellato
+    const long long cutoff = nowMs() - retention;
+    while (series.segments.size() > 1 && series.segments.front().lastTime < cutoff)
+    {
+        error_code error;
+        if (!filesystem::remove(series.segments.front().path, error) && error)
+        {
+            return;
+        }
+        series.segments.erase(series.segments.begin());
+    }
+}
+
+bool TimeSeriesStore::openActiveLocked(const string& directory, const string& key, Series& series, size_t required)
+{
+    if (!series.segments.empty())
+    {
+        Segment& last = series.segments.back();
+        if (!series.active.isOpen() && !series.active.open(last.path, 0, true))
+        {
+            return false;
+        }
+        const SegmentHeader& header = *(const SegmentHeader*)series.active.data();
+        size_t needed = sizeof(SegmentHeader) + (size_t)((header.bits + required + 7) / 8);
+        if (needed <= series.active.size())
+        {
+            return true;
+        }
+        if (needed <= MAX_SEGMENT_SIZE)
+        {
+            size_t size = series.active.size();
+            while (size < needed)
+            {
+                size *= 2;
+            }
+            size = min(size, (size_t)MAX_SEGMENT_SIZE);
+            if (!series.active.open(last.path, size, true))
+            {
+                return false;
+            }
+            last.bytes = size;
+            return true;
+        }
+        series.active.close();
+    }
+
+    // Nuovo segmento
+    error_code error;
+    filesystem::create_directories(directory, error);
+    uint32_t sequence = series.segments.empty() ? 0 : series.segments.back().sequence + 1;
+    string path = (filesystem::path(directory) / segmentName(key, sequence)).string();
+    if (!series.active.open(path, MIN_SEGMENT_SIZE, true) || series.active.size() < sizeof(SegmentHeader))
+    {
+        series.active.close();
+        return false;
+    }
+    SegmentHeader& header = *(SegmentHeader*)series.active.data();
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    memcpy(header.key, key.data(), key.size());
+    header.sequence = sequence;
+    header.leading = NO_WINDOW;
+
+    Segment segment;
+    segment.path = path;
+    segment.sequence = sequence;
+    segment.count = 0;
+    segment.firstTime = 0;
+    segment.lastTime = 0;
+    segment.bytes = series.active.size();
+    series.segments.push_back(segment);
+    pruneLocked(series);
+    return true;
+}
+
+bool TimeSeriesStore::append(const string& key, long long time, double value)
+{
+    if (key.empty() || key.size() >= sizeof(SegmentHeader().key))
+    {
+        return false;
+    }
+    shared_ptr<Series> series;
+    string directory;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (directory_.empty())
+        {
+            return false;
+        }
+        shared_ptr<Series>& slot = series_[key];
+        if (!slot)
+        {
+            slot = make_shared<Series>();
+        }
+        series = slot;
+        directory = directory_;
+    }
+    lock_guard<mutex> lock(series->mutex);
+    if (!openActiveLocked(directory, key, *series, MAX_POINT_BITS))
+    {
+        return false;
+    }
+
+    SegmentHeader& header = *(SegmentHeader*)series->active.data();
+    BitWriter writer(series->active.data() + sizeof(SegmentHeader), header.bits);
+    uint64_t bits = doubleBits(value);
+    if (header.count == 0)
+    {
+        writer.write((uint64_t)time, 64);
+        writer.write(bits, 64);
+        header.firstTime = time;
+        header.lastDelta = 0;
+    }
+    else
+    {
+        time = max(time, (long long)header.lastTime);
+        int64_t delta = time - header.lastTime;
+        writeTime(writer, delta - header.lastDelta);
+        writeValue(writer, header, bits);
+        header.lastDelta = delta;
+    }
+    header.lastTime = time;
+    header.lastValue = bits;
+    // Prima i bit e solo dopo il conteggio: un punto a meta' non viene mai letto
+    header.bits = writer.position;
+    header.count++;
+
+    Segment& segment = series->segments.back();
+    segment.count = header.count;
+    segment.firstTime = header.firstTime;
+    segment.lastTime = header.lastTime;
+    return true;
+}
+
+void TimeSeriesStore::decode(const unsigned char* data, size_t size, long long from, long long to, vector<HistoryPoint>& points)
+{
+    if (size < sizeof(SegmentHeader))
+    {
+        return;
+    }
+    const SegmentHeader& header = *(const SegmentHeader*)data;
+    if (header.count == 0 || sizeof(SegmentHeader) + (header.bits + 7) / 8 > size)
+    {
+        return;
+    }
+    BitReader reader(data + sizeof(SegmentHeader));
+    int64_t time = (int64_t)reader.read(64);
+    uint64_t value = reader.read(64);
+    int64_t delta = 0;
+    uint32_t leading = 0;
+    uint32_t trailing = 0;
+    for (uint32_t i = 0; ; )
+    {
+        if (time > to)
+        {
+            return;
+        }
+        if (time >= from)
+        {
+            HistoryPoint point;
+            point.time = time;
+            point.value = bitsDouble(value);
+            points.push_back(point);
+        }
+        if (++i == header.count)
+        {
+            return;
+        }
+        delta += readTime(reader);
+        time += delta;
+        if (reader.read(1) == 0)
+        {
+            continue;
+        }
+        if (reader.read(1) == 1)
+        {
+            leading = (uint32_t)reader.read(5);
+            uint32_t meaningful = (uint32_t)reader.read(6);
+            trailing = 64 - leading - (meaningful == 0 ? 64 : meaningful);
+        }
+        value ^= reader.read(64 - leading - trailing) << trailing;
+    }
+}
+
+void TimeSeriesStore::query(const string& key, long long from, long long to, vector<HistoryPoint>& points)
+{
+    points.clear();
+    shared_ptr<Series> series;
+    {
+        lock_guard<mutex> lock(mutex_);
+        map<string, shared_ptr<Series> >::const_iterator it = series_.find(key);
+        if (it == series_.end())
+        {
+            return;
+        }
+        series = it->second;
+    }
+
+    // Sotto il lock della serie solo la scelta dei segmenti e la copia dei bit
+    // gia' scritti di quello attivo; i segmenti chiusi non cambiano piu'
+    vector<string> paths;
+    string active;
+    {
+        lock_guard<mutex> lock(series->mutex);
+        for (size_t i = 0; i < series->segments.size(); i++)
+        {
+            const Segment& segment = series->segments[i];
+            if (segment.count == 0 || segment.lastTime < from || segment.firstTime > to)
+            {
+                continue;
+            }
+            if (i + 1 == series->segments.size() && series->active.isOpen())
+            {
+                const SegmentHeader& header = *(const SegmentHeader*)series->active.data();
+                size_t used = min(series->active.size(), sizeof(SegmentHeader) + (size_t)((header.bits + 7) / 8));
+                active.assign((const char*)series->active.data(), used);
+                continue;
+            }
+            paths.push_back(segment.path);
+        }
+    }
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        MappedFile file;
+        if (file.open(paths[i], 0, false))
+        {
+            decode(file.data(), file.size(), from, to, points);
+        }
+    }
+    if (!active.empty())
+    {
+        decode((const unsigned char*)active.data(), active.size(), from, to, points);
+    }
+}
+
+vector<HistorySeries> TimeSeriesStore::series() const
+{
+    vector<pair<string, shared_ptr<Series> > > all;
+    {
+        lock_guard<mutex> lock(mutex_);
+        all.assign(series_.begin(), series_.end());
+    }
+    vector<HistorySeries> list;
+    for (size_t s = 0; s < all.size(); s++)
+    {
+        Series& stored = *all[s].second;
+        lock_guard<mutex> lock(stored.mutex);
+        HistorySeries series;
+        series.key = all[s].first;
+        series.points = 0;
+        series.bytes = 0;
+        series.segments = stored.segments.size();
+        series.firstTime = 0;
+        series.lastTime = 0;
+        for (size_t i = 0; i < stored.segments.size(); i++)
+        {
+            const Segment& segment = stored.segments[i];
+            if (segment.count > 0)
+            {
+                series.firstTime = series.points == 0 ? segment.firstTime : series.firstTime;
+                series.lastTime = segment.lastTime;
+            }
+            series.points += segment.count;
+            series.bytes += segment.bytes;
+        }
+        list.push_back(series);
+    }
+    return list;
+}
+
+void TimeSeriesStore::recordLevels(const string& ipAddress, long long time, const vector<SlotLevel>& levels)
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (directory_.empty())
+        {
+            return;
+        }
+    }
+    if (pending_.fetch_add(1) >= MAX_PENDING)
+    {
+        pending_--;
+        return;
+    }
+    // Gli id sono viste sul documento della cache: le chiavi vanno costruite qui
+    vector<pair<string, double> > samples;
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        string prefix = ipAddress + "/" + string(levels[i].id) + "/";
+        if (levels[i].levelPercent >= 0)
+        {
+            samples.push_back(make_pair(prefix + "level", (double)levels[i].levelPercent));
+        }
+        samples.push_back(make_pair(prefix + "state", (double)levels[i].state));
+    }
+    writer_.post([this, time, samples]()
+    {
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            append(samples[i].first, time, samples[i].second);
+        }
+        pending_--;
+    });
+}
+
+string TimeSeriesStore::toXml(const string& key, const vector<HistoryPoint>& points)
+{
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<History key=\"";
+    appendXmlEscaped(xml, key);
+    xml += "\">\n";
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        xml += "<Point time=\"";
+        xml += to_string(points[i].time);
+        xml += "\" value=\"";
+        appendDouble(xml, points[i].value);
+        xml += "\"/>\n";
+    }
+    xml += "</History>\n";
+    return xml;
+}
+
+string TimeSeriesStore::toXml(const vector<HistorySeries>& series)
+{
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<HistorySeries>\n";
+    for (size_t i = 0; i < series.size(); i++)
+    {
+        xml += "<Series key=\"";
+        appendXmlEscaped(xml, series[i].key);
+        xml += "\" points=\"";
+        xml += to_string(series[i].points);
+        xml += "\" segments=\"";
+        xml += to_string((unsigned long long)series[i].segments);
+        xml += "\" bytes=\"";
+        xml += to_string(series[i].bytes);
+        xml += "\" from=\"";
+        xml += to_string(series[i].firstTime);
+        xml += "\" to=\"";
+        xml += to_string(series[i].lastTime);
+        xml += "\"/>\n";
+    }
+    xml += "</HistorySeries>\n";
+    return xml;
+}
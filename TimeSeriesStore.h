@@ -0,0 +1,115 @@
+#ifndef TIME_SERIES_STORE_H
+#define TIME_SERIES_STORE_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "StatusModel.h"
+#include "ThreadPool.h"
+
+struct HistoryPoint
+{
+    long long time;         // millisecondi dal 1970
+    double value;
+};
+
+struct HistorySeries
+{
+    std::string key;        // "ip/slot/metrica"
+    unsigned long long points;
+    unsigned long long bytes;   // spazio su disco dei segmenti
+    size_t segments;
+    long long firstTime;
+    long long lastTime;
+};
+
+// Storico dei consumabili: serie temporali append-only, una per stampante,
+// slot e metrica ("192.168.1.10/InkSlot0/level"), alimentate dalla cache di
+// stato a ogni nuova lettura o evento di inchiostri, testine e manutenzione.
+// Le scritture avvengono su un thread dello storico, non in quello dell'SDK
+// che consegna l'evento; con il thread in ritardo di MAX_PENDING letture le
+// nuove vengono scartate.
+//
+// Ogni serie e' una sequenza di segmenti, file mappati in memoria con un
+// header (intervallo di tempo, numero di punti, stato del codificatore) e i
+// punti compressi come in Gorilla (Facebook, VLDB 2015): tempi come differenza
+// tra intervalli successivi, valori come XOR con il precedente. Un livello che
+// non cambia costa un bit oltre al tempo. I segmenti nascono piccoli e
+// raddoppiano fino a MAX_SEGMENT_SIZE; le query leggono solo i segmenti il cui
+// intervallo interseca quello richiesto e li decodificano fuori dai lock.
+// I segmenti piu' vecchi della ritenzione vengono cancellati quando la serie
+// ne apre uno nuovo e al caricamento della cartella.
+class TimeSeriesStore
+{
+public:
+    enum { MIN_SEGMENT_SIZE = 4096, MAX_SEGMENT_SIZE = 64 * 1024, MAX_PENDING = 1024, DEFAULT_RETENTION_DAYS = 90 };
+
+    // Istanza alimentata da StatusCache; come FleetPoller non viene mai distrutta.
+    static TimeSeriesStore& instance();
+
+    // Cartella dei segmenti (creata alla prima scrittura); stringa vuota per
+    // non registrare nulla. Le serie vengono ricaricate dalla nuova cartella.
+    // Predefinita: HPSDK_HISTORY_DIR; senza variabile lo storico e' disattivato.
+    void setDirectory(const std::string& directory);
+
+    // Eta' oltre la quale i segmenti vengono cancellati (0 = mai).
+    // Predefinita: HPSDK_HISTORY_RETENTION_DAYS giorni o DEFAULT_RETENTION_DAYS.
+    void setRetention(std::chrono::hours retention);
+
+    // Aggiunge un punto; un tempo precedente all'ultimo della serie viene portato a quello.
+    bool append(const std::string& key, long long time, double value);
+    // Punti della serie con from <= time <= to, in ordine di tempo.
+    void query(const std::string& key, long long from, long long to, std::vector<HistoryPoint>& points);
+    std::vector<HistorySeries> series() const;
+
+    // Livello ("level", se disponibile) e stato ("state") di ogni slot al tempo
+    // indicato, scritti dal thread dello storico.
+    void recordLevels(const std::string& ipAddress, long long time, const std::vector<SlotLevel>& levels);
+
+    static std::string toXml(const std::string& key, const std::vector<HistoryPoint>& points);
+    static std::string toXml(const std::vector<HistorySeries>& series);
+
+private:
+    struct Segment
+    {
+        std::string path;
+        uint32_t sequence;
+        uint32_t count;
+        long long firstTime;
+        long long lastTime;
+        unsigned long long bytes;
+    };
+
+    // I segmenti sono protetti da mutex della serie: mutex_ dello store serve
+    // solo a trovare la serie.
+    struct Series
+    {
+        std::mutex mutex;
+        std::vector<Segment> segments;      // in ordine di tempo; l'ultimo riceve i punti
+        MappedFile active;                  // mappa dell'ultimo segmento, aperta alla prima scrittura
+    };
+
+    TimeSeriesStore();
+    TimeSeriesStore(const TimeSeriesStore&);
+    TimeSeriesStore& operator=(const TimeSeriesStore&);
+
+    void loadLocked();
+    bool openActiveLocked(const std::string& directory, const std::string& key, Series& series, size_t required);
+    void pruneLocked(Series& series);
+    static void decode(const unsigned char* data, size_t size, long long from, long long to, std::vector<HistoryPoint>& points);
+
+    mutable std::mutex mutex_;
+    std::string directory_;
+    std::map<std::string, std::shared_ptr<Series> > series_;
+    std::atomic<long long> retentionMs_;
+    std::atomic<size_t> pending_;           // letture in attesa del thread dello storico
+    ThreadPool writer_;
+};
+
+#endif // TIME_SERIES_STORE_H
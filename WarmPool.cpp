@@ -0,0 +1,189 @@
+#include "WarmPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include "Metrics.h"
+#include "PrinterSession.h"
+#include "XmlUtil.h"
+
+using namespace std;
+
+namespace
+{
+    // Viste lette dagli export GetCartridges/GetPrintheads/GetMaintanance
+    const StatusKind WARM_KINDS[] = { STATUS_INK_SYSTEM, STATUS_PRINTHEAD_SLOTS, STATUS_MAINTENANCE_CARTRIDGES };
+
+    HPLFPSDK::Types::Result warmPrinter(const string& ipAddress, const string& printerModel)
+    {
+        PrinterSession& session = PrinterSession::instance();
+        HPLFPSDK::Types::Result result = session.open(ipAddress.c_str(), printerModel.c_str());
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            return result;
+        }
+        PrinterSession::Lease printer;
+        result = session.acquire(ipAddress.c_str(), printerModel.c_str(), printer);
+        if (result == HPLFPSDK::Types::RESULT_OK)
+        {
+            result = session.waitReady(printer);
+        }
+        for (size_t i = 0; result == HPLFPSDK::Types::RESULT_OK && i < sizeof(WARM_KINDS) / sizeof(WARM_KINDS[0]); i++)
+        {
+            shared_ptr<const string> xml;
+            result = session.statusCache(printer).get(WARM_KINDS[i], xml);
+        }
+        // Una stampante non pronta non resta aperta: il prossimo start la riprova
+        if (result != HPLFPSDK::Types::RESULT_OK)
+        {
+            printer.release();
+            session.close(ipAddress.c_str(), printerModel.c_str());
+        }
+        return result;
+    }
+}
+
+WarmPool::WarmPool(size_t workers)
+    : pending_(0), pool_(workers)
+{
+}
+
+WarmPool& WarmPool::instance()
+{
+    static WarmPool* pool = new WarmPool(8);
+    return *pool;
+}
+
+void WarmPool::start(const vector<FleetPrinter>& printers)
+{
+    vector<size_t> queued;
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (size_t i = 0; i < printers.size(); i++)
+        {
+            size_t known = printers_.size();
+            for (size_t j = 0; j < printers_.size() && known == printers_.size(); j++)
+            {
+                if (printers_[j].ipAddress == printers[i].ipAddress && printers_[j].printerModel == printers[i].printerModel)
+                {
+                    known = j;
+                }
+            }
+            if (known < printers_.size())
+            {
+                // Gia' pronta o in preparazione: si riprova solo chi e' fallito
+                WarmResult& printer = printers_[known];
+                if (!printer.done || printer.result == HPLFPSDK::Types::RESULT_OK)
+                {
+                    continue;
+                }
+                printer.done = false;
+                printer.result = HPLFPSDK::Types::RESULT_OK;
+                printer.elapsed = chrono::milliseconds(0);
+                queued.push_back(known);
+                pending_++;
+                continue;
+            }
+            WarmResult printer;
+            printer.ipAddress = printers[i].ipAddress;
+            printer.printerModel = printers[i].printerModel;
+            printer.done = false;
+            printer.result = HPLFPSDK::Types::RESULT_OK;
+            printer.elapsed = chrono::milliseconds(0);
+            printers_.push_back(printer);
+            queued.push_back(printers_.size() - 1);
+            pending_++;
+        }
+    }
+    for (size_t i = 0; i < queued.size(); i++)
+    {
+        size_t index = queued[i];
+        pool_.post([this, index]() { warm(index); });
+    }
+}
+
+void WarmPool::startFromEnvironment()
+{
+    const char* list = getenv("HPSDK_WARM_PRINTERS");
+    if (list != NULL && *list != '\0')
+    {
+        string lines(list);
+        replace(lines.begin(), lines.end(), ',', '\n');
+        instance().start(FleetPoller::parsePrinterList(lines.c_str()));
+    }
+}
+
+bool WarmPool::ready() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return pending_ == 0;
+}
+
+bool WarmPool::wait(chrono::milliseconds timeout)
+{
+    unique_lock<mutex> lock(mutex_);
+    return changed_.wait_for(lock, timeout, [this] { return pending_ == 0; });
+}
+
+vector<WarmResult> WarmPool::results() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return printers_;
+}
+
+void WarmPool::warm(size_t index)
+{
+    string ipAddress;
+    string printerModel;
+    {
+        lock_guard<mutex> lock(mutex_);
+        ipAddress = printers_[index].ipAddress;
+        printerModel = printers_[index].printerModel;
+    }
+
+    MetricTimer timer(METRIC_PHASE_WARM_UP);
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    HPLFPSDK::Types::Result result = HPLFPSDK::Types::RESULT_ERROR;
+    try
+    {
+        result = warmPrinter(ipAddress, printerModel);
+    }
+    catch (exception)
+    {
+    }
+    timer.stop(result);
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        WarmResult& printer = printers_[index];
+        printer.done = true;
+        printer.result = result;
+        printer.elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        pending_--;
+    }
+    changed_.notify_all();
+}
+
+string WarmPool::toXml(const vector<WarmResult>& results, bool ready)
+{
+    string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<WarmPool ready=\"";
+    xml += ready ? "true" : "false";
+    xml += "\">\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const WarmResult& result = results[i];
+        xml += "<Printer ip=\"";
+        appendXmlEscaped(xml, result.ipAddress);
+        xml += "\" model=\"";
+        appendXmlEscaped(xml, result.printerModel);
+        if (result.done)
+        {
+            xml += "\" result=\"";
+            xml += to_string((unsigned int)result.result);
+            xml += "\" elapsedMs=\"";
+            xml += to_string((long long)result.elapsed.count());
+        }
+        xml += "\"/>\n";
+    }
+    xml += "</WarmPool>\n";
+    return xml;
+}
@@ -0,0 +1,63 @@
+#ifndef WARM_POOL_H
+#define WARM_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "FleetPoller.h"
+#include "IHplfpsdk.h"
+#include "ThreadPool.h"
+
+struct WarmResult
+{
+    std::string ipAddress;
+    std::string printerModel;
+    bool done;
+    HPLFPSDK::Types::Result result;
+    std::chrono::milliseconds elapsed;
+};
+
+// Preparazione delle stampanti all'avvio, in parallelo su un pool di thread:
+// per ognuna hplfpsdk_getNewPrinter (aperta come con OpenPrinter, quindi mai
+// scartata per inattivita'), attesa di "Not initialized" e prima lettura di
+// inchiostri, testine e manutenzione, che sottoscrive la cache agli eventi.
+// Quando tutte sono pronte (o in errore) il pool e' pronto e la prima
+// richiesta di stato costa quanto le successive.
+class WarmPool
+{
+public:
+    explicit WarmPool(size_t workers);
+
+    // Istanza degli export; come FleetPoller non viene mai distrutta.
+    static WarmPool& instance();
+
+    // Accoda le stampanti non ancora presenti nel pool e di nuovo quelle la cui
+    // preparazione e' fallita.
+    void start(const std::vector<FleetPrinter>& printers);
+    // Stampanti della variabile d'ambiente HPSDK_WARM_PRINTERS, righe
+    // "ip;modello" separate da a capo o da ','. Senza variabile non crea il pool.
+    static void startFromEnvironment();
+
+    // true se tutte le stampanti accodate sono state preparate.
+    bool ready() const;
+    bool wait(std::chrono::milliseconds timeout);
+    std::vector<WarmResult> results() const;
+
+    static std::string toXml(const std::vector<WarmResult>& results, bool ready);
+
+private:
+    WarmPool(const WarmPool&);
+    WarmPool& operator=(const WarmPool&);
+
+    void warm(size_t index);
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<WarmResult> printers_;
+    size_t pending_;
+    ThreadPool pool_;
+};
+
+#endif // WARM_POOL_H
@@ -0,0 +1,414 @@
+#include "XmlPullParser.h"
+
+#include <cstring>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+    // Spazi XML e caratteri di controllo: un solo confronto per carattere
+    bool isSpace(char c)
+    {
+        return (unsigned char)c <= ' ';
+    }
+
+    string_view trim(const char* begin, const char* end)
+    {
+        while (begin < end && isSpace(*begin))
+        {
+            ++begin;
+        }
+        while (end > begin && isSpace(end[-1]))
+        {
+            --end;
+        }
+        return string_view(begin, end - begin);
+    }
+
+    // Posizione di token in [p, end), oppure NULL.
+    const char* find(const char* p, const char* end, string_view token)
+    {
+        size_t position = string_view(p, end - p).find(token);
+        return position == string_view::npos ? NULL : p + position;
+    }
+
+    // '>' che chiude il tag, ignorando quelli tra virgolette nei valori degli
+    // attributi, oppure NULL. Il caso comune <Nome> non entra nel ciclo.
+    const char* tagEnd(const char* p, const char* end)
+    {
+        char quote = 0;
+        while (p < end && (quote != 0 || *p != '>'))
+        {
+            if (quote != 0)
+            {
+                quote = *p == quote ? 0 : quote;
+            }
+            else if (*p == '"' || *p == '\'')
+            {
+                quote = *p;
+            }
+            ++p;
+        }
+        return p < end ? p : NULL;
+    }
+}
+
+XmlPullParser::XmlPullParser(const char* xml, size_t length)
+    : p_(xml), end_(xml + length), depth_(0), pendingEnd_(false), closed_(false)
+{
+    while (end_ > p_ && end_[-1] == '\0')
+    {
+        --end_;
+    }
+}
+
+XmlPullParser::Event XmlPullParser::next()
+{
+    if (closed_)
+    {
+        --depth_;
+        closed_ = false;
+    }
+    if (pendingEnd_)
+    {
+        pendingEnd_ = false;
+        closed_ = true;
+        return EVENT_END_ELEMENT;
+    }
+    while (p_ < end_)
+    {
+        // Indentazione tra i tag: la si salta senza cercare '<'
+        while (p_ < end_ && isSpace(*p_))
+        {
+            ++p_;
+        }
+        if (p_ == end_)
+        {
+            break;
+        }
+        if (*p_ == '<')
+        {
+            Event event = readTag();
+            if (event != EVENT_END_DOCUMENT)
+            {
+                return event;
+            }
+            continue;
+        }
+        const char* begin = p_;
+        const char* tag = (const char*)memchr(p_, '<', end_ - p_);
+        p_ = tag == NULL ? end_ : tag;
+        text_ = trim(begin, p_);
+        return EVENT_TEXT;
+    }
+    return depth_ == 0 ? EVENT_END_DOCUMENT : EVENT_ERROR;
+}
+
+// p_ e' su '<'. EVENT_END_DOCUMENT indica un costrutto da saltare
+// (dichiarazione, commento, DOCTYPE): next() prosegue con quello successivo.
+XmlPullParser::Event XmlPullParser::readTag()
+{
+    const char* tag = p_;
+    const char second = end_ - tag >= 2 ? tag[1] : '\0';
+    if (second == '?')
+    {
+        const char* close = find(tag, end_, "?>");
+        p_ = close == NULL ? end_ : close + 2;
+        return close == NULL ? EVENT_ERROR : EVENT_END_DOCUMENT;
+    }
+    if (second == '!')
+    {
+        if (end_ - tag >= 4 && memcmp(tag, "<!--", 4) == 0)
+        {
+            const char* close = find(tag + 4, end_, "-->");
+            p_ = close == NULL ? end_ : close + 3;
+            return close == NULL ? EVENT_ERROR : EVENT_END_DOCUMENT;
+        }
+        if (end_ - tag >= 9 && memcmp(tag, "<![CDATA[", 9) == 0)
+        {
+            const char* close = find(tag + 9, end_, "]]>");
+            if (close == NULL)
+            {
+                p_ = end_;
+                return EVENT_ERROR;
+            }
+            text_ = string_view(tag + 9, close - (tag + 9));
+            p_ = close + 3;
+            return EVENT_TEXT;
+        }
+        const char* close = (const char*)memchr(tag, '>', end_ - tag);
+        p_ = close == NULL ? end_ : close + 1;
+        return close == NULL ? EVENT_ERROR : EVENT_END_DOCUMENT;
+    }
+
+    const bool closing = second == '/';
+    const char* name = tag + (closing ? 2 : 1);
+    const char* p = name;
+    while (p < end_ && !isSpace(*p) && *p != '>' && *p != '/')
+    {
+        ++p;
+    }
+    name_ = string_view(name, p - name);
+
+    const char* attributes = p;
+    p = tagEnd(p, end_);
+    if (p == NULL || name_.empty())
+    {
+        p_ = end_;
+        return EVENT_ERROR;
+    }
+    p_ = p + 1;
+
+    if (closing)
+    {
+        if (depth_ == 0)
+        {
+            return EVENT_ERROR;
+        }
+        closed_ = true;
+        return EVENT_END_ELEMENT;
+    }
+    bool empty = p[-1] == '/';
+    attributes_ = string_view(attributes, (empty ? p - 1 : p) - attributes);
+    ++depth_;
+    pendingEnd_ = empty;
+    return EVENT_START_ELEMENT;
+}
+
+bool XmlPullParser::attribute(string_view name, string_view& value) const
+{
+    return xmlAttribute(attributes_, name, value);
+}
+
+bool XmlPullParser::skipElement(string_view* body)
+{
+    const char* begin = p_;
+    const int depth = depth_;
+    if (!pendingEnd_)
+    {
+        // Salta il contenuto guardando solo i '<': conta gli elementi omonimi
+        // annidati (non quelli vuoti, <X/>) e ripiega sull'analisi completa se
+        // incontra commenti o CDATA.
+        const size_t size = name_.size();
+        int nested = 0;
+        const char* p = begin;
+        while ((p = (const char*)memchr(p, '<', end_ - p)) != NULL && end_ - p > (ptrdiff_t)size + 2)
+        {
+            const bool closing = p[1] == '/';
+            const char* name = p + (closing ? 2 : 1);
+            if (p[1] == '!')
+            {
+                break;
+            }
+            if (memcmp(name, name_.data(), size) == 0 && (name[size] == '>' || isSpace(name[size]) || (!closing && name[size] == '/')))
+            {
+                const char* close = tagEnd(name + size, end_);
+                if (close == NULL)
+                {
+                    break;
+                }
+                if (!closing)
+                {
+                    nested += close[-1] == '/' ? 0 : 1;
+                }
+                else if (nested-- == 0)
+                {
+                    if (body != NULL)
+                    {
+                        *body = string_view(begin, p - begin);
+                    }
+                    p_ = close + 1;
+                    closed_ = true;
+                    return true;
+                }
+                p = close;
+            }
+            ++p;
+        }
+    }
+    for (;;)
+    {
+        // Inizio del prossimo tag: se e' la chiusura cercata il contenuto termina li'
+        const char* tag = p_;
+        Event event = next();
+        if (event == EVENT_END_ELEMENT && depth_ == depth)
+        {
+            if (body != NULL)
+            {
+                *body = tag == begin ? string_view(begin, 0) : string_view(begin, tag - begin);
+            }
+            return true;
+        }
+        if (event == EVENT_END_DOCUMENT || event == EVENT_ERROR)
+        {
+            if (body != NULL)
+            {
+                *body = string_view(begin, end_ - begin);
+            }
+            return false;
+        }
+    }
+}
+
+bool xmlAttribute(string_view attributes, string_view name, string_view& value)
+{
+    string_view attributeName;
+    string_view attributeValue;
+    while (xmlNextAttribute(attributes, attributeName, attributeValue))
+    {
+        if (attributeName == name)
+        {
+            value = attributeValue;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool xmlNextAttribute(string_view& attributes, string_view& name, string_view& value)
+{
+    size_t i = 0;
+    const size_t size = attributes.size();
+    while (i < size && isSpace(attributes[i]))
+    {
+        ++i;
+    }
+    size_t nameBegin = i;
+    while (i < size && attributes[i] != '=' && !isSpace(attributes[i]))
+    {
+        ++i;
+    }
+    size_t nameEnd = i;
+    while (i < size && (isSpace(attributes[i]) || attributes[i] == '='))
+    {
+        ++i;
+    }
+    if (nameEnd == nameBegin || i >= size || (attributes[i] != '"' && attributes[i] != '\''))
+    {
+        attributes = string_view();
+        return false;
+    }
+    char quote = attributes[i++];
+    size_t valueBegin = i;
+    while (i < size && attributes[i] != quote)
+    {
+        ++i;
+    }
+    name = attributes.substr(nameBegin, nameEnd - nameBegin);
+    value = attributes.substr(valueBegin, i - valueBegin);
+    attributes = attributes.substr(i < size ? i + 1 : size);
+    return true;
+}
+
+string_view XmlElement::text(string_view path) const
+{
+    string_view value;
+    texts(&path, &value, 1);
+    return value;
+}
+
+size_t XmlElement::texts(const string_view* paths, string_view* values, size_t count) const
+{
+    if (count > MAX_TEXTS)
+    {
+        count = MAX_TEXTS;
+    }
+    // Spazio per i percorsi senza inizializzarne MAX_TEXTS ad ogni chiamata
+    alignas(XmlPath) unsigned char storage[MAX_TEXTS * sizeof(XmlPath)];
+    XmlPath* matchers = (XmlPath*)storage;
+    // Profondita' dell'elemento trovato di cui si attende il testo; -1 se gia' letto
+    int open[MAX_TEXTS];
+    for (size_t i = 0; i < count; i++)
+    {
+        new (&matchers[i]) XmlPath(paths[i]);
+        values[i] = string_view();
+        open[i] = 0;
+    }
+
+    size_t found = 0;
+    XmlPullParser parser(body_.data(), body_.size());
+    while (found < count)
+    {
+        XmlPullParser::Event event = parser.next();
+        if (event == XmlPullParser::EVENT_START_ELEMENT)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (matchers[i].enter(parser.depth(), parser.name()) && open[i] == 0)
+                {
+                    open[i] = parser.depth();
+                }
+            }
+        }
+        else if (event == XmlPullParser::EVENT_TEXT)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (open[i] > 0)
+                {
+                    values[i] = parser.text();
+                    open[i] = -1;
+                    found++;
+                }
+            }
+        }
+        else if (event == XmlPullParser::EVENT_END_ELEMENT)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (open[i] == parser.depth())
+                {
+                    // Elemento senza testo: si cerca la corrispondenza successiva
+                    open[i] = 0;
+                }
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+    return found;
+}
+
+XmlPath::XmlPath(string_view path)
+    : count_(0)
+{
+    matched_[0] = 0;
+    size_t begin = 0;
+    while (begin <= path.size())
+    {
+        size_t end = path.find('/', begin);
+        if (end == string_view::npos)
+        {
+            end = path.size();
+        }
+        if (end > begin)
+        {
+            if (count_ == MAX_SEGMENTS)
+            {
+                // Percorso troppo lungo: non corrisponde a nulla
+                count_ = 0;
+                return;
+            }
+            segments_[count_++] = path.substr(begin, end - begin);
+        }
+        begin = end + 1;
+    }
+}
+
+bool XmlPath::enter(int depth, string_view name)
+{
+    if (count_ == 0 || depth <= 0 || depth > MAX_DEPTH)
+    {
+        return false;
+    }
+    int matched = matched_[depth - 1];
+    if (matched < count_ && segments_[matched] == name)
+    {
+        ++matched;
+    }
+    matched_[depth] = (unsigned char)matched;
+    return matched == count_ && matched_[depth - 1] == count_ - 1;
+}
@@ -0,0 +1,150 @@
+#ifndef XML_PULL_PARSER_H
+#define XML_PULL_PARSER_H
+
+#include <stddef.h>
+#include <string_view>
+
+// Parser XML "pull" che lavora direttamente sul buffer restituito dall'SDK:
+// nomi, attributi e testi sono string_view sul buffer, nessuna allocazione.
+// Il buffer deve restare valido finche' si usano le viste.
+//
+// Copre l'XML prodotto dalla stampante: salta dichiarazione, commenti e DOCTYPE,
+// restituisce le sezioni CDATA come testo e non decodifica le entita'.
+// Gli zeri finali che l'SDK lascia in fondo al buffer vengono ignorati.
+class XmlPullParser
+{
+public:
+    enum Event
+    {
+        EVENT_START_ELEMENT,
+        EVENT_END_ELEMENT,
+        EVENT_TEXT,
+        EVENT_END_DOCUMENT,
+        EVENT_ERROR
+    };
+
+    XmlPullParser(const char* xml, size_t length);
+
+    Event next();
+
+    // Nome dell'elemento (START/END) e testo senza spazi iniziali e finali (TEXT).
+    // I testi di soli spazi non generano eventi.
+    std::string_view name() const { return name_; }
+    std::string_view text() const { return text_; }
+
+    // Attributi grezzi dell'ultimo START_ELEMENT e ricerca di uno di essi.
+    std::string_view attributes() const { return attributes_; }
+    bool attribute(std::string_view name, std::string_view& value) const;
+
+    // Profondita' dell'elemento aperto o chiuso dall'ultimo evento: 1 per la radice.
+    int depth() const { return depth_; }
+
+    // Dopo uno START_ELEMENT consuma il contenuto fino all'END_ELEMENT
+    // corrispondente; body riceve quanto compreso tra i due tag.
+    // false se il documento finisce prima o non e' valido.
+    bool skipElement(std::string_view* body = NULL);
+
+private:
+    Event readTag();
+
+    const char* p_;
+    const char* end_;
+    std::string_view name_;
+    std::string_view text_;
+    std::string_view attributes_;
+    int depth_;
+    bool pendingEnd_;   // elemento <x/>: il prossimo evento e' la sua chiusura
+    bool closed_;       // l'ultimo evento e' END_ELEMENT
+};
+
+// Valore dell'attributo name in una lista grezza di attributi (name="..." o name='...').
+bool xmlAttribute(std::string_view attributes, std::string_view name, std::string_view& value);
+
+// Legge il primo attributo della lista e lo toglie da attributes; false a fine lista.
+bool xmlNextAttribute(std::string_view& attributes, std::string_view& name, std::string_view& value);
+
+// Elemento trovato da xmlSelect: nome, attributi e contenuto sono viste sul buffer.
+class XmlElement
+{
+public:
+    XmlElement(std::string_view name, std::string_view attributes, std::string_view body)
+        : name_(name), attributes_(attributes), body_(body)
+    {
+    }
+
+    std::string_view name() const { return name_; }
+    std::string_view body() const { return body_; }
+
+    bool attribute(std::string_view name, std::string_view& value) const { return xmlAttribute(attributes_, name, value); }
+
+    // Primo testo del primo discendente che corrisponde a path (vedi XmlPath);
+    // vista vuota se non c'e'.
+    std::string_view text(std::string_view path) const;
+
+    // Come text per piu' percorsi (al massimo MAX_TEXTS), con una sola lettura del
+    // contenuto: da preferire quando si estraggono piu' campi dallo stesso elemento.
+    // Restituisce il numero di percorsi trovati.
+    enum { MAX_TEXTS = 8 };
+    size_t texts(const std::string_view* paths, std::string_view* values, size_t count) const;
+
+private:
+    std::string_view name_;
+    std::string_view attributes_;
+    std::string_view body_;
+};
+
+// Percorso "A/B/C": C e' l'elemento cercato, A e B devono comparire, in
+// quest'ordine, tra i suoi antenati, non necessariamente come padri diretti.
+// Cosi' "InkSystem/InkSlot/LevelPercentage" trova il livello anche se la
+// stampante lo annida in <InkSlots> e <Overview>.
+class XmlPath
+{
+public:
+    enum { MAX_SEGMENTS = 8, MAX_DEPTH = 64 };
+
+    explicit XmlPath(std::string_view path);
+
+    // Da chiamare per ogni START_ELEMENT: true se l'elemento corrisponde al percorso.
+    bool enter(int depth, std::string_view name);
+
+private:
+    std::string_view segments_[MAX_SEGMENTS];
+    int count_;
+    // matched_[d]: segmenti trovati tra gli elementi aperti fino alla profondita' d
+    unsigned char matched_[MAX_DEPTH + 1];
+};
+
+// Chiama visit(const XmlElement&) per ogni elemento che corrisponde a path.
+// Il contenuto di un elemento trovato non viene esaminato oltre: per i figli si
+// usano XmlElement::text o un xmlSelect sul body. visit restituisce false per
+// interrompere la ricerca. Restituisce il numero di elementi visitati.
+template <typename Visitor>
+size_t xmlSelect(const char* xml, size_t length, std::string_view path, Visitor visit)
+{
+    XmlPullParser parser(xml, length);
+    XmlPath matcher(path);
+    size_t visited = 0;
+    for (;;)
+    {
+        XmlPullParser::Event event = parser.next();
+        if (event == XmlPullParser::EVENT_END_DOCUMENT || event == XmlPullParser::EVENT_ERROR)
+        {
+            return visited;
+        }
+        if (event != XmlPullParser::EVENT_START_ELEMENT || !matcher.enter(parser.depth(), parser.name()))
+        {
+            continue;
+        }
+        std::string_view name = parser.name();
+        std::string_view attributes = parser.attributes();
+        std::string_view body;
+        bool closed = parser.skipElement(&body);
+        visited++;
+        if (!visit(XmlElement(name, attributes, body)) || !closed)
+        {
+            return visited;
+        }
+    }
+}
+
+#endif // XML_PULL_PARSER_H
@@ -0,0 +1,121 @@
+#include "XmlUtil.h"
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+void appendXmlBody(string& out, const char* xml, size_t length)
+{
+    const char* begin = xml;
+    const char* end = xml + length;
+    while (end > begin && end[-1] == '\0')
+    {
+        --end;
+    }
+    if (end - begin > 5 && strncmp(begin, "<?xml", 5) == 0)
+    {
+        const char* close = strstr(begin, "?>");
+        if (close != NULL && close < end)
+        {
+            begin = close + 2;
+        }
+    }
+    out.append(begin, end);
+}
+
+void appendXmlEscaped(string& out, const string& text)
+{
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        switch (text[i])
+        {
+        case '&':  out += "&amp;";  break;
+        case '<':  out += "&lt;";   break;
+        case '>':  out += "&gt;";   break;
+        case '"':  out += "&quot;"; break;
+        case '\'': out += "&apos;"; break;
+        default:   out += text[i];  break;
+        }
+    }
+}
+
+namespace
+{
+    void appendUtf8(string& out, unsigned long code)
+    {
+        if (code < 0x80)
+        {
+            out += (char)code;
+        }
+        else if (code < 0x800)
+        {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xF0 | (code >> 18));
+            out += (char)(0x80 | ((code >> 12) & 0x3F));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    // Carattere dell'entita' name (senza '&' e ';'); false se non e' riconosciuta
+    bool decodeEntity(string_view name, string& out)
+    {
+        if (name == "amp")  { out += '&';  return true; }
+        if (name == "lt")   { out += '<';  return true; }
+        if (name == "gt")   { out += '>';  return true; }
+        if (name == "quot") { out += '"';  return true; }
+        if (name == "apos") { out += '\''; return true; }
+        if (name.size() < 2 || name[0] != '#')
+        {
+            return false;
+        }
+        bool hex = name[1] == 'x' || name[1] == 'X';
+        string digits(name.substr(hex ? 2 : 1));
+        if (digits.empty() || digits.size() > 8)
+        {
+            return false;
+        }
+        char* end = NULL;
+        unsigned long code = strtoul(digits.c_str(), &end, hex ? 16 : 10);
+        if (*end != '\0' || code == 0 || code > 0x10FFFF)
+        {
+            return false;
+        }
+        appendUtf8(out, code);
+        return true;
+    }
+}
+
+void appendXmlDecoded(string& out, string_view text)
+{
+    size_t i = 0;
+    while (i < text.size())
+    {
+        size_t amp = text.find('&', i);
+        if (amp == string_view::npos)
+        {
+            break;
+        }
+        out.append(text.data() + i, amp - i);
+        size_t semicolon = text.find(';', amp + 1);
+        if (semicolon == string_view::npos || semicolon - amp > 12 || !decodeEntity(text.substr(amp + 1, semicolon - amp - 1), out))
+        {
+            out += '&';
+            i = amp + 1;
+            continue;
+        }
+        i = semicolon + 1;
+    }
+    out.append(text.data() + i, text.size() - i);
+}
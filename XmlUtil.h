@@ -0,0 +1,19 @@
+#ifndef XML_UTIL_H
+#define XML_UTIL_H
+
+#include <string>
+#include <string_view>
+
+// Aggiunge a out un documento XML dell'SDK senza la dichiarazione <?xml ...?>,
+// per poterlo annidare in un documento del wrapper.
+void appendXmlBody(std::string& out, const char* xml, size_t length);
+
+// Aggiunge a out il testo con i caratteri speciali XML sostituiti dalle entita'.
+void appendXmlEscaped(std::string& out, const std::string& text);
+
+// Aggiunge a out il testo (o il valore di un attributo) di un documento con le
+// entita' predefinite e i riferimenti numerici decodificati. Le entita' che non
+// riconosce restano come sono.
+void appendXmlDecoded(std::string& out, std::string_view text);
+
+#endif // XML_UTIL_H